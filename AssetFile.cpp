@@ -1,8 +1,18 @@
+#include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define ASSET_FILE_USE_SSE2
+#endif
 
 #include "AssetFile.hpp"
+#include "AssetFileCompression.hpp"
 #include "ResourceUtilities.hpp"
 
 #define make_fourcc( _a, _b, _c, _d ) \
@@ -10,20 +20,53 @@
         
 
 static const u32 ASSET_FILE_MAGIC = make_fourcc( 'M', 'e', 'r', 'c' );
+static const u32 ASSET_FILE_VERSION = 11;   /* hashed sound pairs           */
+
+#define ASSET_FILE_ALIGNMENT        ( 16 )
+                                    /* asset/model element alignment*/
+#define ASSET_FILE_WRITE_FLUSH_SZ   ( 32 * 1024 * 1024 )
+                                    /* staged bytes before flushing */
+#define ASSET_FILE_WRITE_BUFFER_MAX_SZ \
+                                    ( 512 * 1024 * 1024 )
+                                    /* force a flush mid-asset      */
+#define ASSET_FILE_LOAD_MAX_GAP_SZ  ( 64 * 1024 )
+                                    /* unwanted bytes read through  */
+#define ASSET_FILE_LOAD_MAX_READ_SZ ( 16 * 1024 * 1024 )
+                                    /* largest coalesced load read  */
+#define ASSET_FILE_TERRAIN_TILE_RAW ( 0 )
+                                    /* samples stored as-is         */
+#define ASSET_FILE_TERRAIN_TILE_PREDICTED \
+                                    ( 1 )
+                                    /* compress_terrain() stream    */
+#define ASSET_FILE_TERRAIN_SAMPLES_OFFSET \
+                        ( ( ASSET_FILE_TERRAIN_MINMAX_CNT * sizeof( AssetFileTerrainMinMax ) + ASSET_FILE_ALIGNMENT - 1 ) & ~(u64)( ASSET_FILE_ALIGNMENT - 1 ) )
+                                    /* tile samples follow min/max  */
 
 typedef struct
     {
     u32                 magic;      /* magic sentinel number        */
+    u32                 version;    /* layout version of the file   */
     u32                 table_cnt;  /* number entries in table      */
+    u32                 reserved;   /* keeps the table 8-byte aligned*/
     } AssetFileHeader;
 
-typedef struct
+typedef struct _AssetFileTableRow
     {
     AssetFileAssetId    id;         /* asset ID hash                */
     AssetFileAssetKind  kind;       /* type of asset                */
-    u32                 starts_at;  /* file offset to start of asset*/
+    u64                 starts_at;  /* file offset to start of asset*/
+    u64                 stored_sz;  /* byte size in the file        */
+    u64                 raw_sz;     /* byte size once decompressed  */
+    AssetFileCodec      codec;      /* how the asset is compressed  */
+    u32                 reserved;   /* explicit tail padding        */
     } AssetFileTableRow;
 
+typedef struct _AssetFileTableKey
+    {
+    AssetFileAssetId    id;         /* asset ID hash                */
+    u32                 row;        /* index of row in asset table  */
+    } AssetFileTableKey;
+
 typedef struct
     {
     u8                  oversample_x;
@@ -36,10 +79,10 @@ typedef struct
                                     /* texture extent height        */
     u16                 glyph_cnt;  /* number glyphs in font        */
     u32                 texture_sz; /* texture data byte count      */
-    u32                 glyphs_starts_at;
-                                    /* file offset to glyph data    */
-    u32                 texture_starts_at;
-                                    /* file offset to texture data  */
+    u64                 glyphs_starts_at;
+                                    /* asset offset to glyph data   */
+    u64                 texture_starts_at;
+                                    /* asset offset to texture data */
     } FontHeader;
 
 typedef struct
@@ -68,6 +111,9 @@ typedef struct
                                     /* number of vertices in model  */
     u32                 total_index_count;
                                     /* number of indices in model   */
+    u32                 meshlets_cnt;
+                                    /* meshlet elements, one per    */
+                                    /*  mesh or none                */
     } ModelHeader;
 
 typedef struct
@@ -81,21 +127,46 @@ typedef struct
     u32                 vertex_cnt; /* number of vertices           */
     u32                 index_cnt;  /* number of indices            */
     u32                 material;   /* material element index       */
+    u32                 index_format;
+                                    /* AssetFileModelIndexFormat    */
+    u32                 vertex_format;
+                                    /* AssetFileModelVertexFormat   */
+    f32                 position_offset[ 3 ];
+                                    /* dequantized position is      */
+    f32                 position_scale[ 3 ];
+                                    /*  offset + stored * scale     */
+    AssetFileModelBounds
+                        bounds;     /* vertex positions             */
+    u32                 lod_cnt;    /* coarser levels of detail     */
+    u32                 lod_index_cnt;
+                                    /* indices after the full detail*/
+    AssetFileModelMeshLod
+                        lods[ ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT ];
     } ModelMeshHeader;
 
+typedef struct
+    {
+    u32                 meshlet_cnt;/* number of meshlets           */
+    u32                 vertex_cnt; /* length of the vertex list    */
+    u32                 triangle_cnt;
+                                    /* length of the triangle list  */
+    } ModelMeshletsHeader;
+
 typedef struct
     {
     u32                 node_count; /* number of child nodes        */
     u32                 mesh_count; /* number of child meshes       */
     f32                 transform[ 16 ];
                                     /* row major 4x4 matrix         */
+    AssetFileModelBounds
+                        bounds;     /* subtree, before transform    */
     } ModelNodeHeader;
 
 typedef struct
     {
     AssetFileModelElementKind
                         kind;       /* model element kind           */
-    u32                 starts_at;  /* file offset to element start */
+    u64                 starts_at;  /* asset offset to element start*/
     } ModelTableRow;
 
 typedef struct
@@ -103,6 +174,48 @@ typedef struct
     u32                 byte_size;  /* byte code blob size          */
     } ShaderHeader;
 
+typedef struct
+    {
+    u32                 pair_cnt;   /* number of sound pairs        */
+    u32                 slot_cnt;   /* hash slots, a power of two,  */
+    } SoundPairsHeader;             /*  of AssetFileSoundPair follow*/
+                                    /*  with empty slots' asset_id  */
+                                    /*  ASSET_FILE_INVALID_ASSET_ID */
+
+typedef struct
+    {
+    u64                 starts_at;  /* offset from the asset start  */
+    u32                 step;       /* samples between vertices     */
+    u32                 index_cnt;
+    } TerrainLod;
+
+typedef struct
+    {
+    u32                 sample_extent;
+                                    /* samples along a tile edge    */
+    u32                 axes_cnt;   /* tiles along a terrain edge   */
+    u32                 tile_cnt;   /* number of tiles written      */
+    u32                 lod_cnt;    /* number of LOD index patterns */
+    TerrainLod          lods[ ASSET_FILE_TERRAIN_LOD_MAX_COUNT ];
+                                    /* finest first                 */
+    } TerrainHeader;
+
+typedef struct
+    {
+    u64                 starts_at;  /* offset from the asset start  */
+                                    /*  of the min/max pyramid, then*/
+                                    /*  the samples; 0 if missing   */
+    u32                 byte_size;  /* stored samples size          */
+    u32                 codec;      /* ASSET_FILE_TERRAIN_TILE_*    */
+    } TerrainTile;                  /* directory entry, in Morton   */
+                                    /*  order of the tile x and z   */
+
+typedef struct
+    {
+    u64                 starts_at;  /* offset from the asset start  */
+    u32                 byte_size;  /* level image blob size        */
+    } TextureMip;
+
 typedef struct
     {
     u32                 channel_width;
@@ -111,6 +224,10 @@ typedef struct
     u32                 width;      /* image width                  */
     u32                 height;     /* image height                 */
     u32                 byte_size;  /* compressed image blob size   */
+    u32                 format;     /* AssetFileTextureFormat       */
+    u32                 mip_cnt;    /* number of levels written     */
+    TextureMip          mips[ ASSET_FILE_TEXTURE_MAX_MIP_CNT ];
+                                    /* level 0 directly follows     */
     } TextureHeader;
 
 typedef struct
@@ -118,11 +235,142 @@ typedef struct
     u16                 texture_cnt;/* number of textures in table  */
     } TextureExtentHeader;
 
+typedef struct
+    {
+    AssetFileLoadRequest
+                        request;    /* as submitted                 */
+    const AssetFileTableRow
+                       *row;        /* table row, or NULL if missing*/
+    } LoaderEntry;
+
+typedef struct _AssetFileLoaderQueue
+    {
+    std::mutex          mutex;      /* guards the fields below      */
+    std::condition_variable
+                        work_signal;/* requests submitted or quit   */
+    std::condition_variable
+                        done_signal;/* loader thread went idle      */
+    std::vector<LoaderEntry>
+                        pending;    /* requests not yet taken       */
+    u32                 in_flight;  /* requests taken, not finished */
+    b8                  quit;       /* stop once pending is empty   */
+    std::thread         thread;     /* loader thread                */
+    byte               *buffer;     /* coalesced read buffer        */
+    u64                 buffer_cap; /* coalesced read buffer size   */
+    } AssetFileLoaderQueue;
+
+
+static b8          AlignWriter( AssetFileWriter *output );
+static u32         BuildTableKeys( const AssetFileTableRow *rows, const u32 row_count, u32 row, const u32 key, AssetFileTableKey *keys );
+static void        CompleteLoads( const LoaderEntry *entries, const u32 entry_cnt, const u64 span_start, const u64 span_sz, AssetFileLoader *loader );
+static b8          EndAsset( AssetFileWriter *output );
+static b8          CompressAsset( AssetFileTableRow *row, AssetFileWriter *output );
+static void        ConvertModelMesh( const ModelMeshHeader *mesh, const byte *geometry, AssetFileModelMesh *out );
+static b8          CheckModelMeshLods( const ModelMeshHeader *mesh );
+static b8          ConvertModelMeshlets( const ModelMeshletsHeader *meshlets, const byte *data, const u64 data_sz, AssetFileModelMeshlets *out );
+static b8          ConvertModelNode( const ModelHeader *header, const ModelNodeHeader *node, const AssetFileModelIndex *elements, AssetFileModelNode *out );
+static void        DequantizeVertices( const AssetFileModelPackedVertex *packed, const u32 count, const f32 *offset, const f32 *scale, AssetFileModelVertex *vertices );
+static b8          FindModelElement( const AssetFileModelElementKind kind, const u32 element_index, const ModelHeader *header, AssetFileReader *input, u64 *element_start );
+static const AssetFileTableRow
+                  *FindTableRow( const AssetFileAssetId id, const AssetFilePack *pack );
+static AssetFileTableRow
+                  *FindWriterTableRow( const AssetFileAssetId id, AssetFileWriter *output );
+static u16         FloatToHalf( const f32 value );
+static b8          FlushWriter( AssetFileWriter *output );
+static u64         GetModelArenaSize( const ModelHeader *header, const u64 raw_sz, u64 *blob_offset );
+static u32         GetModelIndexSize( const u32 index_format );
+static u32         GetModelVertexSize( const u32 vertex_format );
+static u32         GetTerrainTileSlot( const u32 x, const u32 z );
+static f32         HalfToFloat( const u16 half );
+static u64         HashPayload( const byte *data, const u64 sz );
+static b8          LoadAsset( AssetFileReader *input );
+static b8          LoadTable( AssetFilePack *pack );
+static b8          MatchWrittenBytes( const u64 location, const u64 sz, const byte *bytes, AssetFileWriter *output );
+static u16         QuantizeUnorm16( const f32 value, const f32 offset, const f32 scale );
+static b8          ReadAt( const u64 location, const u64 read_sz, void *out, AssetFileReader *input );
+static b8          ReadFileAt( const u64 location, const u64 read_sz, void *out, AssetFileReader *input );
+static b8          ReadModelMeshIndexRange( const u64 mesh_start, const ModelMeshHeader *mesh, const u32 first_index, const u32 index_cnt, AssetFileModelIndex *indices, AssetFileReader *input );
+static b8          ReadWrittenAt( const u64 location, const u64 read_sz, void *out, AssetFileWriter *output );
+static void        RunLoader( AssetFileLoader *loader );
+static b8          SharePayload( AssetFileTableRow *row, const byte *stored, AssetFileWriter *output );
+static const byte *ViewAt( const u64 location, const u64 view_sz, AssetFileReader *input );
+static const byte *ViewFileAt( const u64 location, const u64 view_sz, const AssetFileReader *input );
+static b8          WriteAppend( const u64 write_sz, const void *data, AssetFileWriter *output );
+static b8          WriteAt( const u64 location, const u64 write_sz, const void *data, AssetFileWriter *output );
+static b8          WriteTerrainTileData( const u32 x, const u32 z, const AssetFileTerrainMinMax *min_max, const u32 codec, const u32 byte_size, const void *data, AssetFileWriter *output );
+
+#define read_struct_at( _location, _ptype, _input ) \
+    ReadAt( _location, sizeof( *(_ptype) ), _ptype, _input )
+
+#define write_array( _cnt, _ptype, _output ) \
+    WriteAppend( (_cnt) * sizeof( *(_ptype) ), _ptype, _output )
+
+#define write_struct( _ptype, _output ) \
+    write_array( 1, _ptype, _output )
+
+#define write_struct_at( _location, _ptype, _output ) \
+    WriteAt( _location, sizeof( *(_ptype) ), _ptype, _output )
+
+
+/*******************************************************************
+*
+*   AssetFile_AppendFromMemory()
+*
+*   DESCRIPTION:
+*       Append the assets staged by a memory writer to the output,
+*       and point the output's table rows at them.  Offsets within
+*       an asset are relative to its start, so each asset is copied
+*       as-is, or shares an identical payload already written.
+*
+*******************************************************************/
+
+b8 AssetFile_AppendFromMemory( const AssetFileWriter *blob, AssetFileWriter *output )
+{
+if( blob->hnd
+ || output->asset_start )
+    {
+    return( FALSE );
+    }
+
+for( u32 i = 0; i < blob->table_cnt; i++ )
+    {
+    const AssetFileTableRow *blob_row = &blob->table[ i ];
+    if( blob_row->kind == ASSET_FILE_ASSET_KIND_INVALID )
+        {
+        continue;
+        }
+
+    AssetFileTableRow *row = FindWriterTableRow( blob_row->id, output );
+    if( row == NULL )
+        {
+        return( FALSE );
+        }
+
+    const byte *stored = blob->buffer + ( blob_row->starts_at - blob->buffer_start );
+    row->kind      = blob_row->kind;
+    row->stored_sz = blob_row->stored_sz;
+    row->raw_sz    = blob_row->raw_sz;
+    row->codec     = blob_row->codec;
+    if( SharePayload( row, stored, output ) )
+        {
+        continue;
+        }
+
+    if( !AlignWriter( output ) )
+        {
+        return( FALSE );
+        }
+
+    row->starts_at = output->caret;
+    if( !WriteAppend( row->stored_sz, stored, output ) )
+        {
+        return( FALSE );
+        }
+    }
+
+return( EndAsset( output ) );
 
-static b8 JumpToAssetInTable( const AssetFileAssetId id, const u32 table_count, fhnd file );
-static b8 JumpToModelMaterial( const u32 asset_start, const u32 material_index, fhnd file );
-static b8 JumpToModelMesh( const u32 asset_start, const u32 mesh_index, fhnd file );
-static b8 JumpToModelNode( const u32 asset_start, const u32 node_index, fhnd file );
+} /* AssetFile_AppendFromMemory() */
 
 
 /*******************************************************************
@@ -139,35 +387,57 @@ b8 AssetFile_BeginReadingAsset( const AssetFileAssetId id, const AssetFileAssetK
 {
 input->kind        = ASSET_FILE_ASSET_KIND_INVALID;
 input->asset_start = 0;
+input->asset_row   = NULL;
+input->asset_data  = NULL;
+input->blob        = NULL;
 
-if( !JumpToAssetInTable( id, input->table_cnt, input->hnd ) )
+const AssetFileTableRow *row = FindTableRow( id, input->pack );
+if( row == NULL
+ || row->kind != kind )
     {
     return( FALSE );
     }
 
-AssetFileTableRow row = {};
-if( !file_read_struct( input->hnd, &row ) )
-    {
-    return( FALSE );
-    }
+/* compressed assets are decompressed on first access */
+input->asset_start = row->starts_at;
+input->asset_row   = row;
+input->kind        = kind;
+
+return( TRUE );
+
+} /* AssetFile_BeginReadingAsset() */
+
+
+/*******************************************************************
+*
+*   AssetFile_BeginReadingBlob()
+*
+*   DESCRIPTION:
+*       Start reading an asset from a copy of its stored bytes that
+*       is already in memory, such as one handed to a load callback.
+*       The blob must stay valid until the asset is ended.
+*
+*******************************************************************/
 
-assert( row.id == id );
-if( row.kind != kind )
+b8 AssetFile_BeginReadingBlob( const AssetFileAssetId id, const AssetFileAssetKind kind, const byte *blob, const u64 blob_sz, AssetFileReader *input )
+{
+if( !AssetFile_BeginReadingAsset( id, kind, input ) )
     {
     return( FALSE );
     }
 
-if( !file_seek( input->hnd, row.starts_at ) )
+if( blob == NULL
+ || blob_sz != input->asset_row->stored_sz )
     {
+    ensure( AssetFile_EndReadingAsset( input ) );
     return( FALSE );
     }
 
-input->asset_start = row.starts_at;
-input->kind = kind;
+input->blob = blob;
 
 return( TRUE );
 
-} /* AssetFile_BeginReadingAsset() */
+} /* AssetFile_BeginReadingBlob() */
 
 
 /*******************************************************************
@@ -185,30 +455,98 @@ b8 AssetFile_BeginWritingAsset( const AssetFileAssetId id, const AssetFileAssetK
 output->kind        = ASSET_FILE_ASSET_KIND_INVALID;
 output->asset_start = 0;
 
-if( !JumpToAssetInTable( id, output->table_cnt, output->hnd ) )
+AssetFileTableRow *row = FindWriterTableRow( id, output );
+if( row == NULL
+ || !AlignWriter( output ) )
     {
     return( FALSE );
     }
 
 output->asset_start            = output->caret;
+output->asset_row              = row;
 output->kind                   = kind;
 output->model_indices_written  = 0;
 output->model_vertices_written = 0;
+output->model_index_format     = ASSET_FILE_MODEL_INDEX_FORMAT_U32;
+output->model_vertex_format    = ASSET_FILE_MODEL_VERTEX_FORMAT_F32;
+output->model_mesh_start       = 0;
+output->texture_mips_written   = 0;
+output->terrain_tiles_written  = 0;
+output->terrain_lods_written   = 0;
 
-AssetFileTableRow row = {};
-row.id        = id;
-row.kind      = kind;
-row.starts_at = output->caret;
+row->kind      = kind;
+row->starts_at = output->caret;
+
+return( TRUE );
+
+} /* AssetFile_BeginWritingAsset() */
 
-ensure( file_write_struct( output->hnd, &row ) );
-if( !file_seek( output->hnd, output->caret ) )
+
+/*******************************************************************
+*
+*   AssetFile_BuildTerrainMinMax()
+*
+*   DESCRIPTION:
+*       Build a tile's min/max pyramid from its height samples, into
+*       ASSET_FILE_TERRAIN_MINMAX_CNT cells.  Each finest cell covers
+*       the samples on and inside its edges, so neighbouring cells
+*       share their edge samples.
+*
+*******************************************************************/
+
+b8 AssetFile_BuildTerrainMinMax( const u16 *samples, AssetFileTerrainMinMax *min_max )
+{
+if( samples == NULL
+ || min_max == NULL )
     {
     return( FALSE );
     }
 
+const u32 cell_extent = ASSET_FILE_TERRAIN_MINMAX_CELL_EXTENT;
+u32 cells = 1u << ( ASSET_FILE_TERRAIN_MINMAX_LEVEL_CNT - 1 );
+for( u32 cell_z = 0; cell_z < cells; cell_z++ )
+    {
+    for( u32 cell_x = 0; cell_x < cells; cell_x++ )
+        {
+        AssetFileTerrainMinMax cell = { 0xffff, 0 };
+        for( u32 z = cell_z * cell_extent; z <= ( cell_z + 1 ) * cell_extent; z++ )
+            {
+            const u16 *row = &samples[ z * ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT ];
+            for( u32 x = cell_x * cell_extent; x <= ( cell_x + 1 ) * cell_extent; x++ )
+                {
+                cell.min = row[ x ] < cell.min ? row[ x ] : cell.min;
+                cell.max = row[ x ] > cell.max ? row[ x ] : cell.max;
+                }
+            }
+
+        min_max[ AssetFile_GetTerrainMinMaxIndex( 0, cell_x, cell_z ) ] = cell;
+        }
+    }
+
+/* each coarser cell bounds its four children */
+for( u32 level = 1; level < ASSET_FILE_TERRAIN_MINMAX_LEVEL_CNT; level++ )
+    {
+    cells >>= 1;
+    for( u32 cell_z = 0; cell_z < cells; cell_z++ )
+        {
+        for( u32 cell_x = 0; cell_x < cells; cell_x++ )
+            {
+            AssetFileTerrainMinMax cell = { 0xffff, 0 };
+            for( u32 child = 0; child < 4; child++ )
+                {
+                const AssetFileTerrainMinMax *from = &min_max[ AssetFile_GetTerrainMinMaxIndex( level - 1, 2 * cell_x + ( child & 1 ), 2 * cell_z + ( child >> 1 ) ) ];
+                cell.min = from->min < cell.min ? from->min : cell.min;
+                cell.max = from->max > cell.max ? from->max : cell.max;
+                }
+
+            min_max[ AssetFile_GetTerrainMinMaxIndex( level, cell_x, cell_z ) ] = cell;
+            }
+        }
+    }
+
 return( TRUE );
 
-} /* AssetFile_BeginWritingAsset() */
+} /* AssetFile_BuildTerrainMinMax() */
 
 
 /*******************************************************************
@@ -216,13 +554,22 @@ return( TRUE );
 *   AssetFile_CloseForRead()
 *
 *   DESCRIPTION:
-*       Complete reading of the asset file.
+*       Complete reading of the asset file.  A reader over a shared
+*       pack leaves the pack open.
 *
 *******************************************************************/
 
 b8 AssetFile_CloseForRead( AssetFileReader *input )
 {
-b8 ret = file_close( input->hnd );
+free( input->scratch );
+
+b8 ret = TRUE;
+if( input->owned_pack )
+    {
+    ret = AssetFile_ClosePack( input->owned_pack );
+    free( input->owned_pack );
+    }
+
 *input = {};
 
 return( ret );
@@ -235,13 +582,34 @@ return( ret );
 *   AssetFile_CloseForWrite()
 *
 *   DESCRIPTION:
-*       Complete writing for the asset file.
+*       Complete writing for the asset file, by flushing the staged
+*       output and then the file header and asset table.  Memory
+*       writers are simply released.
 *
 *******************************************************************/
 
 b8 AssetFile_CloseForWrite( AssetFileWriter *output )
 {
-b8 ret = file_close( output->hnd );
+b8 ret = TRUE;
+if( output->hnd )
+    {
+    AssetFileHeader header = {};
+    header.magic     = ASSET_FILE_MAGIC;
+    header.version   = ASSET_FILE_VERSION;
+    header.table_cnt = output->table_cnt;
+
+    ret = FlushWriter( output )
+       && file_seek( output->hnd, 0 )
+       && file_write_struct( output->hnd, &header )
+       && file_write_array( output->hnd, output->table_cnt, output->table );
+
+    ret = file_close( output->hnd ) && ret;
+    }
+
+free( output->buffer );
+free( output->table );
+free( output->payload_hashes );
+free( output->payload_slots );
 *output = {};
 
 return( ret );
@@ -251,1828 +619,5467 @@ return( ret );
 
 /*******************************************************************
 *
-*   AssetFile_BeginWritingModelElement()
+*   AssetFile_CloseLoader()
 *
 *   DESCRIPTION:
-*       Begin writing a model element (mesh, material, etc) given
-*       its index.
+*       Finish every submitted load, then stop the loader thread and
+*       close its reader.
 *
 *******************************************************************/
 
-b8 AssetFile_BeginWritingModelElement( const AssetFileModelElementKind kind, const AssetFileModelIndex element_index, AssetFileWriter *output )
+b8 AssetFile_CloseLoader( AssetFileLoader *loader )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+AssetFileLoaderQueue *queue = loader->queue;
+if( queue == NULL )
     {
     return( FALSE );
     }
 
-u32 row_location = output->asset_start
-                 + (u32)sizeof(ModelHeader)
-                 + element_index * (u32)sizeof(ModelTableRow);
-
-if( !file_seek( output->hnd, row_location ) )
     {
-    return( FALSE );
+    std::lock_guard<std::mutex> lock( queue->mutex );
+    queue->quit = TRUE;
     }
 
-ModelTableRow row = {};
-row.starts_at = output->caret;
-row.kind      = kind;
-ensure( file_write_struct( output->hnd, &row ) );
+queue->work_signal.notify_one();
+queue->thread.join();
 
-if( !file_seek( output->hnd, output->caret ) )
-    {
-    return( FALSE );
-    }
+free( queue->buffer );
+delete queue;
+loader->queue = NULL;
 
-return( TRUE );
+return( AssetFile_CloseForRead( &loader->input ) );
 
-} /* AssetFile_BeginWritingAsset() */
+} /* AssetFile_CloseLoader() */
 
 
 /*******************************************************************
 *
-*   AssetFile_CreateForWrite()
+*   AssetFile_ClosePack()
 *
 *   DESCRIPTION:
-*       Create a new file with the given filename and path, and
-*       initialize asset ID the table
+*       Close a pack.  Every reader opened over it must be closed
+*       first.
 *
 *******************************************************************/
 
-b8 AssetFile_CreateForWrite( const char *filename, const AssetFileAssetId *ids, const u32 ids_count, AssetFileWriter *output )
+b8 AssetFile_ClosePack( AssetFilePack *pack )
 {
-*output = {};
-if( !file_open( filename, "w+b", &output->hnd ) )
-    {
-    return( FALSE );
-    }
-
-AssetFileHeader header = {};
-header.magic     = ASSET_FILE_MAGIC;
-header.table_cnt = ids_count;
-
-ensure( file_write_struct( output->hnd, &header ) );
+free( pack->table_keys );
+free( pack->table_mem );
 
-AssetFileTableRow row;
-for( u32 i = 0; i < ids_count; i++ )
+b8 ret = file_unmap( pack->map, pack->map_sz, pack->map_hnd );
+ret = file_close_read_at( pack->read_hnd ) && ret;
+if( pack->hnd )
     {
-    row = {};
-    row.id = ids[ i ];
-
-    ensure( file_write_struct( output->hnd, &row ) );
+    ret = file_close( pack->hnd ) && ret;
     }
 
-output->table_cnt = header.table_cnt;
-output->caret     = (u32)file_get_pos( output->hnd );
+*pack = {};
 
-return( TRUE );
+return( ret );
 
-} /* AssetFile_CreateForWrite() */
+} /* AssetFile_ClosePack() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeFont()
+*   AssetFile_CompressTerrainTile()
 *
 *   DESCRIPTION:
-*       Provide the details about a font being written.
+*       Losslessly compress a tile's height samples for
+*       AssetFile_WriteTerrainTileCompressed().  This needs no writer,
+*       so tiles can be compressed on many threads at once.  Fails if
+*       the result does not fit the buffer; a buffer the size of the
+*       raw samples keeps only tiles which got smaller.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeFont( const u8 oversample_x, const u8 oversample_y, const u16 texture_width, const u16 texture_height, const u32 texture_sz, const u8 *pixels, const u16 glyph_cnt, const u8 *glyph_codes, AssetFileWriter *output )
+b8 AssetFile_CompressTerrainTile( const u16 *samples, const u32 buffer_sz, u32 *byte_size, byte *buffer )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_FONT
-|| !output->asset_start
-|| !file_seek( output->hnd, output->asset_start ) )
+if( samples == NULL
+ || byte_size == NULL
+ || buffer == NULL )
     {
     return( FALSE );
     }
 
-FontHeader header = {};
-header.oversample_x      = oversample_x;
-header.oversample_y      = oversample_y;
-header.texture_width     = texture_width;
-header.texture_height    = texture_height;
-header.glyph_cnt         = glyph_cnt;
-header.texture_sz        = texture_sz;
-header.texture_starts_at = output->caret + sizeof( FontHeader );
-header.glyphs_starts_at  = header.texture_starts_at + texture_sz;
-
-ensure( file_write_struct( output->hnd, &header ) );
-ensure( file_write( output->hnd, texture_sz, pixels ) );
-
-output->caret = (u32)file_get_pos( output->hnd );
+*byte_size = compress_terrain( samples, ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT, ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT, buffer, buffer_sz );
 
-return( TRUE );
+return( *byte_size != 0 );
 
-} /* AssetFile_DescribeFont() */
+} /* AssetFile_CompressTerrainTile() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeModel()
+*   AssetFile_CopyAsset()
 *
 *   DESCRIPTION:
-*       Provide the number of table entries for the model under
-*       write.
+*       Copy an asset's stored bytes as-is from an existing asset
+*       file to the output, without decompressing it.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeModel( const u32 node_count, const u32 mesh_count, const u32 material_count, AssetFileWriter *output )
+b8 AssetFile_CopyAsset( const AssetFileAssetId id, AssetFileReader *input, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start
- || !file_seek( output->hnd, output->asset_start ) )
+const AssetFileTableRow *in_row = FindTableRow( id, input->pack );
+AssetFileTableRow *out_row = FindWriterTableRow( id, output );
+if( in_row == NULL
+ || out_row == NULL
+ || in_row->kind == ASSET_FILE_ASSET_KIND_INVALID
+ || output->asset_start
+ || !AlignWriter( output ) )
     {
     return( FALSE );
     }
 
-ModelHeader header = {};
-header.node_count   = node_count;
-header.mesh_count   = mesh_count;
-header.material_cnt = material_count;
+out_row->kind      = in_row->kind;
+out_row->starts_at = output->caret;
+out_row->stored_sz = in_row->stored_sz;
+out_row->raw_sz    = in_row->raw_sz;
+out_row->codec     = in_row->codec;
 
-ensure( file_write_struct( output->hnd, &header ) );
-
-u32 row_count = node_count + mesh_count + material_count;
-ModelTableRow row = {};
-for( u32 i = 0; i < row_count; i++ )
+/* payloads too large to stage (terrains) are streamed in chunks, and only deduplicated when mapped */
+const byte *stored = ViewFileAt( in_row->starts_at, in_row->stored_sz, input );
+b8 ret = stored && SharePayload( out_row, stored, output );
+if( !ret
+ && ( stored || in_row->stored_sz > ASSET_FILE_WRITE_BUFFER_MAX_SZ ) )
     {
-    ensure( file_write_struct( output->hnd, &row ) );
+    byte *chunk = NULL;
+    if( !stored )
+        {
+        chunk = (byte*)malloc( ASSET_FILE_WRITE_FLUSH_SZ );
+        }
+
+    ret = stored || chunk;
+    for( u64 at = 0; ret && at < in_row->stored_sz; at += ASSET_FILE_WRITE_FLUSH_SZ )
+        {
+        u64 chunk_sz = in_row->stored_sz - at;
+        if( chunk_sz > ASSET_FILE_WRITE_FLUSH_SZ )
+            {
+            chunk_sz = ASSET_FILE_WRITE_FLUSH_SZ;
+            }
+
+        if( stored )
+            {
+            ret = WriteAppend( chunk_sz, stored + at, output );
+            }
+        else
+            {
+            ret = ReadFileAt( in_row->starts_at + at, chunk_sz, chunk, input )
+               && WriteAppend( chunk_sz, chunk, output );
+            }
+        }
+
+    free( chunk );
     }
+else if( !ret )
+    {
+    byte *bytes = (byte*)malloc( in_row->stored_sz ? (size_t)in_row->stored_sz : 1 );
+    ret = bytes
+       && ReadFileAt( in_row->starts_at, in_row->stored_sz, bytes, input )
+       && ( SharePayload( out_row, bytes, output )
+         || WriteAppend( in_row->stored_sz, bytes, output ) );
 
-output->caret = (u32)file_get_pos( output->hnd );
+    free( bytes );
+    }
 
-return( TRUE );
+return( ret && EndAsset( output ) );
 
-} /* AssetFile_DescribeModel() */
+} /* AssetFile_CopyAsset() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeModelMaterial()
+*   AssetFile_CreateForMemory()
 *
 *   DESCRIPTION:
-*       Provide the details of the material about to be written.
+*       Initialize a writer which stages the given assets in memory
+*       only, for later appending to a file writer.  This lets the
+*       assets be exported on other threads.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeModelMaterial( const AssetFileModelMaterialBits maps, AssetFileWriter *output )
+b8 AssetFile_CreateForMemory( const AssetFileAssetId *ids, const u32 ids_count, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+*output = {};
+output->table = (AssetFileTableRow*)malloc( ( ids_count ? (size_t)ids_count : 1 ) * sizeof( AssetFileTableRow ) );
+if( !output->table )
     {
     return( FALSE );
     }
 
-ModelMaterialHeader header = {};
-header.map_bits = maps;
+for( u32 i = 0; i < ids_count; i++ )
+    {
+    output->table[ i ] = {};
+    output->table[ i ].id = ids[ i ];
+    }
 
-ensure( file_write_struct( output->hnd, &header ) );
-output->caret = (u32)file_get_pos( output->hnd );
+/* start at an aligned, non-zero base so asset starts stay valid and aligned */
+output->table_cnt    = ids_count;
+output->caret        = ASSET_FILE_ALIGNMENT;
+output->buffer_start = output->caret;
 
 return( TRUE );
 
-} /* AssetFile_DescribeModelMaterial() */
+} /* AssetFile_CreateForMemory() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeModelMesh()
+*   AssetFile_BeginWritingModelElement()
 *
 *   DESCRIPTION:
-*       Provide the details of the mesh about to be written.
+*       Begin writing a model element (mesh, material, etc) given
+*       its index.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeModelMesh( const u32 material_element_index, const u32 vertex_cnt, const u32 index_cnt, AssetFileWriter *output )
+b8 AssetFile_BeginWritingModelElement( const AssetFileModelElementKind kind, const AssetFileModelIndex element_index, AssetFileWriter *output )
 {
 if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+ || !output->asset_start
+ || !AlignWriter( output ) )
     {
     return( FALSE );
     }
 
-ModelMeshHeader header = {};
-header.vertex_cnt = vertex_cnt;
-header.index_cnt  = index_cnt;
-header.material   = material_element_index;
-
-ensure( file_write_struct( output->hnd, &header ) );
+u64 row_location = output->asset_start
+                 + (u32)sizeof(ModelHeader)
+                 + element_index * (u32)sizeof(ModelTableRow);
 
-output->caret = (u32)file_get_pos( output->hnd );
+ModelTableRow row = {};
+row.starts_at = output->caret - output->asset_start;
+row.kind      = kind;
 
-return( TRUE );
+return( write_struct_at( row_location, &row, output ) );
 
-} /* AssetFile_DescribeModelMesh() */
+} /* AssetFile_BeginWritingAsset() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeModelNode()
+*   AssetFile_CreateForWrite()
 *
 *   DESCRIPTION:
-*       Provide the details of the model node about to be written.
+*       Create a new file with the given filename and path, and
+*       initialize asset ID the table.  The table is kept in memory
+*       and written when the file is closed.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeModelNode( const u32 node_count, const f32 *mat4x4, const u32 mesh_count, AssetFileWriter *output )
+b8 AssetFile_CreateForWrite( const char *filename, const AssetFileAssetId *ids, const u32 ids_count, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start
- || node_count > ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT 
- || mesh_count > ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT )
+*output = {};
+
+/* keep the payload hash table at most half full */
+output->payload_slot_cnt = 16;
+while( output->payload_slot_cnt < 2 * (u64)ids_count )
     {
-    return( FALSE );
+    output->payload_slot_cnt *= 2;
     }
 
-ModelNodeHeader header = {};
-header.node_count = node_count;
-header.mesh_count = mesh_count;
-memcpy( header.transform, mat4x4, _countof( header.transform ) * sizeof( *header.transform ) );
+output->table          = (AssetFileTableRow*)malloc( ( ids_count ? (size_t)ids_count : 1 ) * sizeof( AssetFileTableRow ) );
+output->payload_hashes = (u64*)malloc( ( ids_count ? (size_t)ids_count : 1 ) * sizeof( u64 ) );
+output->payload_slots  = (u32*)calloc( output->payload_slot_cnt, sizeof( u32 ) );
+if( !output->table
+ || !output->payload_hashes
+ || !output->payload_slots
+ || !file_open( filename, "w+b", &output->hnd ) )
+    {
+    free( output->table );
+    free( output->payload_hashes );
+    free( output->payload_slots );
+    *output = {};
+    return( FALSE );
+    }
 
-ensure( file_write_struct( output->hnd, &header ) );
+for( u32 i = 0; i < ids_count; i++ )
+    {
+    output->table[ i ] = {};
+    output->table[ i ].id = ids[ i ];
+    }
 
-output->caret = (u32)file_get_pos( output->hnd );
+output->table_cnt    = ids_count;
+output->caret        = sizeof( AssetFileHeader ) + (u64)ids_count * sizeof( AssetFileTableRow );
+output->buffer_start = output->caret;
 
 return( TRUE );
 
-} /* AssetFile_DescribeModelNode() */
+} /* AssetFile_CreateForWrite() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeShader()
+*   AssetFile_DescribeFont()
 *
 *   DESCRIPTION:
-*       Provide the byte code size of the shader under write.
+*       Provide the details about a font being written.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeShader( const u32 byte_size, AssetFileWriter *output )
+b8 AssetFile_DescribeFont( const u8 oversample_x, const u8 oversample_y, const u16 texture_width, const u16 texture_height, const u32 texture_sz, const u8 *pixels, const u16 glyph_cnt, const u8 *glyph_codes, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_SHADER
- || !output->asset_start
- || !file_seek( output->hnd, output->asset_start ) )
+if( output->kind != ASSET_FILE_ASSET_KIND_FONT
+|| !output->asset_start )
     {
     return( FALSE );
     }
 
-ShaderHeader header = {};
-header.byte_size = byte_size;
+output->caret = output->asset_start;
 
-ensure( file_write_struct( output->hnd, &header ) );
-output->caret = (u32)file_get_pos( output->hnd );
+FontHeader header = {};
+header.oversample_x      = oversample_x;
+header.oversample_y      = oversample_y;
+header.texture_width     = texture_width;
+header.texture_height    = texture_height;
+header.glyph_cnt         = glyph_cnt;
+header.texture_sz        = texture_sz;
+header.texture_starts_at = output->caret - output->asset_start + sizeof( FontHeader );
+header.glyphs_starts_at  = header.texture_starts_at + texture_sz;
+
+ensure( write_struct( &header, output ) );
+ensure( WriteAppend( texture_sz, pixels, output ) );
 
 return( TRUE );
 
-} /* AssetFile_DescribeShader() */
+} /* AssetFile_DescribeFont() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeTexture()
+*   AssetFile_DescribeModel()
 *
 *   DESCRIPTION:
-*       Provide the dimensions of the texture under write.
+*       Provide the number of table entries for the model under
+*       write.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeTexture( const u32 byte_size, AssetFileWriter *output )
+b8 AssetFile_DescribeModel( const u32 node_count, const u32 mesh_count, const u32 material_count, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE
- || !output->asset_start
- || !file_seek( output->hnd, output->asset_start ) )
-    {
-    return( FALSE );
-    }
-
-TextureHeader header = {};
-header.byte_size  = byte_size;
-
-ensure( file_write_struct( output->hnd, &header ) );
-output->caret = (u32)file_get_pos( output->hnd );
-
-return( TRUE );
+return( AssetFile_DescribeModel2( node_count, mesh_count, material_count, FALSE, output ) );
 
-} /* AssetFile_DescribeTexture() */
+} /* AssetFile_DescribeModel() */
 
 
 /*******************************************************************
 *
-*   AssetFile_DescribeTexture2()
+*   AssetFile_DescribeModel2()
 *
 *   DESCRIPTION:
-*       Provide the dimensions of the texture under write.
+*       Provide the number of table entries for the model under
+*       write.  With meshlets, each mesh has a meshlets element,
+*       indexed after the nodes in mesh order.
 *
 *******************************************************************/
 
-b8 AssetFile_DescribeTexture2( const u32 channel_cnt, const u32 channel_width, const u32 width, const u32 height, const u32 byte_size, AssetFileWriter *output )
+b8 AssetFile_DescribeModel2( const u32 node_count, const u32 mesh_count, const u32 material_count, const b8 with_meshlets, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE
- || !output->asset_start
- || !file_seek( output->hnd, output->asset_start ) )
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
     {
     return( FALSE );
     }
 
-TextureHeader header = {};
-header.byte_size     = byte_size;
-header.width         = width;
-header.height        = height;
-header.channel_cnt   = channel_cnt;
-header.channel_width = channel_width;
-
-ensure( file_write_struct( output->hnd, &header ) );
-output->caret = (u32)file_get_pos( output->hnd );
-
-return( TRUE );
-
-} /* AssetFile_DescribeTexture2() */
+output->caret = output->asset_start;
 
+ModelHeader header = {};
+header.node_count   = node_count;
+header.mesh_count   = mesh_count;
+header.material_cnt = material_count;
+header.meshlets_cnt = with_meshlets ? mesh_count : 0;
 
-/*******************************************************************
-*
-*   AssetFile_DescribeTextureExtents()
-*
-*   DESCRIPTION:
-*       Provide the number of elements in the texture extent map
-*       table.
-*
-*******************************************************************/
+ensure( write_struct( &header, output ) );
 
-b8 AssetFile_DescribeTextureExtents( const u16 element_cnt, AssetFileWriter *output )
-{
-if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
- || !output->asset_start
- || !file_seek( output->hnd, output->asset_start ) )
+u32 row_count = node_count + mesh_count + material_count + header.meshlets_cnt;
+ModelTableRow row = {};
+for( u32 i = 0; i < row_count; i++ )
     {
-    return( FALSE );
+    ensure( write_struct( &row, output ) );
     }
 
-TextureExtentHeader header = {};
-header.texture_cnt = element_cnt;
-
-ensure( file_write_struct( output->hnd, &header ) );
-output->caret = (u32)file_get_pos( output->hnd );
-
 return( TRUE );
 
-}   /* AssetFile_DescribeTextureExtents() */
+} /* AssetFile_DescribeModel2() */
 
 
 /*******************************************************************
 *
-*   AssetFile_EndReadingAsset()
+*   AssetFile_DescribeModelMaterial()
 *
 *   DESCRIPTION:
-*       Finish reading an asset.
+*       Provide the details of the material about to be written.
 *
 *******************************************************************/
 
-b8 AssetFile_EndReadingAsset( AssetFileReader *input )
+b8 AssetFile_DescribeModelMaterial( const AssetFileModelMaterialBits maps, AssetFileWriter *output )
 {
-if( input->kind == ASSET_FILE_ASSET_KIND_INVALID
- || !input->asset_start )
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
     {
     return( FALSE );
     }
 
-input->asset_start = 0;
-input->kind = ASSET_FILE_ASSET_KIND_INVALID;
+ModelMaterialHeader header = {};
+header.map_bits = maps;
+
+ensure( write_struct( &header, output ) );
 
 return( TRUE );
 
-} /* AssetFile_EndReadingAsset() */
+} /* AssetFile_DescribeModelMaterial() */
 
 
 /*******************************************************************
 *
-*   AssetFile_EndWritingAsset()
+*   AssetFile_DescribeModelMesh()
 *
 *   DESCRIPTION:
-*       Finish writing a model by setting its root node.
+*       Provide the details of the mesh about to be written, with
+*       float vertices and 32-bit indices.
 *
 *******************************************************************/
 
-b8 AssetFile_EndWritingAsset( AssetFileWriter *output )
+b8 AssetFile_DescribeModelMesh( const u32 material_element_index, const u32 vertex_cnt, const u32 index_cnt, AssetFileWriter *output )
 {
-output->asset_start = 0;
-output->kind = ASSET_FILE_ASSET_KIND_INVALID;
-
-return( TRUE );
+return( AssetFile_DescribeModelMesh2( material_element_index, vertex_cnt, index_cnt, ASSET_FILE_MODEL_INDEX_FORMAT_U32, ASSET_FILE_MODEL_VERTEX_FORMAT_F32, NULL, output ) );
 
-}   /* AssetFile_EndWritingAsset() */
+} /* AssetFile_DescribeModelMesh() */
 
 
 /*******************************************************************
 *
-*   AssetFile_EndWritingModel()
+*   AssetFile_DescribeModelMesh2()
 *
 *   DESCRIPTION:
-*       Finish writing a model by setting its root node.
+*       Provide the details of the mesh about to be written.  Its
+*       vertices and indices are passed as AssetFileModelVertex and
+*       AssetFileModelIndex but stored in the given formats, so
+*       16-bit meshes must have at most 65536 vertices.  Bounds are
+*       optional except for packed meshes, which quantize against
+*       their box.
 *
 *******************************************************************/
 
-b8 AssetFile_EndWritingModel( const u32 root_node_element, AssetFileWriter *output )
+b8 AssetFile_DescribeModelMesh2( const u32 material_element_index, const u32 vertex_cnt, const u32 index_cnt, const AssetFileModelIndexFormat index_format, const AssetFileModelVertexFormat vertex_format, const AssetFileModelBounds *bounds, AssetFileWriter *output )
 {
 if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+ || !output->asset_start
+ || GetModelIndexSize( index_format ) == 0
+ || GetModelVertexSize( vertex_format ) == 0
+ || ( index_format == ASSET_FILE_MODEL_INDEX_FORMAT_U16 && vertex_cnt > 0x10000 )
+ || ( vertex_format == ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED && bounds == NULL ) )
     {
     return( FALSE );
     }
 
-if( !file_seek( output->hnd, output->asset_start ) )
-    {
-    return( FALSE );
+ModelMeshHeader header = {};
+header.vertex_cnt    = vertex_cnt;
+header.index_cnt     = index_cnt;
+header.material      = material_element_index;
+header.index_format  = index_format;
+header.vertex_format = vertex_format;
+header.bounds.radius = -1.0f;
+if( bounds )
+    {
+    header.bounds = *bounds;
     }
 
-ModelHeader header = {};
-ensure( file_read_struct( output->hnd, &header ) );
-
-header.root_node_element  = root_node_element;
-header.total_index_count  = output->model_indices_written;
-header.total_vertex_count = output->model_vertices_written;
-if( !file_seek( output->hnd, output->asset_start ) )
+for( u32 i = 0; i < 3; i++ )
     {
-    return( FALSE );
-    }
-    
-ensure( file_write_struct( output->hnd, &header ) );
-if( !file_seek( output->hnd, output->caret ) )
-    {
-    return( FALSE );
+    header.position_offset[ i ] = 0.0f;
+    header.position_scale[ i ]  = 1.0f;
+    if( vertex_format == ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED )
+        {
+        if( !( bounds->max[ i ] >= bounds->min[ i ] ) )
+            {
+            return( FALSE );
+            }
+
+        header.position_offset[ i ] = bounds->min[ i ];
+        header.position_scale[ i ]  = ( bounds->max[ i ] - bounds->min[ i ] ) / 65535.0f;
+        }
     }
 
-output->asset_start = 0;
-output->kind = ASSET_FILE_ASSET_KIND_INVALID;
-output->model_indices_written = 0;
-output->model_vertices_written = 0;
+output->model_mesh_start = output->caret;
+ensure( write_struct( &header, output ) );
+
+output->model_index_format  = index_format;
+output->model_vertex_format = vertex_format;
+memcpy( output->model_position_offset, header.position_offset, sizeof( header.position_offset ) );
+memcpy( output->model_position_scale, header.position_scale, sizeof( header.position_scale ) );
 
 return( TRUE );
 
-} /* AssetFile_EndWritingModel() */
+} /* AssetFile_DescribeModelMesh2() */
 
 
 /*******************************************************************
 *
-*   AssetFile_EndWritingTextureExtents()
+*   AssetFile_DescribeModelMeshLods()
 *
 *   DESCRIPTION:
-*       Finish writing texture extents.
+*       Give the coarser levels of detail of the mesh just described,
+*       before its vertices are written.  Their indices follow the
+*       full detail indices, in order, and use the same vertices.
 *
 *******************************************************************/
 
-b8 AssetFile_EndWritingTextureExtents( AssetFileWriter *output )
+b8 AssetFile_DescribeModelMeshLods( const u32 lod_cnt, const AssetFileModelMeshLod *lods, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
- || !output->asset_start )
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start
+ || !output->model_mesh_start
+ || lod_cnt > ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT )
     {
     return( FALSE );
     }
 
-output->asset_start = 0;
-output->kind = ASSET_FILE_ASSET_KIND_INVALID;
+u32 lod_index_cnt = 0;
+for( u32 i = 0; i < lod_cnt; i++ )
+    {
+    lod_index_cnt += lods[ i ].index_count;
+    }
+
+u64 mesh_start = output->model_mesh_start;
+if( !write_struct_at( mesh_start + offsetof( ModelMeshHeader, lod_cnt ), &lod_cnt, output )
+ || !write_struct_at( mesh_start + offsetof( ModelMeshHeader, lod_index_cnt ), &lod_index_cnt, output )
+ || !WriteAt( mesh_start + offsetof( ModelMeshHeader, lods ), lod_cnt * sizeof( *lods ), lods, output ) )
+    {
+    return( FALSE );
+    }
 
 return( TRUE );
 
-}   /* AssetFile_EndWritingTextureExtents() */
+} /* AssetFile_DescribeModelMeshLods() */
 
 
 /*******************************************************************
 *
-*   AssetFile_GetWriteSize()
+*   AssetFile_DescribeModelNode()
 *
 *   DESCRIPTION:
-*       Get the current file written size.
+*       Provide the details of the model node about to be written.
 *
 *******************************************************************/
 
-u64 AssetFile_GetWriteSize( const AssetFileWriter *output )
+b8 AssetFile_DescribeModelNode( const u32 node_count, const f32 *mat4x4, const u32 mesh_count, AssetFileWriter *output )
 {
-return( output->caret );
+return( AssetFile_DescribeModelNode2( node_count, mat4x4, mesh_count, NULL, output ) );
 
-} /* AssetFile_GetWriteSize() */
+} /* AssetFile_DescribeModelNode() */
 
 
 /*******************************************************************
 *
-*   AssetFile_OpenForRead()
+*   AssetFile_DescribeModelNode2()
 *
 *   DESCRIPTION:
-*       Open the asset file for read-only.
+*       Provide the details of the model node about to be written,
+*       with optional bounds of everything beneath it, given in the
+*       node's space before its transform is applied.
 *
 *******************************************************************/
 
-b8 AssetFile_OpenForRead( const char *filename, AssetFileReader *input )
+b8 AssetFile_DescribeModelNode2( const u32 node_count, const f32 *mat4x4, const u32 mesh_count, const AssetFileModelBounds *bounds, AssetFileWriter *output )
 {
-*input = {};
-if( !file_open( filename, "rb", &input->hnd ) )
-    {
-    return( FALSE );
-    }
-
-AssetFileHeader file_header = {};
-if( !file_read_struct( input->hnd, &file_header ) )
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start
+ || node_count > ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT 
+ || mesh_count > ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT )
     {
-    ensure( file_close( input->hnd ) );
-    input->hnd = 0;
     return( FALSE );
     }
 
-if( file_header.magic != ASSET_FILE_MAGIC )
+ModelNodeHeader header = {};
+header.node_count = node_count;
+header.mesh_count = mesh_count;
+memcpy( header.transform, mat4x4, _countof( header.transform ) * sizeof( *header.transform ) );
+header.bounds.radius = -1.0f;
+if( bounds )
     {
-    ensure( file_close( input->hnd ) );
-    input->hnd = 0;
-    return( FALSE );
+    header.bounds = *bounds;
     }
 
-input->table_cnt = file_header.table_cnt;
+ensure( write_struct( &header, output ) );
 
 return( TRUE );
 
-} /* AssetFile_OpenForRead() */
+} /* AssetFile_DescribeModelNode2() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadFontGlyphs()
+*   AssetFile_DescribeShader()
 *
 *   DESCRIPTION:
-*       Read and output a font's glyph data.
+*       Provide the byte code size of the shader under write.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadFontGlyphs( const u16 glyph_capacity, AssetFileFontGlyph *glyphs, AssetFileReader *input )
+b8 AssetFile_DescribeShader( const u32 byte_size, AssetFileWriter *output )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_FONT
- || !input->asset_start
- || glyphs == NULL )
-    {
-    return( FALSE );
-    }
-
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
-    }
-
-FontHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
-    {
-    return( FALSE );
-    }
-
-if( glyph_capacity < header.glyph_cnt )
-    {
-    return( FALSE );
-    }
-    
-if( !file_seek( input->hnd, header.glyphs_starts_at ) )
+if( output->kind != ASSET_FILE_ASSET_KIND_SHADER
+ || !output->asset_start )
     {
     return( FALSE );
     }
 
-f32 width_scale  = 1.0f / (f32)header.oversample_x;
-f32 height_scale = 1.0f / (f32)header.oversample_y;
+output->caret = output->asset_start;
 
-for( u32 i = 0; i < header.glyph_cnt; i++ )
-    {
-    FontGlyphHeader glyph = {};
-    if( !file_read_struct( input->hnd, &glyph ) )
-        {
-        return( FALSE );
-        }
+ShaderHeader header = {};
+header.byte_size = byte_size;
 
-    AssetFileFontGlyph *out = glyphs + i;
-    
-    out->glyph          = glyph.glyph;
-    out->width          = width_scale  * ( glyph.u1 - glyph.u0 );
-    out->height         = height_scale * ( glyph.v1 - glyph.v0 );
-    out->top_left_x     = glyph.pen_offset_x;
-    out->top_left_y     = glyph.pen_offset_y;
-    out->bottom_right_x = out->top_left_x + out->width;
-    out->bottom_right_y = out->top_left_y + out->height;
-    out->u0             = (f32)glyph.u0 / header.texture_width;
-    out->v0             = (f32)glyph.v0 / header.texture_height;
-    out->u1             = (f32)glyph.u1 / header.texture_width;
-    out->v1             = (f32)glyph.v1 / header.texture_height;
-    out->h_advance      = glyph.h_advance;
-    }
+ensure( write_struct( &header, output ) );
 
 return( TRUE );
 
-}   /* AssetFile_ReadFontGlyphs() */
+} /* AssetFile_DescribeShader() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadFontTexture()
+*   AssetFile_DescribeTerrain()
 *
 *   DESCRIPTION:
-*       Read the font's texture dimensions and pixel data.
+*       Start the terrain under write with an empty tile directory
+*       covering the whole grid.  Add tiles with
+*       AssetFile_WriteTerrainTile() or its variants, and the LOD
+*       index patterns with AssetFile_WriteTerrainLod(), then finish
+*       the asset with AssetFile_EndWritingAsset().
 *
 *******************************************************************/
 
-b8 AssetFile_ReadFontTexture( const u32 buffer_sz, u8 *pixels, u16 *width, u16 *height, AssetFileReader *input )
+b8 AssetFile_DescribeTerrain( AssetFileWriter *output )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_FONT
- || !input->asset_start
- || pixels == NULL
- || width == NULL
- || height == NULL )
+if( output->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !output->asset_start )
     {
     return( FALSE );
     }
 
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
-    }
+output->caret = output->asset_start;
+output->terrain_tiles_written = 0;
+output->terrain_lods_written  = 0;
 
-FontHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
-    {
-    return( FALSE );
-    }
+TerrainHeader header = {};
+header.sample_extent = ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT;
+header.axes_cnt      = ASSET_FILE_TERRAIN_AXES_CNT;
 
-*width  = header.texture_width;
-*height = header.texture_height;
+ensure( write_struct( &header, output ) );
 
-if( !file_seek( input->hnd, header.texture_starts_at ) )
-    {
-    return( FALSE );
-    }
-    
-if( !file_read( input->hnd, header.texture_sz, pixels ) )
+TerrainTile empty[ ASSET_FILE_TERRAIN_AXES_CNT ] = {};
+for( u32 i = 0; i < ASSET_FILE_TERRAIN_AXES_CNT; i++ )
     {
-    return( FALSE );
+    ensure( write_array( ASSET_FILE_TERRAIN_AXES_CNT, empty, output ) );
     }
 
 return( TRUE );
 
-}   /* AssetFile_ReadFontTexture() */
+} /* AssetFile_DescribeTerrain() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadFontStorageRequirements()
+*   AssetFile_DescribeTexture()
 *
 *   DESCRIPTION:
-*       Read the storage needed to query a font.
+*       Provide the dimensions of the texture under write.
+*
+*******************************************************************/
+
+b8 AssetFile_DescribeTexture( const u32 byte_size, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+output->caret = output->asset_start;
+
+TextureHeader header = {};
+header.byte_size  = byte_size;
+
+ensure( write_struct( &header, output ) );
+
+return( TRUE );
+
+} /* AssetFile_DescribeTexture() */
+
+
+/*******************************************************************
+*
+*   AssetFile_DescribeTexture2()
+*
+*   DESCRIPTION:
+*       Provide the dimensions and pixel format of the texture under
+*       write.  For block compressed formats the channel count and
+*       width describe the decoded texels.
+*
+*******************************************************************/
+
+b8 AssetFile_DescribeTexture2( const AssetFileTextureFormat format, const u32 channel_cnt, const u32 channel_width, const u32 width, const u32 height, const u32 byte_size, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !output->asset_start
+ || format >= ASSET_FILE_TEXTURE_FORMAT_CNT )
+    {
+    return( FALSE );
+    }
+
+output->caret = output->asset_start;
+
+TextureHeader header = {};
+header.format        = format;
+header.byte_size     = byte_size;
+header.width         = width;
+header.height        = height;
+header.channel_cnt   = channel_cnt;
+header.channel_width = channel_width;
+
+ensure( write_struct( &header, output ) );
+
+return( TRUE );
+
+} /* AssetFile_DescribeTexture2() */
+
+
+/*******************************************************************
+*
+*   AssetFile_DescribeTextureExtents()
+*
+*   DESCRIPTION:
+*       Provide the number of elements in the texture extent map
+*       table.
+*
+*******************************************************************/
+
+b8 AssetFile_DescribeTextureExtents( const u16 element_cnt, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+output->caret = output->asset_start;
+
+TextureExtentHeader header = {};
+header.texture_cnt = element_cnt;
+
+ensure( write_struct( &header, output ) );
+
+return( TRUE );
+
+}   /* AssetFile_DescribeTextureExtents() */
+
+
+/*******************************************************************
+*
+*   AssetFile_DequantizeModelVertices()
+*
+*   DESCRIPTION:
+*       Expand a span of a mapped or loaded mesh's vertices to
+*       AssetFileModelVertex, whatever layout they are stored in.
+*
+*******************************************************************/
+
+b8 AssetFile_DequantizeModelVertices( const AssetFileModelMesh *mesh, const u32 first_vertex, const u32 vertex_cnt, AssetFileModelVertex *vertices )
+{
+if( mesh == NULL
+ || vertices == NULL
+ || first_vertex > mesh->vertex_count
+ || vertex_cnt > mesh->vertex_count - first_vertex )
+    {
+    return( FALSE );
+    }
+
+switch( mesh->vertex_format )
+    {
+    case ASSET_FILE_MODEL_VERTEX_FORMAT_F32:
+        memcpy( vertices, (const AssetFileModelVertex*)mesh->vertices + first_vertex, vertex_cnt * sizeof( *vertices ) );
+        return( TRUE );
+
+    case ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED:
+        DequantizeVertices( (const AssetFileModelPackedVertex*)mesh->vertices + first_vertex, vertex_cnt, mesh->position_offset, mesh->position_scale, vertices );
+        return( TRUE );
+
+    default:
+        return( FALSE );
+    }
+
+} /* AssetFile_DequantizeModelVertices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_EndReadingAsset()
+*
+*   DESCRIPTION:
+*       Finish reading an asset.
+*
+*******************************************************************/
+
+b8 AssetFile_EndReadingAsset( AssetFileReader *input )
+{
+if( input->kind == ASSET_FILE_ASSET_KIND_INVALID
+ || !input->asset_start )
+    {
+    return( FALSE );
+    }
+
+input->asset_start = 0;
+input->asset_row = NULL;
+input->asset_data = NULL;
+input->blob = NULL;
+input->kind = ASSET_FILE_ASSET_KIND_INVALID;
+
+return( TRUE );
+
+} /* AssetFile_EndReadingAsset() */
+
+
+/*******************************************************************
+*
+*   AssetFile_EndWritingAsset()
+*
+*   DESCRIPTION:
+*       Finish writing an asset.
+*
+*******************************************************************/
+
+b8 AssetFile_EndWritingAsset( AssetFileWriter *output )
+{
+return( EndAsset( output ) );
+
+}   /* AssetFile_EndWritingAsset() */
+
+
+/*******************************************************************
+*
+*   AssetFile_EndWritingModel()
+*
+*   DESCRIPTION:
+*       Finish writing a model by setting its root node.
+*
+*******************************************************************/
+
+b8 AssetFile_EndWritingModel( const u32 root_node_element, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+u64 header_start = output->asset_start;
+if( !write_struct_at( header_start + offsetof( ModelHeader, root_node_element ), &root_node_element, output )
+ || !write_struct_at( header_start + offsetof( ModelHeader, total_index_count ), &output->model_indices_written, output )
+ || !write_struct_at( header_start + offsetof( ModelHeader, total_vertex_count ), &output->model_vertices_written, output ) )
+    {
+    return( FALSE );
+    }
+
+output->model_indices_written = 0;
+output->model_vertices_written = 0;
+
+return( EndAsset( output ) );
+
+} /* AssetFile_EndWritingModel() */
+
+
+/*******************************************************************
+*
+*   AssetFile_EndWritingTextureExtents()
+*
+*   DESCRIPTION:
+*       Finish writing texture extents.
+*
+*******************************************************************/
+
+b8 AssetFile_EndWritingTextureExtents( AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+return( EndAsset( output ) );
+
+}   /* AssetFile_EndWritingTextureExtents() */
+
+
+/*******************************************************************
+*
+*   AssetFile_FindSoundSubsound()
+*
+*   DESCRIPTION:
+*       Find the subsound index of a sound in the bank pairs under
+*       read.  The pairs are kept as a hash table keyed by asset ID,
+*       so this looks at a slot or two in place rather than reading
+*       the table.  Fails if the sound is not in the bank.
+*
+*******************************************************************/
+
+b8 AssetFile_FindSoundSubsound( const AssetFileAssetId id, u32 *subsound_index, AssetFileReader *input )
+{
+if( ( input->kind != ASSET_FILE_ASSET_KIND_SOUND_SAMPLE
+   && input->kind != ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP )
+ || !input->asset_start
+ || id == ASSET_FILE_INVALID_ASSET_ID
+ || subsound_index == NULL )
+    {
+    return( FALSE );
+    }
+
+SoundPairsHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || header.slot_cnt & ( header.slot_cnt - 1 ) )
+    {
+    return( FALSE );
+    }
+
+u64 slots_start = input->asset_start + sizeof( header );
+u32 mask = header.slot_cnt - 1;
+u32 slot = id & mask;
+for( u32 i = 0; i < header.slot_cnt; i++, slot = ( slot + 1 ) & mask )
+    {
+    AssetFileSoundPair pair = {};
+    if( !read_struct_at( slots_start + slot * sizeof( pair ), &pair, input )
+     || pair.asset_id == ASSET_FILE_INVALID_ASSET_ID )
+        {
+        return( FALSE );
+        }
+    else if( pair.asset_id == id )
+        {
+        *subsound_index = pair.subsound_index;
+        return( TRUE );
+        }
+    }
+
+return( FALSE );
+
+} /* AssetFile_FindSoundSubsound() */
+
+
+/*******************************************************************
+*
+*   AssetFile_GetDedupSavings()
+*
+*   DESCRIPTION:
+*       Get how many assets shared an identical payload that was
+*       already written, and the bytes that saved.
+*
+*******************************************************************/
+
+b8 AssetFile_GetDedupSavings( u32 *asset_cnt, u64 *saved_sz, const AssetFileWriter *output )
+{
+if( asset_cnt == NULL
+ || saved_sz == NULL )
+    {
+    return( FALSE );
+    }
+
+*asset_cnt = output->shared_cnt;
+*saved_sz  = output->shared_sz;
+
+return( TRUE );
+
+} /* AssetFile_GetDedupSavings() */
+
+
+/*******************************************************************
+*
+*   AssetFile_GetLogicalWriteSize()
+*
+*   DESCRIPTION:
+*       Get the size the file would have had without payload
+*       sharing.  Use it to measure what an asset wrote, since a
+*       shared payload leaves the written size almost unchanged.
+*
+*******************************************************************/
+
+u64 AssetFile_GetLogicalWriteSize( const AssetFileWriter *output )
+{
+return( output->caret + output->shared_sz );
+
+} /* AssetFile_GetLogicalWriteSize() */
+
+
+/*******************************************************************
+*
+*   AssetFile_GetWriteSize()
+*
+*   DESCRIPTION:
+*       Get the current file written size.
+*
+*******************************************************************/
+
+u64 AssetFile_GetWriteSize( const AssetFileWriter *output )
+{
+return( output->caret );
+
+} /* AssetFile_GetWriteSize() */
+
+
+/*******************************************************************
+*
+*   AssetFile_LoadModel()
+*
+*   DESCRIPTION:
+*       Load the whole model under read into the caller's arena with
+*       a single read, and point the model's nodes, meshes and
+*       materials into it.  The arena must be pointer aligned and at
+*       least the size given by AssetFile_LoadModelStorageRequirements,
+*       and it outlives the asset under read.
+*
+*******************************************************************/
+
+b8 AssetFile_LoadModel( const u64 arena_sz, void *arena, AssetFileModel *model, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || arena == NULL
+ || model == NULL
+ || (uintptr_t)arena % sizeof( void* ) )
+    {
+    return( FALSE );
+    }
+
+*model = {};
+
+ModelHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+/* tables first, then the raw model blob that the meshes point into */
+u64 raw_sz = input->asset_row->raw_sz;
+u64 blob_offset = 0;
+if( arena_sz < GetModelArenaSize( &header, raw_sz, &blob_offset ) )
+    {
+    return( FALSE );
+    }
+
+AssetFileModelMesh *meshes = (AssetFileModelMesh*)arena;
+AssetFileModelNode *nodes = (AssetFileModelNode*)( meshes + header.mesh_count );
+AssetFileModelMaterial *materials = (AssetFileModelMaterial*)( nodes + header.node_count );
+byte *blob = (byte*)arena + blob_offset;
+if( !ReadAt( input->asset_start, raw_sz, blob, input ) )
+    {
+    return( FALSE );
+    }
+
+/* summed wide so corrupt counts cannot wrap past the size check */
+u64 meshes_end = (u64)header.material_cnt + header.mesh_count;
+u64 nodes_end = meshes_end + header.node_count;
+u64 element_cnt = nodes_end + header.meshlets_cnt;
+if( raw_sz < sizeof( ModelHeader )
+ || element_cnt > ( raw_sz - sizeof( ModelHeader ) ) / sizeof( ModelTableRow )
+ || ( header.meshlets_cnt != 0 && header.meshlets_cnt != header.mesh_count )
+ || header.root_node_element < meshes_end
+ || header.root_node_element >= nodes_end )
+    {
+    return( FALSE );
+    }
+
+/* Element table order is...
+ a) MATERIALS
+ b) MESHES
+ c) NODES
+ d) MESHLETS, if any */
+for( u64 i = 0; i < element_cnt; i++ )
+    {
+    ModelTableRow row = {};
+    memcpy( &row, blob + sizeof( ModelHeader ) + i * sizeof( ModelTableRow ), sizeof( row ) );
+    if( row.starts_at > raw_sz )
+        {
+        return( FALSE );
+        }
+
+    const byte *element = blob + row.starts_at;
+    u64 element_sz = raw_sz - row.starts_at;
+    if( i < header.material_cnt )
+        {
+        ModelMaterialHeader material = {};
+        if( row.kind != ASSET_FILE_MODEL_ELEMENT_KIND_MATERIAL
+         || element_sz < sizeof( material ) )
+            {
+            return( FALSE );
+            }
+
+        memcpy( &material, element, sizeof( material ) );
+
+        const byte *texture = element + sizeof( material );
+        AssetFileModelMaterial *out = &materials[ i ];
+        *out = {};
+        out->bits = material.map_bits;
+        for( u32 j = 0; j < ASSET_FILE_MODEL_TEXTURE_COUNT; j++ )
+            {
+            if( !( material.map_bits & ( 1 << j ) ) )
+                {
+                continue;
+                }
+
+            if( (u64)( texture + sizeof( AssetFileAssetId ) - element ) > element_sz )
+                {
+                return( FALSE );
+                }
+
+            memcpy( &out->textures[ j ], texture, sizeof( AssetFileAssetId ) );
+            texture += sizeof( AssetFileAssetId );
+            }
+        }
+    else if( i < meshes_end )
+        {
+        ModelMeshHeader mesh = {};
+        if( row.kind != ASSET_FILE_MODEL_ELEMENT_KIND_MESH
+         || element_sz < sizeof( mesh ) )
+            {
+            return( FALSE );
+            }
+
+        memcpy( &mesh, element, sizeof( mesh ) );
+
+        /* Geometry order is...
+         a) VERTICES
+         b) INDICES */
+        u64 vertices_sz = (u64)mesh.vertex_cnt * GetModelVertexSize( mesh.vertex_format );
+        u64 indices_sz  = ( (u64)mesh.index_cnt + mesh.lod_index_cnt ) * GetModelIndexSize( mesh.index_format );
+        if( GetModelVertexSize( mesh.vertex_format ) == 0
+         || GetModelIndexSize( mesh.index_format ) == 0
+         || !CheckModelMeshLods( &mesh )
+         || sizeof( mesh ) + vertices_sz + indices_sz > element_sz )
+            {
+            return( FALSE );
+            }
+
+        ConvertModelMesh( &mesh, element + sizeof( mesh ), &meshes[ i - header.material_cnt ] );
+        }
+    else if( i < nodes_end )
+        {
+        ModelNodeHeader node = {};
+        if( row.kind != ASSET_FILE_MODEL_ELEMENT_KIND_NODE
+         || element_sz < sizeof( node ) )
+            {
+            return( FALSE );
+            }
+
+        memcpy( &node, element, sizeof( node ) );
+
+        AssetFileModelIndex elements[ ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT + ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT ];
+        if( node.node_count > ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT
+         || node.mesh_count > ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT
+         || element_sz - sizeof( node ) < sizeof( *elements ) * ( node.node_count + node.mesh_count ) )
+            {
+            return( FALSE );
+            }
+
+        memcpy( elements, element + sizeof( node ), sizeof( *elements ) * ( node.node_count + node.mesh_count ) );
+        if( !ConvertModelNode( &header, &node, elements, &nodes[ i - meshes_end ] ) )
+            {
+            return( FALSE );
+            }
+        }
+    else
+        {
+        ModelMeshletsHeader meshlets = {};
+        if( row.kind != ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS
+         || element_sz < sizeof( meshlets ) )
+            {
+            return( FALSE );
+            }
+
+        memcpy( &meshlets, element, sizeof( meshlets ) );
+        if( !ConvertModelMeshlets( &meshlets, element + sizeof( meshlets ), element_sz - sizeof( meshlets ), &meshes[ i - nodes_end ].meshlets ) )
+            {
+            return( FALSE );
+            }
+        }
+    }
+
+model->node_count     = header.node_count;
+model->mesh_count     = header.mesh_count;
+model->material_count = header.material_cnt;
+model->root_node      = header.root_node_element - ( header.material_cnt + header.mesh_count );
+model->nodes          = nodes;
+model->meshes         = meshes;
+model->materials      = materials;
+
+return( TRUE );
+
+} /* AssetFile_LoadModel() */
+
+
+/*******************************************************************
+*
+*   AssetFile_LoadModelStorageRequirements()
+*
+*   DESCRIPTION:
+*       Get the arena size AssetFile_LoadModel needs for the model
+*       under read.
+*
+*******************************************************************/
+
+b8 AssetFile_LoadModelStorageRequirements( u64 *arena_sz, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || arena_sz == NULL )
+    {
+    return( FALSE );
+    }
+
+ModelHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+u64 blob_offset = 0;
+*arena_sz = GetModelArenaSize( &header, input->asset_row->raw_sz, &blob_offset );
+
+return( TRUE );
+
+} /* AssetFile_LoadModelStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapFontTexture()
+*
+*   DESCRIPTION:
+*       Get the font's texture dimensions and a pointer to its pixel
+*       data within the mapped asset file.  Requires the file to have
+*       been opened with AssetFile_OpenForReadMapped().
+*
+*******************************************************************/
+
+b8 AssetFile_MapFontTexture( const u8 **pixels, u32 *texture_sz, u16 *width, u16 *height, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_FONT
+ || !input->asset_start
+ || pixels == NULL
+ || texture_sz == NULL
+ || width == NULL
+ || height == NULL )
+    {
+    return( FALSE );
+    }
+
+FontHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*pixels = ViewAt( input->asset_start + header.texture_starts_at, header.texture_sz, input );
+if( *pixels == NULL )
+    {
+    return( FALSE );
+    }
+
+*texture_sz = header.texture_sz;
+*width      = header.texture_width;
+*height     = header.texture_height;
+
+return( TRUE );
+
+}   /* AssetFile_MapFontTexture() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapModelMesh()
+*
+*   DESCRIPTION:
+*       Describe the given model mesh with pointers to its vertices
+*       and indices, as stored, within the mapped asset file.  Packed
+*       vertices can go straight to the GPU, or be expanded with
+*       AssetFile_DequantizeModelVertices().
+*
+*******************************************************************/
+
+b8 AssetFile_MapModelMesh( const u32 mesh_index, AssetFileModelMesh *mesh, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || mesh == NULL )
+    {
+    return( FALSE );
+    }
+
+*mesh = {};
+
+ModelHeader header = {};
+u64 mesh_start = 0;
+ModelMeshHeader stored = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, mesh_index, &header, input, &mesh_start )
+ || !read_struct_at( mesh_start, &stored, input )
+ || GetModelVertexSize( stored.vertex_format ) == 0
+ || GetModelIndexSize( stored.index_format ) == 0
+ || !CheckModelMeshLods( &stored ) )
+    {
+    return( FALSE );
+    }
+
+/* Geometry order is... 
+ a) VERTICES
+ b) INDICES, full detail then the coarser levels */
+u64 geometry_sz = (u64)GetModelVertexSize( stored.vertex_format ) * stored.vertex_cnt
+                + (u64)GetModelIndexSize( stored.index_format ) * ( (u64)stored.index_cnt + stored.lod_index_cnt );
+const byte *geometry = ViewAt( mesh_start + sizeof( stored ), geometry_sz, input );
+if( geometry == NULL )
+    {
+    return( FALSE );
+    }
+
+ConvertModelMesh( &stored, geometry, mesh );
+return( TRUE );
+
+} /* AssetFile_MapModelMesh() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapModelMeshIndices()
+*
+*   DESCRIPTION:
+*       Get a pointer to the given model mesh's indices within the
+*       mapped asset file.  Fails for meshes stored with 16-bit
+*       indices, see AssetFile_MapModelMeshIndices2().
+*
+*******************************************************************/
+
+b8 AssetFile_MapModelMeshIndices( const u32 mesh_index, u32 *index_count, const AssetFileModelIndex **indices, AssetFileReader *input )
+{
+AssetFileModelIndexFormat index_format = ASSET_FILE_MODEL_INDEX_FORMAT_U32;
+const void *view = NULL;
+if( indices == NULL
+ || index_count == NULL
+ || !AssetFile_MapModelMeshIndices2( mesh_index, index_count, &index_format, &view, input ) )
+    {
+    return( FALSE );
+    }
+
+if( index_format != ASSET_FILE_MODEL_INDEX_FORMAT_U32 )
+    {
+    *index_count = 0;
+    return( FALSE );
+    }
+
+*indices = (const AssetFileModelIndex*)view;
+return( TRUE );
+
+} /* AssetFile_MapModelMeshIndices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapModelMeshIndices2()
+*
+*   DESCRIPTION:
+*       Get a pointer to the given model mesh's indices within the
+*       mapped asset file, as stored.  Each index is a u16 or u32
+*       according to the output format.
+*
+*******************************************************************/
+
+b8 AssetFile_MapModelMeshIndices2( const u32 mesh_index, u32 *index_count, AssetFileModelIndexFormat *index_format, const void **indices, AssetFileReader *input )
+{
+if( indices == NULL
+ || index_count == NULL
+ || index_format == NULL )
+    {
+    return( FALSE );
+    }
+
+*index_count = 0;
+
+AssetFileModelMesh mesh = {};
+if( !AssetFile_MapModelMesh( mesh_index, &mesh, input ) )
+    {
+    return( FALSE );
+    }
+
+*indices      = mesh.indices;
+*index_count  = mesh.index_count;
+*index_format = mesh.index_format;
+return( TRUE );
+
+} /* AssetFile_MapModelMeshIndices2() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapModelMeshlets()
+*
+*   DESCRIPTION:
+*       Point at the given model mesh's meshlets within the mapped
+*       asset file.
+*
+*******************************************************************/
+
+b8 AssetFile_MapModelMeshlets( const u32 mesh_index, AssetFileModelMeshlets *meshlets, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || meshlets == NULL )
+    {
+    return( FALSE );
+    }
+
+*meshlets = {};
+
+ModelHeader header = {};
+u64 meshlets_start = 0;
+ModelMeshletsHeader stored = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS, mesh_index, &header, input, &meshlets_start )
+ || !read_struct_at( meshlets_start, &stored, input ) )
+    {
+    return( FALSE );
+    }
+
+/* Meshlet order is...
+ a) MESHLETS
+ b) VERTICES
+ c) TRIANGLES */
+u64 data_sz = (u64)stored.meshlet_cnt * sizeof( AssetFileModelMeshlet )
+            + (u64)stored.vertex_cnt * sizeof( u32 )
+            + (u64)stored.triangle_cnt * 3;
+const byte *data = ViewAt( meshlets_start + sizeof( stored ), data_sz, input );
+if( data == NULL )
+    {
+    return( FALSE );
+    }
+
+return( ConvertModelMeshlets( &stored, data, data_sz, meshlets ) );
+
+} /* AssetFile_MapModelMeshlets() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapModelMeshVertices()
+*
+*   DESCRIPTION:
+*       Get a pointer to the given model mesh's vertices within the
+*       mapped asset file.  Fails for meshes stored with packed
+*       vertices, see AssetFile_MapModelMesh().
+*
+*******************************************************************/
+
+b8 AssetFile_MapModelMeshVertices( const u32 mesh_index, AssetFileModelIndex *material_index, u32 *vertex_count, const AssetFileModelVertex **vertices, AssetFileReader *input )
+{
+if( vertices == NULL
+ || vertex_count == NULL )
+    {
+    return( FALSE );
+    }
+
+*vertex_count = 0;
+
+AssetFileModelMesh mesh = {};
+if( !AssetFile_MapModelMesh( mesh_index, &mesh, input )
+ || mesh.vertex_format != ASSET_FILE_MODEL_VERTEX_FORMAT_F32 )
+    {
+    return( FALSE );
+    }
+
+*vertices = (const AssetFileModelVertex*)mesh.vertices;
+if( material_index )
+    {
+    *material_index = mesh.material;
+    }
+
+*vertex_count = mesh.vertex_count;
+return( TRUE );
+
+} /* AssetFile_MapModelMeshVertices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapShaderBinary()
+*
+*   DESCRIPTION:
+*       Get a pointer to the binary code for the shader under read
+*       within the mapped asset file.
+*
+*******************************************************************/
+
+b8 AssetFile_MapShaderBinary( u32 *byte_size, const byte **buffer, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_SHADER
+ || !input->asset_start
+ || byte_size == NULL
+ || buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+ShaderHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*buffer = ViewAt( input->asset_start + sizeof( header ), header.byte_size, input );
+if( *buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+*byte_size = header.byte_size;
+return( TRUE );
+
+} /* AssetFile_MapShaderBinary() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapTerrainLodIndices()
+*
+*   DESCRIPTION:
+*       Get a pointer to an index pattern of the terrain under read
+*       within the mapped asset file.
+*
+*******************************************************************/
+
+b8 AssetFile_MapTerrainLodIndices( const u32 lod_index, u32 *index_count, const u32 **indices, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || index_count == NULL
+ || indices == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || header.lod_cnt > ASSET_FILE_TERRAIN_LOD_MAX_COUNT
+ || lod_index >= header.lod_cnt )
+    {
+    return( FALSE );
+    }
+
+const TerrainLod *lod = &header.lods[ lod_index ];
+*indices = (const u32*)ViewAt( input->asset_start + lod->starts_at, (u64)lod->index_cnt * sizeof( **indices ), input );
+*index_count = lod->index_cnt;
+
+return( *indices != NULL );
+
+} /* AssetFile_MapTerrainLodIndices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapTerrainTile()
+*
+*   DESCRIPTION:
+*       Get a pointer to the height samples of a tile of the terrain
+*       under read within the mapped asset file, rows of increasing
+*       z each running in increasing x.  Only tiles stored
+*       uncompressed can be mapped; read the others with
+*       AssetFile_ReadTerrainTile().
+*
+*******************************************************************/
+
+b8 AssetFile_MapTerrainTile( const u32 x, const u32 z, const u16 **samples, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || x >= ASSET_FILE_TERRAIN_AXES_CNT
+ || z >= ASSET_FILE_TERRAIN_AXES_CNT
+ || samples == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainTile tile = {};
+if( !read_struct_at( input->asset_start + sizeof( TerrainHeader ) + GetTerrainTileSlot( x, z ) * sizeof( tile ), &tile, input )
+ || !tile.starts_at
+ || tile.codec != ASSET_FILE_TERRAIN_TILE_RAW
+ || tile.byte_size != ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT * sizeof( **samples ) )
+    {
+    return( FALSE );
+    }
+
+*samples = (const u16*)ViewAt( input->asset_start + tile.starts_at + ASSET_FILE_TERRAIN_SAMPLES_OFFSET, tile.byte_size, input );
+
+return( *samples != NULL );
+
+} /* AssetFile_MapTerrainTile() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapTerrainTileMinMax()
+*
+*   DESCRIPTION:
+*       Get a pointer to the min/max pyramid of a tile of the terrain
+*       under read within the mapped asset file.  Cells are found
+*       with AssetFile_GetTerrainMinMaxIndex().
+*
+*******************************************************************/
+
+b8 AssetFile_MapTerrainTileMinMax( const u32 x, const u32 z, const AssetFileTerrainMinMax **min_max, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || x >= ASSET_FILE_TERRAIN_AXES_CNT
+ || z >= ASSET_FILE_TERRAIN_AXES_CNT
+ || min_max == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainTile tile = {};
+if( !read_struct_at( input->asset_start + sizeof( TerrainHeader ) + GetTerrainTileSlot( x, z ) * sizeof( tile ), &tile, input )
+ || !tile.starts_at )
+    {
+    return( FALSE );
+    }
+
+*min_max = (const AssetFileTerrainMinMax*)ViewAt( input->asset_start + tile.starts_at, ASSET_FILE_TERRAIN_MINMAX_CNT * sizeof( **min_max ), input );
+
+return( *min_max != NULL );
+
+} /* AssetFile_MapTerrainTileMinMax() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapTextureBinary()
+*
+*   DESCRIPTION:
+*       Get a pointer to the image data for the texture under read
+*       within the mapped asset file.
+*
+*******************************************************************/
+
+b8 AssetFile_MapTextureBinary( u32 *byte_size, const byte **buffer, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || byte_size == NULL
+ || buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*buffer = ViewAt( input->asset_start + sizeof( header ), header.byte_size, input );
+if( *buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+*byte_size = header.byte_size;
+return( TRUE );
+
+} /* AssetFile_MapTextureBinary() */
+
+
+/*******************************************************************
+*
+*   AssetFile_MapTextureMip()
+*
+*   DESCRIPTION:
+*       Get a pointer to one mip level of the texture under read
+*       within the mapped asset file.
+*
+*******************************************************************/
+
+b8 AssetFile_MapTextureMip( const u32 mip_index, u32 *byte_size, const byte **buffer, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || byte_size == NULL
+ || buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || mip_index >= header.mip_cnt )
+    {
+    return( FALSE );
+    }
+
+const TextureMip *mip = &header.mips[ mip_index ];
+*buffer = ViewAt( input->asset_start + mip->starts_at, mip->byte_size, input );
+if( *buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+*byte_size = mip->byte_size;
+return( TRUE );
+
+} /* AssetFile_MapTextureMip() */
+
+
+/*******************************************************************
+*
+*   AssetFile_OpenForRead()
+*
+*   DESCRIPTION:
+*       Open the asset file for read-only, and load its asset table
+*       so lookups can be resolved in memory.
+*
+*******************************************************************/
+
+b8 AssetFile_OpenForRead( const char *filename, AssetFileReader *input )
+{
+*input = {};
+
+AssetFilePack *pack = (AssetFilePack*)malloc( sizeof( AssetFilePack ) );
+if( pack == NULL )
+    {
+    return( FALSE );
+    }
+
+if( !AssetFile_OpenPack( filename, pack ) )
+    {
+    free( pack );
+    return( FALSE );
+    }
+
+input->pack       = pack;
+input->owned_pack = pack;
+
+return( TRUE );
+
+} /* AssetFile_OpenForRead() */
+
+
+/*******************************************************************
+*
+*   AssetFile_OpenForReadFromPack()
+*
+*   DESCRIPTION:
+*       Open a reader over an already open pack.  Readers only hold
+*       their own asset under read, so each thread may use its own
+*       reader over one pack without locking.
+*
+*******************************************************************/
+
+b8 AssetFile_OpenForReadFromPack( const AssetFilePack *pack, AssetFileReader *input )
+{
+*input = {};
+if( pack == NULL
+ || pack->table_keys == NULL )
+    {
+    return( FALSE );
+    }
+
+input->pack = pack;
+
+return( TRUE );
+
+} /* AssetFile_OpenForReadFromPack() */
+
+
+/*******************************************************************
+*
+*   AssetFile_OpenForReadMapped()
+*
+*   DESCRIPTION:
+*       Open the asset file for read-only, and map it into memory so
+*       that the AssetFile_Map* functions may hand out pointers
+*       directly into the file.  All other reads are also served
+*       from the mapping.
+*
+*******************************************************************/
+
+b8 AssetFile_OpenForReadMapped( const char *filename, AssetFileReader *input )
+{
+*input = {};
+
+AssetFilePack *pack = (AssetFilePack*)malloc( sizeof( AssetFilePack ) );
+if( pack == NULL )
+    {
+    return( FALSE );
+    }
+
+if( !AssetFile_OpenPackMapped( filename, pack ) )
+    {
+    free( pack );
+    return( FALSE );
+    }
+
+input->pack       = pack;
+input->owned_pack = pack;
+
+return( TRUE );
+
+} /* AssetFile_OpenForReadMapped() */
+
+
+/*******************************************************************
+*
+*   AssetFile_OpenLoader()
+*
+*   DESCRIPTION:
+*       Open the asset file on a loader thread of its own, which
+*       serves submitted loads in the background.  The loader must
+*       not move in memory until it is closed.
+*
+*******************************************************************/
+
+b8 AssetFile_OpenLoader( const char *filename, AssetFileLoader *loader )
+{
+*loader = {};
+if( !AssetFile_OpenForRead( filename, &loader->input ) )
+    {
+    return( FALSE );
+    }
+
+loader->queue = new AssetFileLoaderQueue();
+loader->queue->thread = std::thread( RunLoader, loader );
+
+return( TRUE );
+
+} /* AssetFile_OpenLoader() */
+
+
+/*******************************************************************
+*
+*   AssetFile_OpenPack()
+*
+*   DESCRIPTION:
+*       Open the asset file for read-only, and load its asset table.
+*       The pack is not changed again until closed, and all file
+*       reads are positional, so any number of readers on any number
+*       of threads may share it.
+*
+*******************************************************************/
+
+b8 AssetFile_OpenPack( const char *filename, AssetFilePack *pack )
+{
+*pack = {};
+if( !file_open( filename, "rb", &pack->hnd ) )
+    {
+    return( FALSE );
+    }
+
+AssetFileHeader file_header = {};
+if( !file_open_read_at( filename, &pack->read_hnd )
+ || !file_read_at( pack->hnd, pack->read_hnd, 0, sizeof( file_header ), &file_header )
+ || file_header.magic != ASSET_FILE_MAGIC
+ || file_header.version != ASSET_FILE_VERSION )
+    {
+    ensure( AssetFile_ClosePack( pack ) );
+    return( FALSE );
+    }
+
+pack->table_cnt = file_header.table_cnt;
+if( !LoadTable( pack ) )
+    {
+    ensure( AssetFile_ClosePack( pack ) );
+    return( FALSE );
+    }
+
+return( TRUE );
+
+} /* AssetFile_OpenPack() */
+
+
+/*******************************************************************
+*
+*   AssetFile_OpenPackMapped()
+*
+*   DESCRIPTION:
+*       Open the asset file as a pack, and map it into memory so its
+*       readers are served from the mapping.
+*
+*******************************************************************/
+
+b8 AssetFile_OpenPackMapped( const char *filename, AssetFilePack *pack )
+{
+if( !AssetFile_OpenPack( filename, pack ) )
+    {
+    return( FALSE );
+    }
+
+const void *view = NULL;
+if( !file_map( pack->hnd, &view, &pack->map_sz, &pack->map_hnd ) )
+    {
+    ensure( AssetFile_ClosePack( pack ) );
+    return( FALSE );
+    }
+
+pack->map = (const byte*)view;
+
+/* serve the table rows straight from the mapping */
+u64 table_end = sizeof( AssetFileHeader ) + (u64)pack->table_cnt * sizeof( AssetFileTableRow );
+if( table_end <= pack->map_sz )
+    {
+    free( pack->table_mem );
+    pack->table_mem = NULL;
+    pack->table     = (const AssetFileTableRow*)( pack->map + sizeof( AssetFileHeader ) );
+    }
+
+return( TRUE );
+
+} /* AssetFile_OpenPackMapped() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadFontGlyphs()
+*
+*   DESCRIPTION:
+*       Read and output a font's glyph data.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadFontGlyphs( const u16 glyph_capacity, AssetFileFontGlyph *glyphs, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_FONT
+ || !input->asset_start
+ || glyphs == NULL )
+    {
+    return( FALSE );
+    }
+
+FontHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+if( glyph_capacity < header.glyph_cnt )
+    {
+    return( FALSE );
+    }
+
+f32 width_scale  = 1.0f / (f32)header.oversample_x;
+f32 height_scale = 1.0f / (f32)header.oversample_y;
+
+u64 glyph_start = input->asset_start + header.glyphs_starts_at;
+for( u32 i = 0; i < header.glyph_cnt; i++ )
+    {
+    FontGlyphHeader glyph = {};
+    if( !read_struct_at( glyph_start, &glyph, input ) )
+        {
+        return( FALSE );
+        }
+
+    glyph_start += sizeof( glyph );
+
+    AssetFileFontGlyph *out = glyphs + i;
+    
+    out->glyph          = glyph.glyph;
+    out->width          = width_scale  * ( glyph.u1 - glyph.u0 );
+    out->height         = height_scale * ( glyph.v1 - glyph.v0 );
+    out->top_left_x     = glyph.pen_offset_x;
+    out->top_left_y     = glyph.pen_offset_y;
+    out->bottom_right_x = out->top_left_x + out->width;
+    out->bottom_right_y = out->top_left_y + out->height;
+    out->u0             = (f32)glyph.u0 / header.texture_width;
+    out->v0             = (f32)glyph.v0 / header.texture_height;
+    out->u1             = (f32)glyph.u1 / header.texture_width;
+    out->v1             = (f32)glyph.v1 / header.texture_height;
+    out->h_advance      = glyph.h_advance;
+    }
+
+return( TRUE );
+
+}   /* AssetFile_ReadFontGlyphs() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadFontTexture()
+*
+*   DESCRIPTION:
+*       Read the font's texture dimensions and pixel data.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadFontTexture( const u32 buffer_sz, u8 *pixels, u16 *width, u16 *height, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_FONT
+ || !input->asset_start
+ || pixels == NULL
+ || width == NULL
+ || height == NULL )
+    {
+    return( FALSE );
+    }
+
+FontHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || buffer_sz < header.texture_sz )
+    {
+    return( FALSE );
+    }
+
+*width  = header.texture_width;
+*height = header.texture_height;
+
+if( !ReadAt( input->asset_start + header.texture_starts_at, header.texture_sz, pixels, input ) )
+    {
+    return( FALSE );
+    }
+
+return( TRUE );
+
+}   /* AssetFile_ReadFontTexture() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadFontStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the storage needed to query a font.
 *
 *******************************************************************/
 
 b8 AssetFile_ReadFontStorageRequirements( u16 *glyph_cnt, u32 *texture_sz, AssetFileReader *input )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_FONT
- || !input->asset_start
- || glyph_cnt == NULL
- || texture_sz == NULL )
+if( input->kind != ASSET_FILE_ASSET_KIND_FONT
+ || !input->asset_start
+ || glyph_cnt == NULL
+ || texture_sz == NULL )
+    {
+    return( FALSE );
+    }
+
+FontHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*glyph_cnt  = header.glyph_cnt;
+*texture_sz = header.texture_sz;
+
+return( TRUE );
+
+}   /* AssetFile_ReadFontStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMaterials()
+*
+*   DESCRIPTION:
+*       Read and output the given model's materials.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMaterials( const u32 material_capacity, u32 *material_count, AssetFileModelMaterial *materials, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || materials == NULL
+ || material_count == NULL )
+    {
+    return( FALSE );
+    }
+
+*material_count = 0;
+
+ModelHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+if( header.material_cnt > material_capacity )
+    {
+    return( FALSE );
+    }
+
+for( u32 i = 0; i < header.material_cnt; i++ )
+    {
+    materials[ i ] = {};
+
+    u64 material_start = 0;
+    ModelMaterialHeader material = {};
+    if( !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MATERIAL, i, &header, input, &material_start )
+     || !read_struct_at( material_start, &material, input ) )
+        {
+        return( FALSE );
+        }
+
+    u64 element_start = material_start + sizeof( material );
+
+    materials[ i ].bits = material.map_bits;
+    for( u32 j = 0; j < ASSET_FILE_MODEL_TEXTURE_COUNT; j++ )
+        {
+        if( !( material.map_bits & ( 1 << j ) ) )
+            {
+            continue;
+            }
+
+        AssetFileAssetId element;
+        if( !read_struct_at( element_start, &element, input ) )
+            {
+            return( FALSE );
+            }
+
+        element_start += sizeof( element );
+        materials[ i ].textures[ j ] = element;
+        }
+
+    }
+
+*material_count = header.material_cnt;
+return( TRUE );
+
+} /* AssetFile_ReadModelMaterials() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshBounds()
+*
+*   DESCRIPTION:
+*       Output the given model mesh's bounds without touching its
+*       geometry.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshBounds( const u32 mesh_index, AssetFileModelBounds *bounds, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || bounds == NULL )
+    {
+    return( FALSE );
+    }
+
+ModelHeader header = {};
+u64 mesh_start = 0;
+ModelMeshHeader mesh = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, mesh_index, &header, input, &mesh_start )
+ || !read_struct_at( mesh_start, &mesh, input ) )
+    {
+    return( FALSE );
+    }
+
+*bounds = mesh.bounds;
+return( TRUE );
+
+} /* AssetFile_ReadModelMeshBounds() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshIndices()
+*
+*   DESCRIPTION:
+*       Read and output the given model mesh's indices, widening
+*       any stored at 16 bits.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshIndices( const u32 mesh_index, const u32 index_capacity, u32 *index_count, AssetFileModelIndex *indices, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || indices == NULL
+ || index_count == NULL )
+    {
+    return( FALSE );
+    }
+
+*index_count = 0;
+
+ModelHeader header = {};
+u64 mesh_start = 0;
+ModelMeshHeader mesh = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, mesh_index, &header, input, &mesh_start )
+ || !read_struct_at( mesh_start, &mesh, input ) )
+    {
+    return( FALSE );
+    }
+
+if( index_capacity < mesh.index_cnt
+ || !ReadModelMeshIndexRange( mesh_start, &mesh, 0, mesh.index_cnt, indices, input ) )
+    {
+    return( FALSE );
+    }
+
+*index_count = mesh.index_cnt;
+return( TRUE );
+
+} /* AssetFile_ReadModelMeshIndices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshlets()
+*
+*   DESCRIPTION:
+*       Read and output the given model mesh's meshlets, with their
+*       vertex and triangle lists.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshlets( const u32 mesh_index, const u32 meshlet_capacity, AssetFileModelMeshlet *meshlets, const u32 vertex_capacity, u32 *vertices, const u32 triangle_capacity, u8 *triangles, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || meshlets == NULL
+ || vertices == NULL
+ || triangles == NULL )
+    {
+    return( FALSE );
+    }
+
+ModelHeader header = {};
+u64 meshlets_start = 0;
+ModelMeshletsHeader stored = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS, mesh_index, &header, input, &meshlets_start )
+ || !read_struct_at( meshlets_start, &stored, input )
+ || meshlet_capacity < stored.meshlet_cnt
+ || vertex_capacity < stored.vertex_cnt
+ || triangle_capacity < stored.triangle_cnt )
+    {
+    return( FALSE );
+    }
+
+/* Meshlet order is...
+ a) MESHLETS
+ b) VERTICES
+ c) TRIANGLES */
+u64 meshlets_sz = (u64)stored.meshlet_cnt * sizeof( *meshlets );
+u64 vertices_sz = (u64)stored.vertex_cnt * sizeof( *vertices );
+u64 location = meshlets_start + sizeof( stored );
+
+return( ReadAt( location, meshlets_sz, meshlets, input )
+     && ReadAt( location + meshlets_sz, vertices_sz, vertices, input )
+     && ReadAt( location + meshlets_sz + vertices_sz, (u64)stored.triangle_cnt * 3, triangles, input ) );
+
+} /* AssetFile_ReadModelMeshlets() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshletsStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the sizes of the given model mesh's meshlet lists.
+*       Fails if the model was written without meshlets.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshletsStorageRequirements( const u32 mesh_index, u32 *meshlet_count, u32 *vertex_count, u32 *triangle_count, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || meshlet_count == NULL
+ || vertex_count == NULL
+ || triangle_count == NULL )
+    {
+    return( FALSE );
+    }
+
+ModelHeader header = {};
+u64 meshlets_start = 0;
+ModelMeshletsHeader stored = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS, mesh_index, &header, input, &meshlets_start )
+ || !read_struct_at( meshlets_start, &stored, input ) )
+    {
+    return( FALSE );
+    }
+
+*meshlet_count  = stored.meshlet_cnt;
+*vertex_count   = stored.vertex_cnt;
+*triangle_count = stored.triangle_cnt;
+
+return( TRUE );
+
+} /* AssetFile_ReadModelMeshletsStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshLodIndices()
+*
+*   DESCRIPTION:
+*       Read and output the indices of one of the given model mesh's
+*       coarser levels of detail, widening any stored at 16 bits.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshLodIndices( const u32 mesh_index, const u32 lod_index, const u32 index_capacity, u32 *index_count, AssetFileModelIndex *indices, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || indices == NULL
+ || index_count == NULL )
+    {
+    return( FALSE );
+    }
+
+*index_count = 0;
+
+ModelHeader header = {};
+u64 mesh_start = 0;
+ModelMeshHeader mesh = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, mesh_index, &header, input, &mesh_start )
+ || !read_struct_at( mesh_start, &mesh, input )
+ || !CheckModelMeshLods( &mesh )
+ || lod_index >= mesh.lod_cnt )
+    {
+    return( FALSE );
+    }
+
+const AssetFileModelMeshLod *lod = &mesh.lods[ lod_index ];
+if( index_capacity < lod->index_count
+ || !ReadModelMeshIndexRange( mesh_start, &mesh, lod->index_offset, lod->index_count, indices, input ) )
+    {
+    return( FALSE );
+    }
+
+*index_count = lod->index_count;
+return( TRUE );
+
+} /* AssetFile_ReadModelMeshLodIndices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshLods()
+*
+*   DESCRIPTION:
+*       Output the given model mesh's coarser levels of detail, finest
+*       first.  The output holds ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshLods( const u32 mesh_index, u32 *lod_count, AssetFileModelMeshLod *lods, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || lod_count == NULL
+ || lods == NULL )
+    {
+    return( FALSE );
+    }
+
+ModelHeader header = {};
+u64 mesh_start = 0;
+ModelMeshHeader mesh = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, mesh_index, &header, input, &mesh_start )
+ || !read_struct_at( mesh_start, &mesh, input )
+ || !CheckModelMeshLods( &mesh ) )
+    {
+    return( FALSE );
+    }
+
+*lod_count = mesh.lod_cnt;
+memcpy( lods, mesh.lods, mesh.lod_cnt * sizeof( *lods ) );
+
+return( TRUE );
+
+} /* AssetFile_ReadModelMeshLods() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelMeshVertices()
+*
+*   DESCRIPTION:
+*       Read and output the given model mesh's vertices, expanding
+*       any stored packed.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelMeshVertices( const u32 mesh_index, const u32 vertex_capacity, AssetFileModelIndex *material_index, u32 *vertex_count, AssetFileModelVertex *vertices, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || vertices == NULL
+ || vertex_count == NULL )
+    {
+    return( FALSE );
+    }
+
+*vertex_count = 0;
+
+ModelHeader header = {};
+u64 mesh_start = 0;
+ModelMeshHeader mesh = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, mesh_index, &header, input, &mesh_start )
+ || !read_struct_at( mesh_start, &mesh, input ) )
+    {
+    return( FALSE );
+    }
+
+u32 vertex_sz = GetModelVertexSize( mesh.vertex_format );
+if( vertex_capacity < mesh.vertex_cnt
+ || vertex_sz == 0 )
+    {
+    return( FALSE );
+    }
+
+if( material_index )
+    {
+    *material_index = (AssetFileModelIndex)mesh.material;
+    }
+    
+/* Geometry order is... 
+ a) VERTICES <-- Look here
+ b) INDICES */
+if( mesh.vertex_format == ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED )
+    {
+    /* read to the back of the output, where expanding front to back never overtakes the packed data */
+    byte *packed = (byte*)vertices + ( sizeof( *vertices ) - vertex_sz ) * mesh.vertex_cnt;
+    if( !ReadAt( mesh_start + sizeof( mesh ), (u64)vertex_sz * mesh.vertex_cnt, packed, input ) )
+        {
+        return( FALSE );
+        }
+
+    DequantizeVertices( (const AssetFileModelPackedVertex*)packed, mesh.vertex_cnt, mesh.position_offset, mesh.position_scale, vertices );
+    }
+else if( !ReadAt( mesh_start + sizeof( mesh ), sizeof( *vertices ) * mesh.vertex_cnt, vertices, input ) )
+    {
+    return( FALSE );
+    }
+
+*vertex_count = mesh.vertex_cnt;
+return( TRUE );
+
+} /* AssetFile_ReadModelMeshVertices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelNodes()
+*
+*   DESCRIPTION:
+*       Read and output the model-under-read's node tree.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelNodes( const u32 node_capacity, u32 *node_count, AssetFileModelNode *nodes, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start
+ || nodes == NULL )
+    {
+    return( FALSE );
+    }
+
+*node_count = 0;
+
+ModelHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+if( header.node_count > node_capacity )
+    {
+    return( FALSE );
+    }
+
+for( u32 i = 0; i < header.node_count; i++ )
+    {
+    nodes[ i ] = {};
+
+    u64 node_start = 0;
+    ModelNodeHeader node = {};
+    if( !FindModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_NODE, i, &header, input, &node_start )
+     || !read_struct_at( node_start, &node, input ) )
+        {
+        return( FALSE );
+        }
+
+    if( node.node_count > ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT
+     || node.mesh_count > ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT )
+        {
+        return( FALSE );
+        }
+
+    AssetFileModelIndex elements[ ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT + ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT ];
+    if( !ReadAt( node_start + sizeof( node ), sizeof( *elements ) * ( node.node_count + node.mesh_count ), elements, input )
+     || !ConvertModelNode( &header, &node, elements, &nodes[ i ] ) )
+        {
+        return( FALSE );
+        }
+    }
+
+*node_count = header.node_count;
+
+return( TRUE );
+
+} /* AssetFile_ReadModelNodes() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadModelStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the count of each of the model's elements.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadModelStorageRequirements( u32 *vertex_count, u32 *index_count, u32 *mesh_count, u32 *node_count, u32 *material_count, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !input->asset_start )
+    {
+    return( FALSE );
+    }
+
+ModelHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+if( vertex_count )
+    {
+    *vertex_count = header.total_vertex_count;
+    }
+
+if( index_count )
+    {
+    *index_count = header.total_index_count;
+    }
+
+if( mesh_count )
+    {
+    *mesh_count = header.mesh_count;
+    }
+
+if( node_count )
+    {
+    *node_count = header.node_count;
+    }
+
+if( material_count )
+    {
+    *material_count = header.material_cnt;
+    }
+
+return( TRUE );
+
+} /* AssetFile_ReadModelStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadShaderBinary()
+*
+*   DESCRIPTION:
+*       Read the binary code for the shader under read, and copy it
+*       into the given buffer.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadShaderBinary( const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_SHADER
+ || !input->asset_start
+ || buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+ShaderHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || buffer_sz < header.byte_size )
+    {
+    return( FALSE );
+    }
+    
+if( !ReadAt( input->asset_start + sizeof( header ), header.byte_size, buffer, input ) )
+    {
+    return( FALSE );
+    }
+
+if( read_sz != NULL )
+    {
+    *read_sz = header.byte_size;
+    }
+
+return( TRUE );
+
+} /* AssetFile_ReadShaderBinary() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadShaderStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the buffer size required for the shader under read.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadShaderStorageRequirements( u32 *byte_count, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_SHADER
+ || !input->asset_start
+ || byte_count == NULL )
+    {
+    return( FALSE );
+    }
+
+ShaderHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*byte_count = header.byte_size;
+return( TRUE );
+
+} /* AssetFile_ReadShaderStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadSoundPairs()
+*
+*   DESCRIPTION:
+*       Read the binary and return the sound pairs data. 
+*       Works for both sample and music pairs.  The pairs come out
+*       in hash table order; look up single sounds with
+*       AssetFile_FindSoundSubsound() instead.
+*       
+*******************************************************************/
+
+b8 AssetFile_ReadSoundPairs( const u32 num_pairs, AssetFileSoundPair *sound_pairs, AssetFileReader *input )
+{
+SoundPairsHeader header = {};
+if( ( input->kind != ASSET_FILE_ASSET_KIND_SOUND_SAMPLE
+   && input->kind != ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP )
+ || !input->asset_start
+ || sound_pairs == NULL
+ || !read_struct_at( input->asset_start, &header, input )
+ || num_pairs < header.pair_cnt )
+    {
+    return( FALSE );
+    }
+
+/* gather the filled slots a batch at a time */
+AssetFileSoundPair batch[ 256 ];
+u32 pair_cnt = 0;
+const u32 batch_cap = (u32)_countof( batch );
+for( u32 first = 0; first < header.slot_cnt; first += batch_cap )
+    {
+    u32 batch_cnt = header.slot_cnt - first < batch_cap ? header.slot_cnt - first : batch_cap;
+    ensure( ReadAt( input->asset_start + sizeof( header ) + first * sizeof( *batch ), batch_cnt * sizeof( *batch ), batch, input ) );
+    for( u32 i = 0; i < batch_cnt; i++ )
+        {
+        if( batch[ i ].asset_id == ASSET_FILE_INVALID_ASSET_ID )
+            {
+            continue;
+            }
+        else if( pair_cnt >= header.pair_cnt )
+            {
+            return( FALSE );
+            }
+
+        sound_pairs[ pair_cnt++ ] = batch[ i ];
+        }
+    }
+
+return( pair_cnt == header.pair_cnt );
+   
+} /* AssetFile_ReadSoundPairs() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadSoundPairsStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the array size required for the sound paired asset ID/index data.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadSoundPairsStorageRequirements( u32 *num_elements, AssetFileReader *input )
+{
+if( ( input->kind != ASSET_FILE_ASSET_KIND_SOUND_SAMPLE
+   && input->kind != ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP )
+ || !input->asset_start
+ || num_elements == NULL )
+    {
+    return( FALSE );
+    }
+
+SoundPairsHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*num_elements = header.pair_cnt;
+
+return( TRUE );
+
+} /* AssetFile_ReadSoundPairsStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTerrainLodIndices()
+*
+*   DESCRIPTION:
+*       Read an index pattern of the terrain under read.  Indices are
+*       of samples within a tile, z * extent + x, and triangles wind
+*       counter-clockwise seen from above.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTerrainLodIndices( const u32 lod_index, const u32 index_capacity, u32 *index_count, u32 *indices, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || index_count == NULL
+ || indices == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || header.lod_cnt > ASSET_FILE_TERRAIN_LOD_MAX_COUNT
+ || lod_index >= header.lod_cnt
+ || header.lods[ lod_index ].index_cnt > index_capacity )
+    {
+    return( FALSE );
+    }
+
+const TerrainLod *lod = &header.lods[ lod_index ];
+*index_count = lod->index_cnt;
+
+return( ReadAt( input->asset_start + lod->starts_at, (u64)lod->index_cnt * sizeof( *indices ), indices, input ) );
+
+} /* AssetFile_ReadTerrainLodIndices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTerrainLods()
+*
+*   DESCRIPTION:
+*       Output the terrain's LOD index patterns, finest first.  The
+*       output holds ASSET_FILE_TERRAIN_LOD_MAX_COUNT.  The patterns
+*       keep every sample along the tile edges, so neighbouring tiles
+*       at any mix of levels meet without cracks.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTerrainLods( u32 *lod_count, AssetFileTerrainLod *lods, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || lod_count == NULL
+ || lods == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || header.lod_cnt > ASSET_FILE_TERRAIN_LOD_MAX_COUNT )
+    {
+    return( FALSE );
+    }
+
+*lod_count = header.lod_cnt;
+for( u32 i = 0; i < header.lod_cnt; i++ )
+    {
+    lods[ i ].step        = header.lods[ i ].step;
+    lods[ i ].index_count = header.lods[ i ].index_cnt;
+    }
+
+return( TRUE );
+
+} /* AssetFile_ReadTerrainLods() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTerrainStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the number of tiles in the terrain under read, and the
+*       number of height samples in each.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTerrainStorageRequirements( u32 *tile_count, u32 *sample_count, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || tile_count == NULL
+ || sample_count == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || header.sample_extent != ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT
+ || header.axes_cnt != ASSET_FILE_TERRAIN_AXES_CNT )
+    {
+    return( FALSE );
+    }
+
+*tile_count   = header.tile_cnt;
+*sample_count = ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT;
+
+return( TRUE );
+
+} /* AssetFile_ReadTerrainStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTerrainTile()
+*
+*   DESCRIPTION:
+*       Read the height samples of a tile of the terrain under read.
+*       The tile's directory entry sits at a fixed place given by
+*       its coordinates, so this is one small read and the samples.
+*       Compressed tiles are decoded straight into the samples.
+*       Fails if the tile was never written.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTerrainTile( const u32 x, const u32 z, const u32 sample_capacity, u16 *samples, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || x >= ASSET_FILE_TERRAIN_AXES_CNT
+ || z >= ASSET_FILE_TERRAIN_AXES_CNT
+ || samples == NULL
+ || sample_capacity < ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT )
+    {
+    return( FALSE );
+    }
+
+TerrainTile tile = {};
+if( !read_struct_at( input->asset_start + sizeof( TerrainHeader ) + GetTerrainTileSlot( x, z ) * sizeof( tile ), &tile, input )
+ || !tile.starts_at )
+    {
+    return( FALSE );
+    }
+
+u64 location = input->asset_start + tile.starts_at + ASSET_FILE_TERRAIN_SAMPLES_OFFSET;
+if( tile.codec == ASSET_FILE_TERRAIN_TILE_RAW )
+    {
+    return( tile.byte_size == ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT * sizeof( *samples )
+         && ReadAt( location, tile.byte_size, samples, input ) );
+    }
+else if( tile.codec != ASSET_FILE_TERRAIN_TILE_PREDICTED )
+    {
+    return( FALSE );
+    }
+
+/* unmapped files read the stored bytes into the scratch buffer */
+const byte *stored = ViewAt( location, tile.byte_size, input );
+if( stored == NULL )
+    {
+    if( tile.byte_size > input->scratch_cap )
+        {
+        byte *scratch = (byte*)realloc( input->scratch, tile.byte_size );
+        if( !scratch )
+            {
+            return( FALSE );
+            }
+
+        input->scratch     = scratch;
+        input->scratch_cap = tile.byte_size;
+        }
+
+    if( !ReadAt( location, tile.byte_size, input->scratch, input ) )
+        {
+        return( FALSE );
+        }
+
+    stored = input->scratch;
+    }
+
+return( decompress_terrain( stored, tile.byte_size, ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT, ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT, samples ) );
+
+} /* AssetFile_ReadTerrainTile() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTerrainTileMinMax()
+*
+*   DESCRIPTION:
+*       Read the min/max pyramid of a tile of the terrain under read.
+*       The output holds ASSET_FILE_TERRAIN_MINMAX_CNT cells, found
+*       with AssetFile_GetTerrainMinMaxIndex().
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTerrainTileMinMax( const u32 x, const u32 z, AssetFileTerrainMinMax *min_max, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !input->asset_start
+ || x >= ASSET_FILE_TERRAIN_AXES_CNT
+ || z >= ASSET_FILE_TERRAIN_AXES_CNT
+ || min_max == NULL )
+    {
+    return( FALSE );
+    }
+
+TerrainTile tile = {};
+if( !read_struct_at( input->asset_start + sizeof( TerrainHeader ) + GetTerrainTileSlot( x, z ) * sizeof( tile ), &tile, input )
+ || !tile.starts_at )
+    {
+    return( FALSE );
+    }
+
+return( ReadAt( input->asset_start + tile.starts_at, ASSET_FILE_TERRAIN_MINMAX_CNT * sizeof( *min_max ), min_max, input ) );
+
+} /* AssetFile_ReadTerrainTileMinMax() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureBinary()
+*
+*   DESCRIPTION:
+*       Read the binary compressed image data for the texture under
+*       read, and copy it into the given buffer.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureBinary( const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || buffer_sz < header.byte_size )
+    {
+    return( FALSE );
+    }
+    
+if( !ReadAt( input->asset_start + sizeof( header ), header.byte_size, buffer, input ) )
+    {
+    return( FALSE );
+    }
+
+if( read_sz != NULL )
+    {
+    *read_sz = header.byte_size;
+    }
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureBinary() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the buffer size required for the texture under read.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureStorageRequirements( u32 *channel_cnt, u32 *channel_width, u32 *width, u32 *height, u32 *byte_count, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || channel_cnt == NULL
+ || channel_width == NULL
+ || width == NULL
+ || height == NULL
+ || byte_count == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*channel_width = header.channel_width;
+*channel_cnt = header.channel_cnt;
+*width = header.width;
+*height = header.height;
+*byte_count = header.byte_size;
+return( TRUE );
+
+} /* AssetFile_ReadTextureStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureExtents()
+*
+*   DESCRIPTION:
+*       Read the texture extent table array.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureExtents( const u16 output_cnt, AssetFileTextureExtent *out_elements, AssetFileReader *input )
+{
+u16 element_cnt;
+if( !AssetFile_ReadTextureExtentsStorageRequirements( &element_cnt, input )
+ || output_cnt < element_cnt )
+    {
+    return( FALSE );
+    }
+
+u64 element_start = input->asset_start + sizeof( TextureExtentHeader );
+for( u16 i = 0; i < element_cnt; i++ )
+    {
+    AssetFileTextureExtent *element = &out_elements[ i ];
+
+    if( !read_struct_at( element_start, &element->texture_id, input )
+     || !read_struct_at( element_start + sizeof( element->texture_id ), &element->width, input )
+     || !read_struct_at( element_start + sizeof( element->texture_id ) + sizeof( element->width ), &element->height, input ) )
+        {
+        return( FALSE );
+        }
+
+    element_start += sizeof( element->texture_id ) + sizeof( element->width ) + sizeof( element->height );
+    }
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureExtents() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureExtentsStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the array size required for the texture extent table.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureExtentsStorageRequirements( u16 *element_cnt, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
+ || !input->asset_start
+ || element_cnt == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureExtentHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*element_cnt = header.texture_cnt;
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureExtentsStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureFormat()
+*
+*   DESCRIPTION:
+*       Read the pixel format of the texture under read.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureFormat( AssetFileTextureFormat *format, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || format == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || header.format >= ASSET_FILE_TEXTURE_FORMAT_CNT )
+    {
+    return( FALSE );
+    }
+
+*format = (AssetFileTextureFormat)header.format;
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureFormat() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureMip()
+*
+*   DESCRIPTION:
+*       Read one mip level of the texture under read into the given
+*       buffer.  Level 0 is the full size image.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureMip( const u32 mip_index, const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || buffer == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || mip_index >= header.mip_cnt
+ || buffer_sz < header.mips[ mip_index ].byte_size )
+    {
+    return( FALSE );
+    }
+
+const TextureMip *mip = &header.mips[ mip_index ];
+if( !ReadAt( input->asset_start + mip->starts_at, mip->byte_size, buffer, input ) )
+    {
+    return( FALSE );
+    }
+
+if( read_sz != NULL )
+    {
+    *read_sz = mip->byte_size;
+    }
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureMip() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureMipCount()
+*
+*   DESCRIPTION:
+*       Read the number of mip levels in the texture under read.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureMipCount( u32 *mip_cnt, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || mip_cnt == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input ) )
+    {
+    return( FALSE );
+    }
+
+*mip_cnt = header.mip_cnt;
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureMipCount() */
+
+
+/*******************************************************************
+*
+*   AssetFile_ReadTextureMipStorageRequirements()
+*
+*   DESCRIPTION:
+*       Read the dimensions and buffer size of one mip level of the
+*       texture under read.
+*
+*******************************************************************/
+
+b8 AssetFile_ReadTextureMipStorageRequirements( const u32 mip_index, u32 *width, u32 *height, u32 *byte_count, AssetFileReader *input )
+{
+if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !input->asset_start
+ || width == NULL
+ || height == NULL
+ || byte_count == NULL )
+    {
+    return( FALSE );
+    }
+
+TextureHeader header = {};
+if( !read_struct_at( input->asset_start, &header, input )
+ || mip_index >= header.mip_cnt )
+    {
+    return( FALSE );
+    }
+
+*width      = header.width  >> mip_index ? header.width  >> mip_index : 1;
+*height     = header.height >> mip_index ? header.height >> mip_index : 1;
+*byte_count = header.mips[ mip_index ].byte_size;
+
+return( TRUE );
+
+} /* AssetFile_ReadTextureMipStorageRequirements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_SetCompression()
+*
+*   DESCRIPTION:
+*       Choose how assets written from here on are compressed.
+*
+*******************************************************************/
+
+b8 AssetFile_SetCompression( const AssetFileCodec codec, AssetFileWriter *output )
+{
+if( codec >= ASSET_FILE_CODEC_CNT )
+    {
+    return( FALSE );
+    }
+
+output->codec = codec;
+
+return( TRUE );
+
+} /* AssetFile_SetCompression() */
+
+
+/*******************************************************************
+*
+*   AssetFile_SubmitLoads()
+*
+*   DESCRIPTION:
+*       Queue a batch of loads.  The loader thread serves the highest
+*       priority first, and within a priority reads in file order,
+*       merging nearby assets into single reads.  Each callback is
+*       handed a reader positioned on its asset, valid only for the
+*       duration of the call.
+*
+*******************************************************************/
+
+b8 AssetFile_SubmitLoads( const AssetFileLoadRequest *requests, const u32 request_cnt, AssetFileLoader *loader )
+{
+AssetFileLoaderQueue *queue = loader->queue;
+if( queue == NULL )
+    {
+    return( FALSE );
+    }
+
+for( u32 i = 0; i < request_cnt; i++ )
+    {
+    if( requests[ i ].callback == NULL )
+        {
+        return( FALSE );
+        }
+    }
+
+    {
+    /* the table is never written once open, so it is safe to search alongside the loader thread */
+    std::lock_guard<std::mutex> lock( queue->mutex );
+    for( u32 i = 0; i < request_cnt; i++ )
+        {
+        LoaderEntry entry = {};
+        entry.request = requests[ i ];
+        entry.row     = FindTableRow( requests[ i ].id, loader->input.pack );
+        queue->pending.push_back( entry );
+        }
+    }
+
+queue->work_signal.notify_one();
+
+return( TRUE );
+
+} /* AssetFile_SubmitLoads() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WaitForLoads()
+*
+*   DESCRIPTION:
+*       Block until every submitted load has had its callback run.
+*       Must not be called from a load callback.
+*
+*******************************************************************/
+
+b8 AssetFile_WaitForLoads( AssetFileLoader *loader )
+{
+AssetFileLoaderQueue *queue = loader->queue;
+if( queue == NULL )
+    {
+    return( FALSE );
+    }
+
+std::unique_lock<std::mutex> lock( queue->mutex );
+queue->done_signal.wait( lock, [queue]{ return( queue->pending.empty() && queue->in_flight == 0 ); } );
+
+return( TRUE );
+
+} /* AssetFile_WaitForLoads() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteFontGlyph()
+*
+*   DESCRIPTION:
+*       Write a font glyph's character data.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteFontGlyph( const u8 glyph, const u16 u0, const u16 v0, const u16 u1, const u16 v1, const f32 pen_dx, const f32 pen_dy, const f32 pen_xadvance, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_FONT
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+FontGlyphHeader header = {};
+header.glyph        = glyph;
+header.u0           = u0;
+header.v0           = v0;
+header.u1           = u1;
+header.v1           = v1;
+header.h_advance    = pen_xadvance;
+header.pen_offset_x = pen_dx;
+header.pen_offset_y = pen_dy;
+
+ensure( write_struct( &header, output ) );
+
+return( TRUE );
+
+}   /* AssetFile_WriteFontGlyph() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelMaterialTextureMaps()
+*
+*   DESCRIPTION:
+*       Write the given mesh material texture map asset IDs.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelMaterialTextureMaps( const AssetFileAssetId *asset_ids, const u8 count, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+ensure( write_array( count, asset_ids, output ) );
+
+return( TRUE );
+
+} /* AssetFile_WriteModelMaterialTextureMaps() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelMeshIndex()
+*
+*   DESCRIPTION:
+*       Write the given mesh index.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelMeshIndex( const AssetFileModelIndex index, AssetFileWriter *output )
+{
+return( AssetFile_WriteModelMeshIndices( &index, 1, output ) );
+
+} /* AssetFile_WriteModelMeshIndex() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelMeshIndices()
+*
+*   DESCRIPTION:
+*       Write a contiguous span of mesh indices at the width the
+*       mesh was described with.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelMeshIndices( const AssetFileModelIndex *indices, const u32 count, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+if( output->model_index_format == ASSET_FILE_MODEL_INDEX_FORMAT_U16 )
+    {
+    u16 narrow[ 256 ];
+    u32 narrow_cnt = (u32)_countof( narrow );
+    for( u32 i = 0; i < count; i += narrow_cnt )
+        {
+        u32 span_cnt = count - i < narrow_cnt ? count - i : narrow_cnt;
+        for( u32 j = 0; j < span_cnt; j++ )
+            {
+            if( indices[ i + j ] > 0xffff )
+                {
+                return( FALSE );
+                }
+
+            narrow[ j ] = (u16)indices[ i + j ];
+            }
+
+        if( !write_array( span_cnt, narrow, output ) )
+            {
+            return( FALSE );
+            }
+        }
+    }
+else if( !write_array( count, indices, output ) )
+    {
+    return( FALSE );
+    }
+
+output->model_indices_written += count;
+
+return( TRUE );
+
+} /* AssetFile_WriteModelMeshIndices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelMeshlets()
+*
+*   DESCRIPTION:
+*       Write the meshlets of the mesh with the same index.  The
+*       element must have been begun as a meshlets element.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelMeshlets( const AssetFileModelMeshlets *meshlets, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+ModelMeshletsHeader header = {};
+header.meshlet_cnt  = meshlets->meshlet_count;
+header.vertex_cnt   = meshlets->vertex_count;
+header.triangle_cnt = meshlets->triangle_count;
+
+ensure( write_struct( &header, output ) );
+ensure( write_array( header.meshlet_cnt, meshlets->meshlets, output ) );
+ensure( write_array( header.vertex_cnt, meshlets->vertices, output ) );
+ensure( write_array( 3 * header.triangle_cnt, meshlets->triangles, output ) );
+
+return( TRUE );
+
+} /* AssetFile_WriteModelMeshlets() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelMeshVertex()
+*
+*   DESCRIPTION:
+*       Write the given mesh vertex.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelMeshVertex( const AssetFileModelVertex *vertex, AssetFileWriter *output )
+{
+return( AssetFile_WriteModelMeshVertices( vertex, 1, output ) );
+
+} /* AssetFile_WriteModelMeshVertex() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelMeshVertices()
+*
+*   DESCRIPTION:
+*       Write a contiguous span of mesh vertices in the layout the
+*       mesh was described with.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelMeshVertices( const AssetFileModelVertex *vertices, const u32 count, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+if( output->model_vertex_format == ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED )
+    {
+    const f32 *offset = output->model_position_offset;
+    const f32 *scale = output->model_position_scale;
+    AssetFileModelPackedVertex packed[ 256 ];
+    u32 packed_cnt = (u32)_countof( packed );
+    for( u32 i = 0; i < count; i += packed_cnt )
+        {
+        u32 span_cnt = count - i < packed_cnt ? count - i : packed_cnt;
+        for( u32 j = 0; j < span_cnt; j++ )
+            {
+            const AssetFileModelVertex *vertex = &vertices[ i + j ];
+            packed[ j ].x   = QuantizeUnorm16( vertex->x, offset[ 0 ], scale[ 0 ] );
+            packed[ j ].y   = QuantizeUnorm16( vertex->y, offset[ 1 ], scale[ 1 ] );
+            packed[ j ].z   = QuantizeUnorm16( vertex->z, offset[ 2 ], scale[ 2 ] );
+            packed[ j ].pad = 0;
+            packed[ j ].u0  = FloatToHalf( vertex->u0 );
+            packed[ j ].v0  = FloatToHalf( vertex->v0 );
+            }
+
+        if( !write_array( span_cnt, packed, output ) )
+            {
+            return( FALSE );
+            }
+        }
+    }
+else if( !write_array( count, vertices, output ) )
+    {
+    return( FALSE );
+    }
+
+output->model_vertices_written += count;
+
+return( TRUE );
+
+} /* AssetFile_WriteModelMeshVertices() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteModelNodeChildElements()
+*
+*   DESCRIPTION:
+*       Write the child node/mesh element indices for a node.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteModelNodeChildElements( const AssetFileModelIndex *element_ids, const u32 count, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+ensure( write_array( count, element_ids, output ) );
+
+return( TRUE );
+
+} /* AssetFile_WriteModelNodeChildElements() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteShader()
+*
+*   DESCRIPTION:
+*       Write the shader program blob to the asset binary.  This
+*       also ends the asset writing session.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteShader( const byte *blob, const u32 blob_size, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_SHADER
+ || !output->asset_start )
+    {
+    return( FALSE );
+    }
+
+ensure( WriteAppend( blob_size, blob, output ) );
+
+return( EndAsset( output ) );
+
+} /* AssetFile_WriteShader() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteSoundPairs()
+*
+*   DESCRIPTION:
+*       Write the sound asset ID/index pair data to the asset binary.
+*       This also ends the asset writing session.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteSoundPairs( const AssetFileSoundPair *sound_pair, const u32 num_pairs, AssetFileWriter *output )
+{
+if( !output->asset_start
+ || ( output->kind != ASSET_FILE_ASSET_KIND_SOUND_SAMPLE
+   && output->kind != ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP )
+ || ( num_pairs && sound_pair == NULL ) )
+    {
+    return( FALSE );
+    }
+
+/* keep the hash table at most half full, so lookups stay short */
+SoundPairsHeader header = {};
+header.slot_cnt = 16;
+while( header.slot_cnt < 2 * (u64)num_pairs )
+    {
+    header.slot_cnt *= 2;
+    }
+
+AssetFileSoundPair *slots = (AssetFileSoundPair*)calloc( header.slot_cnt, sizeof( *slots ) );
+if( !slots )
+    {
+    return( FALSE );
+    }
+
+/* a repeated asset ID keeps its last subsound */
+u32 mask = header.slot_cnt - 1;
+for( u32 i = 0; i < num_pairs; i++ )
+    {
+    if( sound_pair[ i ].asset_id == ASSET_FILE_INVALID_ASSET_ID )
+        {
+        free( slots );
+        return( FALSE );
+        }
+
+    u32 slot = sound_pair[ i ].asset_id & mask;
+    while( slots[ slot ].asset_id != ASSET_FILE_INVALID_ASSET_ID
+        && slots[ slot ].asset_id != sound_pair[ i ].asset_id )
+        {
+        slot = ( slot + 1 ) & mask;
+        }
+
+    header.pair_cnt += slots[ slot ].asset_id == ASSET_FILE_INVALID_ASSET_ID;
+    slots[ slot ] = sound_pair[ i ];
+    }
+
+b8 ret = write_struct( &header, output )
+      && write_array( header.slot_cnt, slots, output );
+
+free( slots );
+
+return( ret && EndAsset( output ) );
+
+} /* AssetFile_WriteSoundPairs() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteTerrainLod()
+*
+*   DESCRIPTION:
+*       Append one of the terrain's LOD index patterns, coarser than
+*       those written before it.  Indices are of samples within a
+*       tile.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteTerrainLod( const u32 step, const u32 index_count, const u32 *indices, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !output->asset_start
+ || output->terrain_lods_written >= ASSET_FILE_TERRAIN_LOD_MAX_COUNT
+ || step == 0
+ || index_count == 0
+ || index_count % 3
+ || indices == NULL )
+    {
+    return( FALSE );
+    }
+
+for( u32 i = 0; i < index_count; i++ )
+    {
+    if( indices[ i ] >= ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT )
+        {
+        return( FALSE );
+        }
+    }
+
+ensure( AlignWriter( output ) );
+
+TerrainLod lod = {};
+lod.starts_at = output->caret - output->asset_start;
+lod.step      = step;
+lod.index_cnt = index_count;
+
+ensure( write_array( index_count, indices, output ) );
+
+u64 header_start = output->asset_start;
+u64 lod_location = header_start + offsetof( TerrainHeader, lods ) + output->terrain_lods_written * sizeof( lod );
+output->terrain_lods_written++;
+
+if( !write_struct_at( lod_location, &lod, output )
+ || !write_struct_at( header_start + offsetof( TerrainHeader, lod_cnt ), &output->terrain_lods_written, output ) )
+    {
+    return( FALSE );
+    }
+
+return( TRUE );
+
+} /* AssetFile_WriteTerrainLod() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteTerrainTile()
+*
+*   DESCRIPTION:
+*       Append the height samples of one tile of the terrain under
+*       write, and point its directory entry at them.  Tiles may be
+*       written in any order, and a tile written twice keeps the
+*       later samples.  The tile's min/max pyramid is built from the
+*       samples.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteTerrainTile( const u32 x, const u32 z, const u16 *samples, AssetFileWriter *output )
+{
+AssetFileTerrainMinMax min_max[ ASSET_FILE_TERRAIN_MINMAX_CNT ];
+if( !AssetFile_BuildTerrainMinMax( samples, min_max ) )
+    {
+    return( FALSE );
+    }
+
+return( AssetFile_WriteTerrainTile2( x, z, min_max, samples, output ) );
+
+} /* AssetFile_WriteTerrainTile() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteTerrainTile2()
+*
+*   DESCRIPTION:
+*       Append a tile of the terrain under write, with a min/max
+*       pyramid from AssetFile_BuildTerrainMinMax().  The samples are
+*       compressed if the writer compresses its assets.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteTerrainTile2( const u32 x, const u32 z, const AssetFileTerrainMinMax *min_max, const u16 *samples, AssetFileWriter *output )
+{
+if( min_max == NULL
+ || samples == NULL )
+    {
+    return( FALSE );
+    }
+
+const u32 raw_sz = ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT * sizeof( *samples );
+if( output->codec == ASSET_FILE_CODEC_NONE )
+    {
+    return( WriteTerrainTileData( x, z, min_max, ASSET_FILE_TERRAIN_TILE_RAW, raw_sz, samples, output ) );
+    }
+
+/* keep the raw samples if compressing would not make them smaller */
+byte *compressed = (byte*)malloc( raw_sz );
+u32 compressed_sz = 0;
+b8 ret = FALSE;
+if( compressed
+ && AssetFile_CompressTerrainTile( samples, raw_sz, &compressed_sz, compressed ) )
+    {
+    ret = WriteTerrainTileData( x, z, min_max, ASSET_FILE_TERRAIN_TILE_PREDICTED, compressed_sz, compressed, output );
+    }
+else if( compressed )
+    {
+    ret = WriteTerrainTileData( x, z, min_max, ASSET_FILE_TERRAIN_TILE_RAW, raw_sz, samples, output );
+    }
+
+free( compressed );
+
+return( ret );
+
+} /* AssetFile_WriteTerrainTile2() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteTerrainTileCompressed()
+*
+*   DESCRIPTION:
+*       Append a tile of the terrain under write which was already
+*       compressed by AssetFile_CompressTerrainTile(), with its
+*       min/max pyramid.
+*
+*******************************************************************/
+
+b8 AssetFile_WriteTerrainTileCompressed( const u32 x, const u32 z, const AssetFileTerrainMinMax *min_max, const u32 byte_size, const byte *buffer, AssetFileWriter *output )
+{
+if( min_max == NULL
+ || buffer == NULL
+ || byte_size == 0 )
     {
     return( FALSE );
     }
 
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
-    }
+return( WriteTerrainTileData( x, z, min_max, ASSET_FILE_TERRAIN_TILE_PREDICTED, byte_size, buffer, output ) );
 
-FontHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
-    {
-    return( FALSE );
-    }
+} /* AssetFile_WriteTerrainTileCompressed() */
 
-*glyph_cnt  = header.glyph_cnt;
-*texture_sz = header.texture_sz;
 
-return( TRUE );
+/*******************************************************************
+*
+*   AssetFile_WriteTexture()
+*
+*   DESCRIPTION:
+*       Write the texture data to the asset binary.  This also ends
+*       the asset writing session.
+*
+*******************************************************************/
 
-}   /* AssetFile_ReadFontStorageRequirements() */
+b8 AssetFile_WriteTexture( const byte *image, const u32 image_size, AssetFileWriter *output )
+{
+ensure( AssetFile_WriteTextureMip( image, image_size, output ) );
+
+return( EndAsset( output ) );
+
+} /* AssetFile_WriteTexture() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadModelMaterials()
+*   AssetFile_WriteTextureExtent()
 *
 *   DESCRIPTION:
-*       Read and output the given model's materials.
+*       Write the texture data to the asset binary.  This also ends
+*       the asset writing session.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadModelMaterials( const u32 material_capacity, u32 *material_count, AssetFileModelMaterial *materials, AssetFileReader *input )
+b8 AssetFile_WriteTextureExtent( const AssetFileAssetId id, const u16 width, const u16 height, AssetFileWriter *output )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !input->asset_start
- || materials == NULL
- || material_count == NULL )
+if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
+ || !output->asset_start )
     {
     return( FALSE );
     }
 
-*material_count = 0;
+ensure( write_struct( &id, output ) );
+ensure( write_struct( &width, output ) );
+ensure( write_struct( &height, output ) );
 
-if( !file_seek( input->hnd, input->asset_start ) )
+return( TRUE );
+
+} /* AssetFile_WriteTextureExtent() */
+
+
+/*******************************************************************
+*
+*   AssetFile_WriteTextureMip()
+*
+*   DESCRIPTION:
+*       Append the next mip level of the texture under write, level
+*       0 first, and record it in the texture header.  Finish the
+*       asset with AssetFile_EndWritingAsset().
+*
+*******************************************************************/
+
+b8 AssetFile_WriteTextureMip( const byte *image, const u32 image_size, AssetFileWriter *output )
+{
+if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE
+ || !output->asset_start
+ || output->texture_mips_written >= ASSET_FILE_TEXTURE_MAX_MIP_CNT )
     {
     return( FALSE );
     }
 
-ModelHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
+/* level 0 sits right after the header where AssetFile_ReadTextureBinary() expects it */
+if( output->texture_mips_written > 0 )
     {
-    return( FALSE );
+    ensure( AlignWriter( output ) );
     }
 
-if( header.material_cnt > material_capacity )
+TextureMip mip = {};
+mip.starts_at = output->caret - output->asset_start;
+mip.byte_size = image_size;
+
+ensure( WriteAppend( image_size, image, output ) );
+
+u64 header_start = output->asset_start;
+u64 mip_location = header_start + offsetof( TextureHeader, mips ) + output->texture_mips_written * sizeof( TextureMip );
+output->texture_mips_written++;
+
+if( !write_struct_at( mip_location, &mip, output )
+ || !write_struct_at( header_start + offsetof( TextureHeader, mip_cnt ), &output->texture_mips_written, output ) )
     {
     return( FALSE );
     }
 
-for( u32 i = 0; i < header.material_cnt; i++ )
-    {
-    materials[ i ] = {};
-
-    if( !JumpToModelMaterial( input->asset_start, i, input->hnd ) )
-        {
-        return( FALSE );
-        }
+return( TRUE );
 
-    ModelMaterialHeader material = {};
-    if( !file_read_struct( input->hnd, &material ) )
-        {
-        return( FALSE );
-        }
+} /* AssetFile_WriteTextureMip() */
 
-    materials[ i ].bits = material.map_bits;
-    for( u32 j = 0; j < ASSET_FILE_MODEL_TEXTURE_COUNT; j++ )
-        {
-        if( !( material.map_bits & ( 1 << j ) ) )
-            {
-            continue;
-            }
 
-        AssetFileAssetId element;
-        if( !file_read_struct( input->hnd, &element ) )
-            {
-            return( FALSE );
-            }
+/*******************************************************************
+*
+*   AlignWriter()
+*
+*   DESCRIPTION:
+*       Pad the output with zeros, advancing the caret to the next
+*       aligned location.  Keeps the data handed out by the mapped
+*       reader naturally aligned.
+*
+*******************************************************************/
 
-        materials[ i ].textures[ j ] = element;
-        }
+static b8 AlignWriter( AssetFileWriter *output )
+{
+static const byte ZEROS[ ASSET_FILE_ALIGNMENT ] = {};
 
-    }
+u32 pad_sz = (u32)( ( ASSET_FILE_ALIGNMENT - output->caret % ASSET_FILE_ALIGNMENT ) % ASSET_FILE_ALIGNMENT );
 
-*material_count = header.material_cnt;
-return( TRUE );
+return( WriteAppend( pad_sz, ZEROS, output ) );
 
-} /* AssetFile_ReadModelMaterials() */
+} /* AlignWriter() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadModelMeshIndices()
+*   BuildTableKeys()
 *
 *   DESCRIPTION:
-*       Read and output the given model mesh's indices.
+*       Recursively lay the sorted table rows' IDs out in Eytzinger
+*       (breadth-first) order, so that the search touches memory
+*       front to back.  Returns the next row to place.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadModelMeshIndices( const u32 mesh_index, const u32 index_capacity, u32 *index_count, AssetFileModelIndex *indices, AssetFileReader *input )
+static u32 BuildTableKeys( const AssetFileTableRow *rows, const u32 row_count, u32 row, const u32 key, AssetFileTableKey *keys )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !input->asset_start
- || indices == NULL
- || index_count == NULL )
+if( key > row_count )
     {
-    return( FALSE );
+    return( row );
     }
 
-*index_count = 0;
+row = BuildTableKeys( rows, row_count, row, 2 * key, keys );
+
+keys[ key ].id  = rows[ row ].id;
+keys[ key ].row = row;
+row++;
+
+return( BuildTableKeys( rows, row_count, row, 2 * key + 1, keys ) );
+
+} /* BuildTableKeys() */
+
+
+/*******************************************************************
+*
+*   CompleteLoads()
+*
+*   DESCRIPTION:
+*       Read a run of neighbouring assets with a single read, and
+*       hand each to its callback.
+*
+*******************************************************************/
 
-if( !JumpToModelMesh( input->asset_start, mesh_index, input->hnd ) )
+static void CompleteLoads( const LoaderEntry *entries, const u32 entry_cnt, const u64 span_start, const u64 span_sz, AssetFileLoader *loader )
+{
+AssetFileLoaderQueue *queue = loader->queue;
+AssetFileReader *input = &loader->input;
+
+b8 read = TRUE;
+if( span_sz > queue->buffer_cap )
     {
-    return( FALSE );
+    byte *buffer = (byte*)realloc( queue->buffer, (size_t)span_sz );
+    if( buffer )
+        {
+        queue->buffer     = buffer;
+        queue->buffer_cap = span_sz;
+        }
+    else
+        {
+        read = FALSE;
+        }
     }
 
-ModelMeshHeader mesh = {};
-if( !file_read_struct( input->hnd, &mesh ) )
+read = read
+    && ReadFileAt( span_start, span_sz, queue->buffer, input );
+
+for( u32 i = 0; i < entry_cnt; i++ )
     {
-    return( FALSE );
+    const LoaderEntry *entry = &entries[ i ];
+    if( !read
+     || !AssetFile_BeginReadingBlob( entry->request.id, entry->request.kind, queue->buffer + ( entry->row->starts_at - span_start ), entry->row->stored_sz, input ) )
+        {
+        entry->request.callback( entry->request.id, NULL, entry->request.user );
+        continue;
+        }
+
+    entry->request.callback( entry->request.id, input, entry->request.user );
+    AssetFile_EndReadingAsset( input );
     }
 
-if( index_capacity < mesh.index_cnt )
+} /* CompleteLoads() */
+
+
+/*******************************************************************
+*
+*   CompressAsset()
+*
+*   DESCRIPTION:
+*       Compress the asset just written, in place in the staging
+*       buffer.  Assets which don't shrink meaningfully, which have
+*       already been partially flushed, or which are too large for a
+*       single LZ block are left as they are.
+*
+*******************************************************************/
+
+static b8 CompressAsset( AssetFileTableRow *row, AssetFileWriter *output )
+{
+if( output->asset_start < output->buffer_start
+ || row->raw_sz < ASSET_FILE_ALIGNMENT
+ || row->raw_sz > 0xffffffff )
     {
-    return( FALSE );
+    return( TRUE );
     }
-    
-/* Geometry order is... 
- a) VERTICES
- b) INDICES <-- Look here */
-if( !file_seek_rel( input->hnd, sizeof(AssetFileModelVertex) * mesh.vertex_cnt ) )
+
+/* only keep the compressed form if it saves at least 1/16th */
+u32 compressed_cap = (u32)( row->raw_sz - row->raw_sz / 16 );
+byte *compressed = (byte*)malloc( compressed_cap );
+if( !compressed )
     {
     return( FALSE );
     }
 
-if( !file_read_array( input->hnd, mesh.index_cnt, indices ) )
+byte *raw = output->buffer + ( output->asset_start - output->buffer_start );
+u32 compressed_sz = compress_lz( raw, (u32)row->raw_sz, compressed, compressed_cap );
+if( compressed_sz )
     {
-    return( FALSE );
+    memcpy( raw, compressed, compressed_sz );
+    output->caret     = output->asset_start + compressed_sz;
+    output->buffer_sz = output->caret - output->buffer_start;
+
+    row->stored_sz = compressed_sz;
+    row->codec     = ASSET_FILE_CODEC_LZ;
     }
 
-*index_count = mesh.index_cnt;
+free( compressed );
+
 return( TRUE );
 
-} /* AssetFile_ReadModelMeshIndices() */
+} /* CompressAsset() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadModelMeshVertices()
+*   CheckModelMeshLods()
 *
 *   DESCRIPTION:
-*       Read and output the given model mesh's vertices.       
+*       Check the mesh's levels of detail stay within its indices.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadModelMeshVertices( const u32 mesh_index, const u32 vertex_capacity, AssetFileModelIndex *material_index, u32 *vertex_count, AssetFileModelVertex *vertices, AssetFileReader *input )
+static b8 CheckModelMeshLods( const ModelMeshHeader *mesh )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !input->asset_start
- || vertices == NULL
- || vertex_count == NULL )
+if( mesh->lod_cnt > ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT )
     {
     return( FALSE );
     }
 
-*vertex_count = 0;
-
-if( !JumpToModelMesh( input->asset_start, mesh_index, input->hnd ) )
+u64 total_cnt = (u64)mesh->index_cnt + mesh->lod_index_cnt;
+for( u32 i = 0; i < mesh->lod_cnt; i++ )
     {
-    return( FALSE );
+    if( (u64)mesh->lods[ i ].index_offset + mesh->lods[ i ].index_count > total_cnt )
+        {
+        return( FALSE );
+        }
     }
 
-ModelMeshHeader mesh = {};
-if( !file_read_struct( input->hnd, &mesh ) )
+return( TRUE );
+
+} /* CheckModelMeshLods() */
+
+
+/*******************************************************************
+*
+*   ConvertModelMesh()
+*
+*   DESCRIPTION:
+*       Fill the public mesh from its stored header and geometry,
+*       which the header's formats have already been checked to fit.
+*
+*******************************************************************/
+
+static void ConvertModelMesh( const ModelMeshHeader *mesh, const byte *geometry, AssetFileModelMesh *out )
+{
+*out = {};
+out->material      = mesh->material;
+out->vertex_count  = mesh->vertex_cnt;
+out->index_count   = mesh->index_cnt;
+out->vertex_format = (AssetFileModelVertexFormat)mesh->vertex_format;
+out->index_format  = (AssetFileModelIndexFormat)mesh->index_format;
+memcpy( out->position_offset, mesh->position_offset, sizeof( out->position_offset ) );
+memcpy( out->position_scale, mesh->position_scale, sizeof( out->position_scale ) );
+out->bounds        = mesh->bounds;
+out->lod_count     = mesh->lod_cnt;
+memcpy( out->lods, mesh->lods, sizeof( out->lods ) );
+
+/* Geometry order is...
+ a) VERTICES
+ b) INDICES */
+out->vertices = geometry;
+out->indices  = geometry + (u64)GetModelVertexSize( mesh->vertex_format ) * mesh->vertex_cnt;
+
+} /* ConvertModelMesh() */
+
+
+/*******************************************************************
+*
+*   ConvertModelMeshlets()
+*
+*   DESCRIPTION:
+*       Point the public meshlets into their stored lists, failing if
+*       the lists overrun the data.
+*
+*******************************************************************/
+
+static b8 ConvertModelMeshlets( const ModelMeshletsHeader *meshlets, const byte *data, const u64 data_sz, AssetFileModelMeshlets *out )
+{
+*out = {};
+
+/* Meshlet order is...
+ a) MESHLETS
+ b) VERTICES
+ c) TRIANGLES */
+u64 meshlets_sz = (u64)meshlets->meshlet_cnt * sizeof( AssetFileModelMeshlet );
+u64 vertices_sz = (u64)meshlets->vertex_cnt * sizeof( u32 );
+if( meshlets_sz + vertices_sz + (u64)meshlets->triangle_cnt * 3 > data_sz )
     {
     return( FALSE );
     }
 
-if( vertex_capacity < mesh.vertex_cnt )
+out->meshlet_count  = meshlets->meshlet_cnt;
+out->vertex_count   = meshlets->vertex_cnt;
+out->triangle_count = meshlets->triangle_cnt;
+out->meshlets       = (const AssetFileModelMeshlet*)data;
+out->vertices       = (const u32*)( data + meshlets_sz );
+out->triangles      = data + meshlets_sz + vertices_sz;
+
+return( TRUE );
+
+} /* ConvertModelMeshlets() */
+
+
+/*******************************************************************
+*
+*   ConvertModelNode()
+*
+*   DESCRIPTION:
+*       Convert a stored node and its child element indices into
+*       the public node, with children as node and mesh indices.
+*
+*******************************************************************/
+
+static b8 ConvertModelNode( const ModelHeader *header, const ModelNodeHeader *node, const AssetFileModelIndex *elements, AssetFileModelNode *out )
+{
+*out = {};
+if( node->node_count > ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT
+ || node->mesh_count > ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT )
     {
     return( FALSE );
     }
 
-if( material_index )
+/* transform and bounds */
+memcpy( out->transform, node->transform, _countof( out->transform ) * sizeof( *out->transform ) );
+out->bounds = node->bounds;
+
+/* children are stored as nodes, then meshes; reject any element outside its range */
+const u64 first_node = (u64)header->material_cnt + header->mesh_count;
+for( u32 j = 0; j < node->node_count; j++ )
     {
-    *material_index = (AssetFileModelIndex)mesh.material;
+    if( elements[ j ] < first_node
+     || elements[ j ] - first_node >= header->node_count )
+        {
+        return( FALSE );
+        }
+
+    out->child_nodes[ out->child_node_count++ ] = (u32)( elements[ j ] - first_node );
     }
-    
-/* Geometry order is... 
- a) VERTICES <-- Look here
- b) INDICES */
-if( !file_read_array( input->hnd, mesh.vertex_cnt, vertices ) )
+
+for( u32 j = 0; j < node->mesh_count; j++ )
     {
-    return( FALSE );
+    const AssetFileModelIndex element = elements[ node->node_count + j ];
+    if( element < header->material_cnt
+     || element - header->material_cnt >= header->mesh_count )
+        {
+        return( FALSE );
+        }
+
+    out->child_meshes[ out->child_mesh_count++ ] = element - header->material_cnt;
     }
 
-*vertex_count = mesh.vertex_cnt;
 return( TRUE );
 
-} /* AssetFile_ReadModelMeshVertices() */
+} /* ConvertModelNode() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadModelNodes()
+*   DequantizeVertices()
 *
 *   DESCRIPTION:
-*       Read and output the model-under-read's node tree.
+*       Expand packed vertices.  Each packed vertex is fully loaded
+*       before its expanded form is stored, so the packed input may
+*       sit at the back of the output buffer.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadModelNodes( const u32 node_capacity, u32 *node_count, AssetFileModelNode *nodes, AssetFileReader *input )
+static void DequantizeVertices( const AssetFileModelPackedVertex *packed, const u32 count, const f32 *offset, const f32 *scale, AssetFileModelVertex *vertices )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !input->asset_start
- || nodes == NULL )
-    {
-    return( FALSE );
+#if defined( ASSET_FILE_USE_SSE2 )
+const __m128 offset4 = _mm_setr_ps( offset[ 0 ], offset[ 1 ], offset[ 2 ], 0.0f );
+const __m128 scale4  = _mm_setr_ps( scale[ 0 ], scale[ 1 ], scale[ 2 ], 0.0f );
+const __m128i zero   = _mm_setzero_si128();
+for( u32 i = 0; i < count; i++ )
+    {
+    /* x, y, z, pad widened to four lanes and scaled at once */
+    __m128i xyzw = _mm_loadl_epi64( (const __m128i*)&packed[ i ] );
+    u16 u0 = packed[ i ].u0;
+    u16 v0 = packed[ i ].v0;
+    __m128 position = _mm_add_ps( _mm_mul_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( xyzw, zero ) ), scale4 ), offset4 );
+
+    /* the fourth lane lands on u0, which is stored right after */
+    _mm_storeu_ps( &vertices[ i ].x, position );
+    vertices[ i ].u0 = HalfToFloat( u0 );
+    vertices[ i ].v0 = HalfToFloat( v0 );
+    }
+#else
+for( u32 i = 0; i < count; i++ )
+    {
+    AssetFileModelPackedVertex vertex = packed[ i ];
+    vertices[ i ].x  = offset[ 0 ] + (f32)vertex.x * scale[ 0 ];
+    vertices[ i ].y  = offset[ 1 ] + (f32)vertex.y * scale[ 1 ];
+    vertices[ i ].z  = offset[ 2 ] + (f32)vertex.z * scale[ 2 ];
+    vertices[ i ].u0 = HalfToFloat( vertex.u0 );
+    vertices[ i ].v0 = HalfToFloat( vertex.v0 );
     }
+#endif
 
-*node_count = 0;
+} /* DequantizeVertices() */
 
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
+
+/*******************************************************************
+*
+*   EndAsset()
+*
+*   DESCRIPTION:
+*       Close out the asset under write by recording its size, and
+*       compressing it if requested.  Then flush the staged output
+*       once enough of it has accumulated.
+*
+*******************************************************************/
+
+static b8 EndAsset( AssetFileWriter *output )
+{
+AssetFileTableRow *row = output->asset_row;
+if( row
+ && output->asset_start )
+    {
+    row->raw_sz    = output->caret - output->asset_start;
+    row->stored_sz = row->raw_sz;
+    row->codec     = ASSET_FILE_CODEC_NONE;
+    /* terrain tiles are read one at a time, so the asset is never compressed as a whole */
+    if( output->codec != ASSET_FILE_CODEC_NONE
+     && output->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+     && !CompressAsset( row, output ) )
+        {
+        return( FALSE );
+        }
+
+    /* drop the asset's bytes again if an identical payload was already written */
+    if( output->asset_start >= output->buffer_start
+     && SharePayload( row, output->buffer + ( output->asset_start - output->buffer_start ), output ) )
+        {
+        output->caret     = output->asset_start;
+        output->buffer_sz = output->caret - output->buffer_start;
+        }
     }
 
-ModelHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
-    {
-    return( FALSE );
-    }
+output->asset_start = 0;
+output->asset_row = NULL;
+output->kind = ASSET_FILE_ASSET_KIND_INVALID;
 
-if( header.node_count > node_capacity )
+if( !output->hnd
+ || output->buffer_sz < ASSET_FILE_WRITE_FLUSH_SZ )
     {
-    return( FALSE );
+    return( TRUE );
     }
 
-for( u32 i = 0; i < header.node_count; i++ )
-    {
-    nodes[ i ] = {};
+return( FlushWriter( output ) );
 
-    if( !JumpToModelNode( input->asset_start, i, input->hnd ) )
-        {
-        return( FALSE );
-        }
+} /* EndAsset() */
 
-    ModelNodeHeader node = {};
-    if( !file_read_struct( input->hnd, &node ) )
-        {
-        return( FALSE );
-        }
 
-    AssetFileModelIndex element;
+/*******************************************************************
+*
+*   FindModelElement()
+*
+*   DESCRIPTION:
+*       Find the file location of the current model's element, given
+*       the element kind and its index amongst elements of that kind.
+*
+*******************************************************************/
+
+static b8 FindModelElement( const AssetFileModelElementKind kind, const u32 element_index, const ModelHeader *header, AssetFileReader *input, u64 *element_start )
+{
+/* Element table order is...  
+ a) MATERIALS
+ b) MESHES
+ c) NODES
+ d) MESHLETS, if any */
+u32 row_index = 0;
+switch( kind )
+    {
+    case ASSET_FILE_MODEL_ELEMENT_KIND_MATERIAL:
+        if( element_index >= header->material_cnt )
+            {
+            return( FALSE );
+            }
+
+        row_index = element_index;
+        break;
 
-    /* transform */
-    memcpy( nodes[ i ].transform, node.transform, _countof( nodes->transform ) * sizeof( *nodes->transform ) );
+    case ASSET_FILE_MODEL_ELEMENT_KIND_MESH:
+        if( element_index >= header->mesh_count )
+            {
+            return( FALSE );
+            }
 
-    /* nodes */
-    for( u32 j = 0; j < node.node_count; j++ )
-        {
-        if( !file_read_struct( input->hnd, &element ) )
+        row_index = header->material_cnt + element_index;
+        break;
+
+    case ASSET_FILE_MODEL_ELEMENT_KIND_NODE:
+        if( element_index >= header->node_count )
             {
             return( FALSE );
             }
 
-        nodes[ i ].child_nodes[ nodes[ i ].child_node_count++ ] = element - ( header.material_cnt + header.mesh_count );
-        }
+        row_index = header->material_cnt + header->mesh_count + element_index;
+        break;
 
-    /* meshes */
-    for( u32 j = 0; j < node.mesh_count; j++ )
-        {
-        if( !file_read_struct( input->hnd, &element ) )
+    case ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS:
+        if( element_index >= header->meshlets_cnt )
             {
             return( FALSE );
             }
 
-        nodes[ i ].child_meshes[ nodes[ i ].child_mesh_count++ ] = element - header.material_cnt;
-        }
+        row_index = header->material_cnt + header->mesh_count + header->node_count + element_index;
+        break;
+
+    default:
+        return( FALSE );
     }
 
-*node_count = header.node_count;
+u64 row_location = input->asset_start
+                 + sizeof( ModelHeader )
+                 + row_index * sizeof( ModelTableRow );
+
+ModelTableRow element = {};
+if( !read_struct_at( row_location, &element, input )
+ || element.kind != kind )
+    {
+    return( FALSE );
+    }
+
+*element_start = input->asset_start + element.starts_at;
 
 return( TRUE );
 
-} /* AssetFile_ReadModelNodes() */
+} /* FindModelElement() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadModelStorageRequirements()
+*   FindTableRow()
 *
 *   DESCRIPTION:
-*       Read the count of each of the model's elements.
+*       Search the in-memory asset table for the given asset ID.
+*       Returns NULL if the asset is not in the table.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadModelStorageRequirements( u32 *vertex_count, u32 *index_count, u32 *mesh_count, u32 *node_count, u32 *material_count, AssetFileReader *input )
+static const AssetFileTableRow * FindTableRow( const AssetFileAssetId id, const AssetFilePack *pack )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !input->asset_start )
+if( pack == NULL
+ || !pack->table_keys )
     {
-    return( FALSE );
+    return( NULL );
     }
 
-if( !file_seek( input->hnd, input->asset_start ) )
+/* keys are 1-based, children of k are 2k and 2k + 1 */
+const AssetFileTableKey *keys = pack->table_keys;
+u32 k = 1;
+while( k <= pack->table_cnt )
     {
-    return( FALSE );
+    k = 2 * k + ( keys[ k ].id < id );
     }
 
-ModelHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
+/* cancel the right turns taken after the last left turn */
+while( k & 1 )
     {
-    return( FALSE );
+    k >>= 1;
     }
 
-if( vertex_count )
+k >>= 1;
+if( k == 0
+ || keys[ k ].id != id )
     {
-    *vertex_count = header.total_vertex_count;
+    return( NULL );
     }
 
-if( index_count )
-    {
-    *index_count = header.total_index_count;
-    }
+return( &pack->table[ keys[ k ].row ] );
 
-if( mesh_count )
-    {
-    *mesh_count = header.mesh_count;
-    }
+} /* FindTableRow() */
 
-if( node_count )
+
+/*******************************************************************
+*
+*   FindWriterTableRow()
+*
+*   DESCRIPTION:
+*       Do a binary search to find the asset id in the writer's
+*       in-memory table.  Returns NULL if the asset is not in the
+*       table.
+*
+*******************************************************************/
+
+static AssetFileTableRow * FindWriterTableRow( const AssetFileAssetId id, AssetFileWriter *output )
+{
+u32 top    = 0;
+u32 remain = output->table_cnt;
+while( remain > 0 )
     {
-    *node_count = header.node_count;
+    u32 half = remain / 2;
+    if( output->table[ top + half ].id < id )
+        {
+        top    += half + 1;
+        remain -= half + 1;
+        }
+    else
+        {
+        remain = half;
+        }
     }
 
-if( material_count )
+if( top >= output->table_cnt
+ || output->table[ top ].id != id )
     {
-    *material_count = header.material_cnt;
+    return( NULL );
     }
 
-return( TRUE );
+return( &output->table[ top ] );
 
-} /* AssetFile_ReadModelStorageRequirements() */
+} /* FindWriterTableRow() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadShaderBinary()
+*   FloatToHalf()
 *
 *   DESCRIPTION:
-*       Read the binary code for the shader under read, and copy it
-*       into the given buffer.
+*       Convert to IEEE half precision, rounding to nearest even.
+*       Overflow goes to infinity and NaN stays NaN.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadShaderBinary( const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input )
+static u16 FloatToHalf( const f32 value )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_SHADER
- || !input->asset_start
- || buffer == NULL )
-    {
-    return( FALSE );
-    }
+u32 bits;
+memcpy( &bits, &value, sizeof( bits ) );
 
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
-    }
+u32 sign = ( bits >> 16 ) & 0x8000;
+bits &= 0x7fffffff;
 
-ShaderHeader header = {};
-if( !file_read_struct( input->hnd, &header )
- || buffer_sz < header.byte_size )
+u16 ret;
+if( bits >= ( 127 + 16 ) << 23 )
     {
-    return( FALSE );
+    /* too large, infinite or NaN */
+    ret = bits > ( 255u << 23 ) ? 0x7e00 : 0x7c00;
     }
-    
-if( !file_read_buffer( input->hnd, buffer_sz, header.byte_size, buffer ) )
-    {
-    return( FALSE );
+else if( bits < ( 127 - 14 ) << 23 )
+    {
+    /* denormal, let a float add do the rounding shift */
+    const u32 magic_bits = ( 127 - 15 + 23 - 10 + 1 ) << 23;
+    f32 magic;
+    f32 shifted;
+    memcpy( &magic, &magic_bits, sizeof( magic ) );
+    memcpy( &shifted, &bits, sizeof( shifted ) );
+    shifted += magic;
+    memcpy( &bits, &shifted, sizeof( bits ) );
+    ret = (u16)( bits - magic_bits );
     }
-
-if( read_sz != NULL )
+else
     {
-    *read_sz = header.byte_size;
+    /* rebias the exponent and round the dropped mantissa bits */
+    u32 mantissa_odd = ( bits >> 13 ) & 1;
+    bits += ( (u32)( 15 - 127 ) << 23 ) + 0xfff + mantissa_odd;
+    ret = (u16)( bits >> 13 );
     }
 
-return( TRUE );
+return( (u16)( ret | sign ) );
 
-} /* AssetFile_ReadShaderBinary() */
+} /* FloatToHalf() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadShaderStorageRequirements()
+*   FlushWriter()
 *
 *   DESCRIPTION:
-*       Read the buffer size required for the shader under read.
+*       Write all of the staged output to the file in one go.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadShaderStorageRequirements( u32 *byte_count, AssetFileReader *input )
+static b8 FlushWriter( AssetFileWriter *output )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_SHADER
- || !input->asset_start
- || byte_count == NULL )
+if( output->buffer_sz == 0 )
     {
-    return( FALSE );
+    return( TRUE );
     }
 
-if( !file_seek( input->hnd, input->asset_start ) )
+if( !file_seek( output->hnd, output->buffer_start )
+ || !file_write( output->hnd, output->buffer_sz, output->buffer ) )
     {
     return( FALSE );
     }
 
-ShaderHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
-    {
-    return( FALSE );
-    }
+output->buffer_start += output->buffer_sz;
+output->buffer_sz = 0;
 
-*byte_count = header.byte_size;
 return( TRUE );
 
-} /* AssetFile_ReadShaderStorageRequirements() */
+} /* FlushWriter() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadSoundPairs()
+*   GetModelArenaSize()
 *
 *   DESCRIPTION:
-*       Read the binary and return the sound pairs data. 
-*       Works for both sample and music pairs.
-*       
+*       Lay out a model arena: meshes, nodes and materials, then the
+*       model blob at an aligned offset.  Returns the total size.
+*
 *******************************************************************/
 
-b8 AssetFile_ReadSoundPairs( u16 num_pairs, AssetFileSoundPair *sound_pairs, AssetFileReader *input )
+static u64 GetModelArenaSize( const ModelHeader *header, const u64 raw_sz, u64 *blob_offset )
 {
-u16 num_elements;
-if( !AssetFile_ReadSoundPairsStorageRequirements( &num_elements, input )
- || num_pairs < num_elements
- || sound_pairs == NULL )
-    {
-    return( FALSE );
-    }
+u64 tables_sz = (u64)header->mesh_count * sizeof( AssetFileModelMesh )
+              + (u64)header->node_count * sizeof( AssetFileModelNode )
+              + (u64)header->material_cnt * sizeof( AssetFileModelMaterial );
 
-ensure( file_read_array( input->hnd, num_elements, sound_pairs ) );
+*blob_offset = ( tables_sz + ASSET_FILE_ALIGNMENT - 1 ) / ASSET_FILE_ALIGNMENT * ASSET_FILE_ALIGNMENT;
 
-return( TRUE );
-   
-} /* AssetFile_ReadSoundPairs() */
+return( *blob_offset + raw_sz );
+
+} /* GetModelArenaSize() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadSoundPairsStorageRequirements()
+*   GetModelIndexSize()
 *
 *   DESCRIPTION:
-*       Read the array size required for the sound paired asset ID/index data.
+*       Byte size of one stored mesh index, or zero for an unknown
+*       format.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadSoundPairsStorageRequirements( u16 *num_elements, AssetFileReader *input )
+static u32 GetModelIndexSize( const u32 index_format )
 {
-if( ( input->kind != ASSET_FILE_ASSET_KIND_SOUND_SAMPLE
-   && input->kind != ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP )
- || !input->asset_start
- || num_elements == NULL )
+switch( index_format )
     {
-    return( FALSE );
-    }
+    case ASSET_FILE_MODEL_INDEX_FORMAT_U16:
+        return( sizeof( u16 ) );
 
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
-    }
+    case ASSET_FILE_MODEL_INDEX_FORMAT_U32:
+        return( sizeof( u32 ) );
 
-if( !file_read_struct( input->hnd, num_elements ) )
-    {
-    return( FALSE );
+    default:
+        return( 0 );
     }
 
-return( TRUE );
-
-} /* AssetFile_ReadSoundPairsStorageRequirements() */
+} /* GetModelIndexSize() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadTextureBinary()
+*   GetModelVertexSize()
 *
 *   DESCRIPTION:
-*       Read the binary compressed image data for the texture under
-*       read, and copy it into the given buffer.
+*       Byte size of one stored mesh vertex, or zero for an unknown
+*       format.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadTextureBinary( const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input )
+static u32 GetModelVertexSize( const u32 vertex_format )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
- || !input->asset_start
- || buffer == NULL )
+switch( vertex_format )
     {
-    return( FALSE );
-    }
+    case ASSET_FILE_MODEL_VERTEX_FORMAT_F32:
+        return( sizeof( AssetFileModelVertex ) );
 
-if( !file_seek( input->hnd, input->asset_start ) )
-    {
-    return( FALSE );
-    }
+    case ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED:
+        return( sizeof( AssetFileModelPackedVertex ) );
 
-TextureHeader header = {};
-if( !file_read_struct( input->hnd, &header )
- || buffer_sz < header.byte_size )
-    {
-    return( FALSE );
-    }
-    
-if( !file_read( input->hnd, header.byte_size, buffer ) )
-    {
-    return( FALSE );
+    default:
+        return( 0 );
     }
 
-if( read_sz != NULL )
+} /* GetModelVertexSize() */
+
+
+/*******************************************************************
+*
+*   GetTerrainTileSlot()
+*
+*   DESCRIPTION:
+*       Get the directory slot of a terrain tile, its Morton code, so
+*       nearby tiles have nearby directory entries.
+*
+*******************************************************************/
+
+static u32 GetTerrainTileSlot( const u32 x, const u32 z )
+{
+u32 ret = 0;
+for( u32 bit = 0; ( 1u << bit ) < ASSET_FILE_TERRAIN_AXES_CNT; bit++ )
     {
-    *read_sz = header.byte_size;
+    ret |= ( ( x >> bit ) & 1 ) << ( 2 * bit );
+    ret |= ( ( z >> bit ) & 1 ) << ( 2 * bit + 1 );
     }
 
-return( TRUE );
+return( ret );
 
-} /* AssetFile_ReadTextureBinary() */
+} /* GetTerrainTileSlot() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadTextureStorageRequirements()
+*   HalfToFloat()
 *
 *   DESCRIPTION:
-*       Read the buffer size required for the texture under read.
+*       Convert from IEEE half precision, including denormals,
+*       infinities and NaN.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadTextureStorageRequirements( u32 *channel_cnt, u32 *channel_width, u32 *width, u32 *height, u32 *byte_count, AssetFileReader *input )
+static f32 HalfToFloat( const u16 half )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE
- || !input->asset_start
- || channel_cnt == NULL
- || channel_width == NULL
- || width == NULL
- || height == NULL
- || byte_count == NULL )
-    {
-    return( FALSE );
-    }
+const u32 shifted_exponent = 0x7c00 << 13;
+u32 bits = ( (u32)half & 0x7fff ) << 13;
+u32 exponent = bits & shifted_exponent;
+bits += ( 127 - 15 ) << 23;
 
-if( !file_seek( input->hnd, input->asset_start ) )
+f32 ret;
+if( exponent == shifted_exponent )
     {
-    return( FALSE );
+    /* infinity or NaN */
+    bits += ( 128 - 16 ) << 23;
+    memcpy( &ret, &bits, sizeof( ret ) );
     }
-
-TextureHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
+else if( exponent == 0 )
+    {
+    /* denormal, renormalize with a float subtract */
+    const u32 magic_bits = 113 << 23;
+    f32 magic;
+    memcpy( &magic, &magic_bits, sizeof( magic ) );
+    bits += 1 << 23;
+    memcpy( &ret, &bits, sizeof( ret ) );
+    ret -= magic;
+    }
+else
     {
-    return( FALSE );
+    memcpy( &ret, &bits, sizeof( ret ) );
     }
 
-*channel_width = header.channel_width;
-*channel_cnt = header.channel_cnt;
-*width = header.width;
-*height = header.height;
-*byte_count = header.byte_size;
-return( TRUE );
+return( ( half & 0x8000 ) ? -ret : ret );
 
-} /* AssetFile_ReadTextureStorageRequirements() */
+} /* HalfToFloat() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadTextureExtents()
+*   HashPayload()
 *
 *   DESCRIPTION:
-*       Read the texture extent table array.
+*       64-bit hash of an asset's stored bytes, mixing four words at
+*       a time in independent lanes.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadTextureExtents( const u16 output_cnt, AssetFileTextureExtent *out_elements, AssetFileReader *input )
+static u64 HashPayload( const byte *data, const u64 sz )
 {
-u16 element_cnt;
-if( !AssetFile_ReadTextureExtentsStorageRequirements( &element_cnt, input )
- || output_cnt < element_cnt )
+static const u64 MULTIPLIER = 0x9e3779b97f4a7c15ull;
+
+u64 lanes[ 4 ] = { sz, sz ^ 0x243f6a8885a308d3ull, sz ^ 0x13198a2e03707344ull, sz ^ 0xa4093822299f31d0ull };
+u64 i = 0;
+for( ; i + sizeof( lanes ) <= sz; i += sizeof( lanes ) )
     {
-    return( FALSE );
+    for( u32 j = 0; j < 4; j++ )
+        {
+        u64 word;
+        memcpy( &word, data + i + j * sizeof( word ), sizeof( word ) );
+        lanes[ j ] = ( lanes[ j ] ^ word ) * MULTIPLIER;
+        lanes[ j ] ^= lanes[ j ] >> 29;
+        }
     }
 
-for( u16 i = 0; i < element_cnt; i++ )
+u64 hash = lanes[ 0 ];
+for( u32 j = 1; j < 4; j++ )
     {
-    AssetFileTextureExtent *element = &out_elements[ i ];
+    hash = ( hash ^ lanes[ j ] ) * MULTIPLIER;
+    hash ^= hash >> 32;
+    }
 
-    if( !file_read_struct( input->hnd, &element->texture_id )
-     || !file_read_struct( input->hnd, &element->width )
-     || !file_read_struct( input->hnd, &element->height ) )
-        {
-        return( FALSE );
-        }
+for( ; i < sz; i++ )
+    {
+    hash = ( hash ^ data[ i ] ) * MULTIPLIER;
     }
 
-return( TRUE );
+hash ^= hash >> 29;
+hash *= 0xbf58476d1ce4e5b9ull;
+hash ^= hash >> 32;
 
-} /* AssetFile_ReadTextureExtents() */
+return( hash );
+
+} /* HashPayload() */
 
 
 /*******************************************************************
 *
-*   AssetFile_ReadTextureExtentsStorageRequirements()
+*   LoadAsset()
 *
 *   DESCRIPTION:
-*       Read the array size required for the texture extent table.
+*       Decompress the asset under read into the reader's scratch
+*       buffer, if it hasn't been already.
 *
 *******************************************************************/
 
-b8 AssetFile_ReadTextureExtentsStorageRequirements( u16 *element_cnt, AssetFileReader *input )
+static b8 LoadAsset( AssetFileReader *input )
 {
-if( input->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
- || !input->asset_start
- || element_cnt == NULL )
+const AssetFileTableRow *row = input->asset_row;
+if( input->asset_data
+ || row == NULL
+ || row->codec == ASSET_FILE_CODEC_NONE )
+    {
+    return( TRUE );
+    }
+
+/* the writer only compresses assets that fit a single LZ block */
+if( row->codec != ASSET_FILE_CODEC_LZ
+ || row->raw_sz > 0xffffffff
+ || row->stored_sz > row->raw_sz )
     {
     return( FALSE );
     }
 
-if( !file_seek( input->hnd, input->asset_start ) )
+/* unmapped files read the stored bytes into the tail of the scratch buffer */
+const byte *stored = ViewFileAt( row->starts_at, row->stored_sz, input );
+u64 scratch_sz = row->raw_sz + ( stored ? 0 : row->stored_sz );
+if( scratch_sz > input->scratch_cap )
+    {
+    byte *scratch = (byte*)realloc( input->scratch, (size_t)scratch_sz );
+    if( !scratch )
+        {
+        return( FALSE );
+        }
+
+    input->scratch     = scratch;
+    input->scratch_cap = scratch_sz;
+    }
+
+if( !stored )
     {
-    return( FALSE );
+    byte *tail = input->scratch + row->raw_sz;
+    if( !ReadFileAt( row->starts_at, row->stored_sz, tail, input ) )
+        {
+        return( FALSE );
+        }
+
+    stored = tail;
     }
 
-TextureExtentHeader header = {};
-if( !file_read_struct( input->hnd, &header ) )
+if( !decompress_lz( stored, (u32)row->stored_sz, input->scratch, (u32)row->raw_sz ) )
     {
     return( FALSE );
     }
 
-*element_cnt = header.texture_cnt;
+input->asset_data = input->scratch;
 
 return( TRUE );
 
-} /* AssetFile_ReadTextureExtentsStorageRequirements() */
+} /* LoadAsset() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteFontGlyph()
+*   LoadTable()
 *
 *   DESCRIPTION:
-*       Write a font glyph's character data.
+*       Read the whole asset table in a single read, and build the
+*       search keys for it.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteFontGlyph( const u8 glyph, const u16 u0, const u16 v0, const u16 u1, const u16 v1, const f32 pen_dx, const f32 pen_dy, const f32 pen_xadvance, AssetFileWriter *output )
+static b8 LoadTable( AssetFilePack *pack )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_FONT
- || !output->asset_start )
+u64 table_sz = (u64)pack->table_cnt * sizeof( AssetFileTableRow );
+
+pack->table_mem  = malloc( table_sz ? (size_t)table_sz : 1 );
+pack->table_keys = (AssetFileTableKey*)malloc( ( (size_t)pack->table_cnt + 1 ) * sizeof( AssetFileTableKey ) );
+if( !pack->table_mem
+ || !pack->table_keys
+ || !file_read_at( pack->hnd, pack->read_hnd, sizeof( AssetFileHeader ), table_sz, pack->table_mem ) )
     {
     return( FALSE );
     }
 
-FontGlyphHeader header = {};
-header.glyph        = glyph;
-header.u0           = u0;
-header.v0           = v0;
-header.u1           = u1;
-header.v1           = v1;
-header.h_advance    = pen_xadvance;
-header.pen_offset_x = pen_dx;
-header.pen_offset_y = pen_dy;
-
-ensure( file_write_struct( output->hnd, &header ) );
-output->caret = (u32)file_get_pos( output->hnd );
+pack->table = (const AssetFileTableRow*)pack->table_mem;
+pack->table_keys[ 0 ] = {};
+ensure( BuildTableKeys( pack->table, pack->table_cnt, 0, 1, pack->table_keys ) == pack->table_cnt );
 
 return( TRUE );
 
-}   /* AssetFile_WriteFontGlyph() */
+} /* LoadTable() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteModelMaterialTextureMaps()
+*   MatchWrittenBytes()
 *
 *   DESCRIPTION:
-*       Write the given mesh material texture map asset IDs.
+*       Compare bytes already written at the given location with
+*       the given bytes, from the staging buffer or else the file.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteModelMaterialTextureMaps( const AssetFileAssetId *asset_ids, const u8 count, AssetFileWriter *output )
+static b8 MatchWrittenBytes( const u64 location, const u64 sz, const byte *bytes, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+if( location >= output->buffer_start
+ && location + sz <= output->buffer_start + output->buffer_sz )
     {
-    return( FALSE );
+    return( memcmp( output->buffer + ( location - output->buffer_start ), bytes, (size_t)sz ) == 0 );
     }
 
-ensure( file_write_array( output->hnd, count, asset_ids ) );
+if( !output->hnd
+ || location + sz > output->buffer_start
+ || !file_seek( output->hnd, location ) )
+    {
+    return( FALSE );
+    }
 
-output->caret = (u32)file_get_pos( output->hnd );
+byte chunk[ 4096 ];
+for( u64 i = 0; i < sz; i += sizeof( chunk ) )
+    {
+    u64 chunk_sz = sz - i < sizeof( chunk ) ? sz - i : sizeof( chunk );
+    if( !file_read( output->hnd, chunk_sz, chunk )
+     || memcmp( chunk, bytes + i, (size_t)chunk_sz ) != 0 )
+        {
+        return( FALSE );
+        }
+    }
 
 return( TRUE );
 
-} /* AssetFile_WriteModelMaterialTextureMaps() */
+} /* MatchWrittenBytes() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteModelMeshIndex()
+*   QuantizeUnorm16()
 *
 *   DESCRIPTION:
-*       Write the given mesh index.
+*       Round a value onto the 16-bit grid starting at offset with
+*       the given step, clamped to the grid.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteModelMeshIndex( const AssetFileModelIndex index, AssetFileWriter *output )
+static u16 QuantizeUnorm16( const f32 value, const f32 offset, const f32 scale )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+if( !( scale > 0.0f ) )
     {
-    return( FALSE );
+    return( 0 );
     }
 
-ensure( file_write_struct( output->hnd, &index ) );
-
-output->caret = (u32)file_get_pos( output->hnd );
-output->model_indices_written++;
+f32 steps = ( value - offset ) / scale + 0.5f;
+if( !( steps > 0.0f ) )
+    {
+    return( 0 );
+    }
+else if( steps >= 65535.0f )
+    {
+    return( 65535 );
+    }
 
-return( TRUE );
+return( (u16)steps );
 
-} /* AssetFile_WriteModelMeshIndex() */
+} /* QuantizeUnorm16() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteModelMeshVertex()
+*   ReadAt()
 *
 *   DESCRIPTION:
-*       Write the given mesh vertex.
+*       Read from the given file location.  Reads within the asset
+*       under read are served decompressed.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteModelMeshVertex( const AssetFileModelVertex *vertex, AssetFileWriter *output )
+static b8 ReadAt( const u64 location, const u64 read_sz, void *out, AssetFileReader *input )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+if( input->asset_row
+ && input->asset_row->codec != ASSET_FILE_CODEC_NONE )
     {
-    return( FALSE );
-    }
-
-ensure( file_write_struct( output->hnd, vertex ) );
+    const byte *view = ViewAt( location, read_sz, input );
+    if( view == NULL )
+        {
+        return( FALSE );
+        }
 
-output->caret = (u32)file_get_pos( output->hnd );
-output->model_vertices_written++;
+    memcpy( out, view, (size_t)read_sz );
+    return( TRUE );
+    }
 
-return( TRUE );
+return( ReadFileAt( location, read_sz, out, input ) );
 
-} /* AssetFile_WriteModelMeshVertex() */
+} /* ReadAt() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteModelNodeChildElements()
+*   ReadFileAt()
 *
 *   DESCRIPTION:
-*       Write the child node/mesh element indices for a node.
+*       Read the file's stored bytes at the given location, from the
+*       asset's blob or the mapped view if there is one.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteModelNodeChildElements( const AssetFileModelIndex *element_ids, const u32 count, AssetFileWriter *output )
+static b8 ReadFileAt( const u64 location, const u64 read_sz, void *out, AssetFileReader *input )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_MODEL
- || !output->asset_start )
+const byte *view = ViewFileAt( location, read_sz, input );
+if( view )
+    {
+    memcpy( out, view, (size_t)read_sz );
+    return( TRUE );
+    }
+else if( input->pack->map )
     {
     return( FALSE );
     }
 
-ensure( file_write_array( output->hnd, count, element_ids ) );
-
-output->caret = (u32)file_get_pos( output->hnd );
-
-return( TRUE );
+return( file_read_at( input->pack->hnd, input->pack->read_hnd, location, read_sz, out ) );
 
-} /* AssetFile_WriteModelNodeChildElements() */
+} /* ReadFileAt() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteShader()
+*   ReadModelMeshIndexRange()
 *
 *   DESCRIPTION:
-*       Write the shader program blob to the asset binary.  This
-*       also ends the asset writing session.
+*       Read a run of the mesh's stored indices, widening any stored
+*       at 16 bits.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteShader( const byte *blob, const u32 blob_size, AssetFileWriter *output )
+static b8 ReadModelMeshIndexRange( const u64 mesh_start, const ModelMeshHeader *mesh, const u32 first_index, const u32 index_cnt, AssetFileModelIndex *indices, AssetFileReader *input )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_SHADER
- || !output->asset_start )
+u32 index_sz = GetModelIndexSize( mesh->index_format );
+if( index_sz == 0
+ || GetModelVertexSize( mesh->vertex_format ) == 0 )
     {
     return( FALSE );
     }
 
-ensure( file_write( output->hnd, blob_size, blob ) );
-
-output->caret = (u32)file_get_pos( output->hnd );
+/* Geometry order is... 
+ a) VERTICES
+ b) INDICES <-- Look here */
+u64 indices_start = mesh_start + sizeof( *mesh ) + (u64)GetModelVertexSize( mesh->vertex_format ) * mesh->vertex_cnt;
+if( !ReadAt( indices_start + (u64)index_sz * first_index, (u64)index_sz * index_cnt, indices, input ) )
+    {
+    return( FALSE );
+    }
 
-output->asset_start = 0;
-output->kind = ASSET_FILE_ASSET_KIND_INVALID;
+/* widen narrow indices in place, back to front so none are overwritten before use */
+if( index_sz == sizeof( u16 ) )
+    {
+    const u16 *narrow = (const u16*)indices;
+    for( u32 i = index_cnt; i > 0; i-- )
+        {
+        indices[ i - 1 ] = narrow[ i - 1 ];
+        }
+    }
 
 return( TRUE );
 
-} /* AssetFile_WriteShader() */
+} /* ReadModelMeshIndexRange() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteSoundPairs()
+*   ReadWrittenAt()
 *
 *   DESCRIPTION:
-*       Write the sound asset ID/index pair data to the asset binary.
-*       This also ends the asset writing session.
+*       Read back bytes already written by the writer, from the
+*       staging buffer or the file.  The range may not straddle the
+*       two.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteSoundPairs( const AssetFileSoundPair *sound_pair, const u16 num_pairs, AssetFileWriter *output )
+static b8 ReadWrittenAt( const u64 location, const u64 read_sz, void *out, AssetFileWriter *output )
 {
-if( !output->asset_start
- || ( output->kind != ASSET_FILE_ASSET_KIND_SOUND_SAMPLE
-   && output->kind != ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP ) )
+if( location >= output->buffer_start
+ && location + read_sz <= output->buffer_start + output->buffer_sz )
     {
-    return( FALSE );
+    memcpy( out, output->buffer + ( location - output->buffer_start ), (size_t)read_sz );
+    return( TRUE );
     }
 
-u32 size_write = sizeof( *sound_pair ) * num_pairs;
-ensure( file_write_struct( output->hnd, &num_pairs ) );
-ensure( file_write_array( output->hnd, num_pairs, sound_pair ) );
-
-output->caret = (u32)file_get_pos( output->hnd );
-
-output->asset_start = 0;
-output->kind = ASSET_FILE_ASSET_KIND_INVALID;
+if( !output->hnd
+ || location + read_sz > output->buffer_start
+ || !file_seek( output->hnd, location )
+ || !file_read( output->hnd, read_sz, out ) )
+    {
+    return( FALSE );
+    }
 
 return( TRUE );
 
-} /* AssetFile_WriteSoundPairs() */
+} /* ReadWrittenAt() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteTexture()
+*   RunLoader()
 *
 *   DESCRIPTION:
-*       Write the texture data to the asset binary.  This also ends
-*       the asset writing session.
+*       Loader thread.  Takes every waiting request of the highest
+*       priority, sorts them by file location and serves them in
+*       coalesced runs.  A higher priority submission preempts the
+*       batch between runs.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteTexture( const byte *image, const u32 image_size, AssetFileWriter *output )
+static void RunLoader( AssetFileLoader *loader )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE
- || !output->asset_start )
+AssetFileLoaderQueue *queue = loader->queue;
+std::vector<LoaderEntry> batch;
+
+std::unique_lock<std::mutex> lock( queue->mutex );
+while( TRUE )
     {
-    return( FALSE );
-    }
+    queue->work_signal.wait( lock, [queue]{ return( queue->quit || !queue->pending.empty() ); } );
+    if( queue->pending.empty() )
+        {
+        break;
+        }
+
+    u32 priority = 0;
+    for( const LoaderEntry &entry : queue->pending )
+        {
+        priority = std::max( priority, entry.request.priority );
+        }
+
+    batch.clear();
+    size_t kept = 0;
+    for( const LoaderEntry &entry : queue->pending )
+        {
+        if( entry.request.priority == priority )
+            {
+            batch.push_back( entry );
+            }
+        else
+            {
+            queue->pending[ kept++ ] = entry;
+            }
+        }
 
-ensure( file_write( output->hnd, image_size, image ) );
+    queue->pending.resize( kept );
+    queue->in_flight = (u32)batch.size();
+    lock.unlock();
 
-output->caret = (u32)file_get_pos( output->hnd );
+    /* unknown assets fail up front, leaving only real file ranges to sort */
+    size_t found = 0;
+    for( const LoaderEntry &entry : batch )
+        {
+        if( entry.row == NULL )
+            {
+            entry.request.callback( entry.request.id, NULL, entry.request.user );
+            }
+        else
+            {
+            batch[ found++ ] = entry;
+            }
+        }
 
-output->asset_start = 0;
-output->kind = ASSET_FILE_ASSET_KIND_INVALID;
+    batch.resize( found );
+    std::sort( batch.begin(), batch.end(), []( const LoaderEntry &a, const LoaderEntry &b ){ return( a.row->starts_at < b.row->starts_at ); } );
 
-return( TRUE );
+    size_t first = 0;
+    while( first < batch.size() )
+        {
+        /* grow the run while the next asset is close by and the read stays bounded */
+        u64 span_start = batch[ first ].row->starts_at;
+        u64 span_end   = span_start + batch[ first ].row->stored_sz;
+        size_t last = first + 1;
+        while( last < batch.size() )
+            {
+            const AssetFileTableRow *row = batch[ last ].row;
+            u64 end = std::max( span_end, row->starts_at + row->stored_sz );
+            if( row->starts_at > span_end + ASSET_FILE_LOAD_MAX_GAP_SZ
+             || end - span_start > ASSET_FILE_LOAD_MAX_READ_SZ )
+                {
+                break;
+                }
+
+            span_end = end;
+            last++;
+            }
 
-} /* AssetFile_WriteTexture() */
+        CompleteLoads( &batch[ first ], (u32)( last - first ), span_start, span_end - span_start, loader );
+        first = last;
+
+        /* hand the rest of the batch back if something more urgent arrived */
+        std::lock_guard<std::mutex> preempt_lock( queue->mutex );
+        b8 preempted = FALSE;
+        for( const LoaderEntry &entry : queue->pending )
+            {
+            preempted |= ( entry.request.priority > priority );
+            }
+
+        if( preempted )
+            {
+            queue->pending.insert( queue->pending.end(), batch.begin() + first, batch.end() );
+            break;
+            }
+        }
+
+    lock.lock();
+    queue->in_flight = 0;
+    if( queue->pending.empty() )
+        {
+        queue->done_signal.notify_all();
+        }
+    }
+
+} /* RunLoader() */
 
 
 /*******************************************************************
 *
-*   AssetFile_WriteTextureExtent()
+*   SharePayload()
 *
 *   DESCRIPTION:
-*       Write the texture data to the asset binary.  This also ends
-*       the asset writing session.
+*       Point the row at an earlier asset with identical stored
+*       bytes, if there is one.  Otherwise remember this row's
+*       payload for later assets, and the caller writes it.
 *
 *******************************************************************/
 
-b8 AssetFile_WriteTextureExtent( const AssetFileAssetId id, const u16 width, const u16 height, AssetFileWriter *output )
+static b8 SharePayload( AssetFileTableRow *row, const byte *stored, AssetFileWriter *output )
 {
-if( output->kind != ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
- || !output->asset_start )
+if( output->payload_slots == NULL )
     {
     return( FALSE );
     }
 
-ensure( file_write_struct( output->hnd, &id ) );
-ensure( file_write_struct( output->hnd, &width ) );
-ensure( file_write_struct( output->hnd, &height ) );
+u64 hash = HashPayload( stored, row->stored_sz );
+u32 mask = output->payload_slot_cnt - 1;
+u32 slot = (u32)hash & mask;
+for( ; output->payload_slots[ slot ]; slot = ( slot + 1 ) & mask )
+    {
+    u32 match = output->payload_slots[ slot ] - 1;
+    const AssetFileTableRow *other = &output->table[ match ];
+    if( output->payload_hashes[ match ] == hash
+     && other->stored_sz == row->stored_sz
+     && other->raw_sz == row->raw_sz
+     && other->codec == row->codec
+     && MatchWrittenBytes( other->starts_at, row->stored_sz, stored, output ) )
+        {
+        row->starts_at = other->starts_at;
+        output->shared_cnt++;
+        output->shared_sz += row->stored_sz;
+        return( TRUE );
+        }
+    }
 
-output->caret = (u32)file_get_pos( output->hnd );
+u32 index = (u32)( row - output->table );
+output->payload_hashes[ index ] = hash;
+output->payload_slots[ slot ]   = index + 1;
 
-return( TRUE );
+return( FALSE );
 
-} /* AssetFile_WriteTextureExtent() */
+} /* SharePayload() */
 
 
 /*******************************************************************
 *
-*   JumpToAssetInTable()
+*   ViewAt()
 *
 *   DESCRIPTION:
-*       Do a binary search to find the asset id in the table,
-*       leaving the current file position at the start of the table
-*       row.
+*       Get a pointer to the data at the given file location, or
+*       NULL if it can't be viewed in place.  Compressed assets are
+*       viewed in the reader's scratch buffer, valid until the next
+*       asset is read.
 *
 *******************************************************************/
 
-static b8 JumpToAssetInTable( const AssetFileAssetId id, const u32 table_count, fhnd file )
+static const byte * ViewAt( const u64 location, const u64 view_sz, AssetFileReader *input )
 {
-long table_start = (long)sizeof(AssetFileHeader);
-long row_stride  = (long)sizeof(AssetFileTableRow);
-
-b8 found_it = FALSE;
-long remain = (long)table_count;
-long middle;
-long top = 0;
-AssetFileTableRow row;
-while( remain > 0 )
+const AssetFileTableRow *row = input->asset_row;
+if( row == NULL
+ || row->codec == ASSET_FILE_CODEC_NONE )
     {
-    middle = top + remain / 2;
-    
-    if( !file_seek( file, table_start + middle * row_stride ) )
-        {
-        return( FALSE );
-        }
-
-    row = {};
-    if( !file_read_struct( file, &row ) )
-        {
-        return( FALSE );
-        }
-
-    if( id == row.id )
-        {
-        found_it = TRUE;
-        if( !file_seek_rel( file, -row_stride ) )
-            {
-            return( FALSE );
-            }
-
-        break;
-        }
-    else if( id > row.id )
-        {
-        top = middle + 1;
-        remain -= 1 - remain % 2;
-        }
+    return( ViewFileAt( location, view_sz, input ) );
+    }
 
-    remain /= 2;
+if( location < row->starts_at
+ || location - row->starts_at > row->raw_sz
+ || view_sz > row->raw_sz - ( location - row->starts_at )
+ || !LoadAsset( input ) )
+    {
+    return( NULL );
     }
 
-return( found_it );
+return( input->asset_data + ( location - row->starts_at ) );
 
-} /* JumpToAssetInTable() */
+} /* ViewAt() */
 
 
 /*******************************************************************
 *
-*   JumpToModelMaterials()
+*   ViewFileAt()
 *
 *   DESCRIPTION:
-*       Jump the file caret to the start of the current model's
-*       material, given the material index.
+*       Get a pointer to the stored bytes at the given file
+*       location, from the asset's blob or the mapped view.  NULL if
+*       the range is in neither.
 *
 *******************************************************************/
 
-static b8 JumpToModelMaterial( const u32 asset_start, const u32 material_index, fhnd file )
+static const byte * ViewFileAt( const u64 location, const u64 view_sz, const AssetFileReader *input )
 {
-if( !file_seek( file, asset_start ) )
+const AssetFileTableRow *row = input->asset_row;
+if( input->blob
+ && location >= row->starts_at
+ && location - row->starts_at <= row->stored_sz
+ && view_sz <= row->stored_sz - ( location - row->starts_at ) )
     {
-    return( FALSE );
+    return( input->blob + ( location - row->starts_at ) );
     }
 
-ModelHeader header = {};
-if( !file_read_struct( file, &header ) )
+const AssetFilePack *pack = input->pack;
+if( !pack->map
+ || location > pack->map_sz
+ || view_sz > pack->map_sz - location )
     {
-    return( FALSE );
+    return( NULL );
     }
 
-/* Element table order is...  
- a) MATERIALS <-- Look here
- b) MESHES
- c) NODES */
+return( pack->map + location );
 
-u32 element_location = asset_start
-                     + (u32)sizeof(ModelHeader)
-                     + material_index * (u32)sizeof(ModelTableRow);
+} /* ViewFileAt() */
 
-if( !file_seek( file, element_location ) )
-    {
-    return( FALSE );
-    }
 
-ModelTableRow element = {};
-if( !file_read_struct( file, &element )
- || element.kind != ASSET_FILE_MODEL_ELEMENT_KIND_MATERIAL )
-    {
-    return( FALSE );
-    }
+/*******************************************************************
+*
+*   WriteAppend()
+*
+*   DESCRIPTION:
+*       Write the data at the caret, and advance it.
+*
+*******************************************************************/
 
-if( !file_seek( file, element.starts_at ) )
+static b8 WriteAppend( const u64 write_sz, const void *data, AssetFileWriter *output )
+{
+if( !WriteAt( output->caret, write_sz, data, output ) )
     {
     return( FALSE );
     }
 
+output->caret += write_sz;
+
 return( TRUE );
 
-} /* JumpToModelMaterials() */
+} /* WriteAppend() */
 
 
 /*******************************************************************
 *
-*   JumpToModelMesh()
+*   WriteAt()
 *
 *   DESCRIPTION:
-*       Jump the file caret to the start of the current model's
-*       mesh, given the mesh index.
+*       Write the data at the given file location.  Locations which
+*       have not yet been flushed are staged in memory, otherwise the
+*       file is patched in place.
 *
 *******************************************************************/
 
-static b8 JumpToModelMesh( const u32 asset_start, const u32 mesh_index, fhnd file )
+static b8 WriteAt( const u64 location, const u64 write_sz, const void *data, AssetFileWriter *output )
 {
-if( !file_seek( file, asset_start ) )
+const byte *bytes = (const byte*)data;
+u64 at = location;
+u64 remain = write_sz;
+
+/* patch anything which has already been flushed */
+if( at < output->buffer_start )
     {
-    return( FALSE );
+    u64 file_sz = output->buffer_start - at;
+    if( file_sz > remain )
+        {
+        file_sz = remain;
+        }
+
+    if( !file_seek( output->hnd, at )
+     || !file_write( output->hnd, file_sz, bytes ) )
+        {
+        return( FALSE );
+        }
+
+    at     += file_sz;
+    bytes  += file_sz;
+    remain -= file_sz;
     }
 
-ModelHeader header = {};
-if( !file_read_struct( file, &header ) )
+if( remain == 0 )
     {
-    return( FALSE );
+    return( TRUE );
     }
 
-if( mesh_index >= header.mesh_count )
+/* keep the staging buffer bounded for very large assets */
+u64 end = at - output->buffer_start + remain;
+if( output->hnd
+ && end > ASSET_FILE_WRITE_BUFFER_MAX_SZ
+ && at >= output->buffer_start + output->buffer_sz )
     {
-    return( FALSE );
-    }
+    if( !FlushWriter( output ) )
+        {
+        return( FALSE );
+        }
 
-/* Element table order is...  
- a) MATERIALS
- b) MESHES <-- Look here
- c) NODES */
-u32 element_location = asset_start
-                     + (u32)sizeof(ModelHeader)
-                     + ( header.material_cnt + mesh_index ) * (u32)sizeof(ModelTableRow);
+    end = at - output->buffer_start + remain;
+    }
 
-if( !file_seek( file, element_location ) )
+if( end > output->buffer_cap )
     {
-    return( FALSE );
+    u64 new_cap = output->buffer_cap ? output->buffer_cap : 1024 * 1024;
+    while( new_cap < end )
+        {
+        new_cap *= 2;
+        }
+
+    byte *new_buffer = (byte*)realloc( output->buffer, (size_t)new_cap );
+    if( !new_buffer )
+        {
+        return( FALSE );
+        }
+
+    output->buffer     = new_buffer;
+    output->buffer_cap = new_cap;
     }
 
-ModelTableRow element = {};
-if( !file_read_struct( file, &element )
- || element.kind != ASSET_FILE_MODEL_ELEMENT_KIND_MESH )
+/* zero any gap left by a forward write */
+u64 buffer_at = at - output->buffer_start;
+if( buffer_at > output->buffer_sz )
     {
-    return( FALSE );
+    memset( output->buffer + output->buffer_sz, 0, (size_t)( buffer_at - output->buffer_sz ) );
     }
 
-if( !file_seek( file, element.starts_at ) )
+memcpy( output->buffer + buffer_at, bytes, (size_t)remain );
+if( end > output->buffer_sz )
     {
-    return( FALSE );
+    output->buffer_sz = end;
     }
 
 return( TRUE );
 
-} /* JumpToModelMesh() */
+} /* WriteAt() */
 
 
 /*******************************************************************
 *
-*   JumpToModelNode()
+*   WriteTerrainTileData()
 *
 *   DESCRIPTION:
-*       Jump the file caret to the start of the current model's
-*       node, given the node index.
+*       Append a tile's min/max pyramid and stored samples to the
+*       terrain under write, and point its directory entry at them.
 *
 *******************************************************************/
 
-static b8 JumpToModelNode( const u32 asset_start, const u32 node_index, fhnd file )
+static b8 WriteTerrainTileData( const u32 x, const u32 z, const AssetFileTerrainMinMax *min_max, const u32 codec, const u32 byte_size, const void *data, AssetFileWriter *output )
 {
-if( !file_seek( file, asset_start ) )
+if( output->kind != ASSET_FILE_ASSET_KIND_TERRAIN
+ || !output->asset_start
+ || x >= ASSET_FILE_TERRAIN_AXES_CNT
+ || z >= ASSET_FILE_TERRAIN_AXES_CNT )
     {
     return( FALSE );
     }
 
-ModelHeader header = {};
-if( !file_read_struct( file, &header ) )
-    {
-    return( FALSE );
-    }
+ensure( AlignWriter( output ) );
 
-/* Element table order is...  
- a) MATERIALS
- b) MESHES
- c) NODES  <-- Look here */
-u32 element_location = asset_start
-                     + (u32)sizeof(ModelHeader)
-                     + ( header.material_cnt + header.mesh_count + node_index ) * (u32)sizeof(ModelTableRow);
+TerrainTile tile = {};
+tile.starts_at = output->caret - output->asset_start;
+tile.byte_size = byte_size;
+tile.codec     = codec;
 
-if( !file_seek( file, element_location ) )
-    {
-    return( FALSE );
-    }
+ensure( write_array( ASSET_FILE_TERRAIN_MINMAX_CNT, min_max, output ) );
+ensure( AlignWriter( output ) );
+ensure( WriteAppend( byte_size, data, output ) );
 
-ModelTableRow element = {};
-if( !file_read_struct( file, &element )
- || element.kind != ASSET_FILE_MODEL_ELEMENT_KIND_NODE )
+u64 header_start = output->asset_start;
+u64 tile_location = header_start + sizeof( TerrainHeader ) + GetTerrainTileSlot( x, z ) * sizeof( tile );
+
+/* a rewritten tile replaces its slot without counting again */
+TerrainTile previous = {};
+ensure( ReadWrittenAt( tile_location, sizeof( previous ), &previous, output ) );
+if( !previous.starts_at )
     {
-    return( FALSE );
+    output->terrain_tiles_written++;
     }
 
-if( !file_seek( file, element.starts_at ) )
+if( !write_struct_at( tile_location, &tile, output )
+ || !write_struct_at( header_start + offsetof( TerrainHeader, tile_cnt ), &output->terrain_tiles_written, output ) )
     {
     return( FALSE );
     }
 
 return( TRUE );
 
-} /* JumpToModelNode() */
+} /* WriteTerrainTileData() */
 
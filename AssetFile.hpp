@@ -14,8 +14,17 @@
                                     ( 10 )
 #define ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT \
                                     ( 50 )
+#define ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT \
+                                    ( 8 )
+#define ASSET_FILE_MODEL_MESHLET_MAX_VERTICES \
+                                    ( 64 )
+#define ASSET_FILE_MODEL_MESHLET_MAX_TRIANGLES \
+                                    ( 124 )
 #define ASSET_FILE_TEXTURE_EXTENT_ASSET_ID \
                                     0xffffffff
+#define ASSET_FILE_TEXTURE_MAX_MIP_CNT \
+                                    ( 16 )
+                                    /* 65535 texels wide down to 1  */
 
 #define ASSET_FILE_BINARY_FILENAME   "AllAssets.bin"
 
@@ -33,6 +42,18 @@
                         ( 257 )
 #define ASSET_FILE_TERRAIN_AXES_CNT   ( 1 << 8 )/* must be power two */
 #define ASSET_FILE_TERRAIN_CNT        ( ASSET_FILE_TERRAIN_AXES_CNT * ASSET_FILE_TERRAIN_AXES_CNT )
+#define ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT \
+                        ( ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT * ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT )
+#define ASSET_FILE_TERRAIN_LOD_MAX_COUNT \
+                                    ( 8 )
+#define ASSET_FILE_TERRAIN_MINMAX_LEVEL_CNT \
+                                    ( 6 )
+                                    /* 32x32 cells of 8x8 quads, up */
+                                    /*  to one cell for the tile    */
+#define ASSET_FILE_TERRAIN_MINMAX_CELL_EXTENT \
+                        ( ( ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT - 1 ) >> ( ASSET_FILE_TERRAIN_MINMAX_LEVEL_CNT - 1 ) )
+#define ASSET_FILE_TERRAIN_MINMAX_CNT \
+                        ( ( ( 1 << ( 2 * ASSET_FILE_TERRAIN_MINMAX_LEVEL_CNT ) ) - 1 ) / 3 )
 
 typedef struct
     {
@@ -54,9 +75,30 @@ typedef enum _AssetFileAssetKind
     ASSET_FILE_ASSET_KIND_SOUND_SAMPLE,
     ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP,
     ASSET_FILE_ASSET_KIND_TEXTURE,
-    ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS
+    ASSET_FILE_ASSET_KIND_TEXTURE_EXTENTS,
+    ASSET_FILE_ASSET_KIND_TERRAIN
     } AssetFileAssetKind;
 
+typedef enum _AssetFileCodec
+    {
+    ASSET_FILE_CODEC_NONE,
+    ASSET_FILE_CODEC_LZ,
+    /* count */
+    ASSET_FILE_CODEC_CNT
+    } AssetFileCodec;
+
+typedef enum _AssetFileTextureFormat
+    {
+    ASSET_FILE_TEXTURE_FORMAT_RAW,  /* uncompressed source pixels   */
+    ASSET_FILE_TEXTURE_FORMAT_BC1,  /* RGB, 8 bytes per 4x4 block   */
+    ASSET_FILE_TEXTURE_FORMAT_BC3,  /* RGBA, 16 bytes per 4x4 block */
+    ASSET_FILE_TEXTURE_FORMAT_BC4,  /* R, 8 bytes per 4x4 block     */
+    ASSET_FILE_TEXTURE_FORMAT_BC5,  /* RG, 16 bytes per 4x4 block   */
+    ASSET_FILE_TEXTURE_FORMAT_BC7,  /* RGBA, 16 bytes per 4x4 block */
+    /* count */
+    ASSET_FILE_TEXTURE_FORMAT_CNT
+    } AssetFileTextureFormat;
+
 typedef struct _AssetFileFontGlyph
     {
     u8                  glyph;      /* glyph ascii code             */
@@ -80,7 +122,8 @@ typedef enum _AssetFileModelElementKind
     ASSET_FILE_MODEL_ELEMENT_KIND_INVALID,
     ASSET_FILE_MODEL_ELEMENT_KIND_NODE,
     ASSET_FILE_MODEL_ELEMENT_KIND_MESH,
-    ASSET_FILE_MODEL_ELEMENT_KIND_MATERIAL
+    ASSET_FILE_MODEL_ELEMENT_KIND_MATERIAL,
+    ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS
     } AssetFileModelElementKind;
 
 typedef enum
@@ -109,6 +152,36 @@ enum
     ASSET_FILE_MODEL_MATERIAL_BIT_TRANSPARENCY     = ( 1 << ( ASSET_FILE_MODEL_TEXTURE_COUNT + 0 ) )
     };
 
+typedef enum _AssetFileModelIndexFormat
+    {
+    ASSET_FILE_MODEL_INDEX_FORMAT_U32,
+                                    /* 4 bytes per index            */
+    ASSET_FILE_MODEL_INDEX_FORMAT_U16,
+                                    /* 2 bytes, under 65536 vertices*/
+    /* count */
+    ASSET_FILE_MODEL_INDEX_FORMAT_CNT
+    } AssetFileModelIndexFormat;
+
+typedef enum _AssetFileModelVertexFormat
+    {
+    ASSET_FILE_MODEL_VERTEX_FORMAT_F32,
+                                    /* AssetFileModelVertex         */
+    ASSET_FILE_MODEL_VERTEX_FORMAT_PACKED,
+                                    /* AssetFileModelPackedVertex   */
+    /* count */
+    ASSET_FILE_MODEL_VERTEX_FORMAT_CNT
+    } AssetFileModelVertexFormat;
+
+typedef struct _AssetFileModelPackedVertex
+    {
+    u16                 x;          /* unorm position within bounds */
+    u16                 y;          /* unorm position within bounds */
+    u16                 z;          /* unorm position within bounds */
+    u16                 pad;        /* keeps uvs 4 byte aligned     */
+    u16                 u0;         /* half float texture coordinate*/
+    u16                 v0;         /* half float texture coordinate*/
+    } AssetFileModelPackedVertex;
+
 typedef struct _AssetFileModelVertex
     {
     f32                 x;          /* vertex position              */
@@ -121,10 +194,22 @@ typedef struct _AssetFileModelVertex
 typedef u32 AssetFileModelIndex; /* used to index vertices/
                                          meshes/nodes/materials     */
 
+typedef struct _AssetFileModelBounds
+    {
+    f32                 min[ 3 ];   /* axis aligned box corners     */
+    f32                 max[ 3 ];
+    f32                 center[ 3 ];/* bounding sphere center       */
+    f32                 radius;     /* bounding sphere radius, < 0  */
+                                    /*  when there is no geometry   */
+    } AssetFileModelBounds;
+
 typedef struct _AssetFileModelNode
     {
     f32                 transform[ 4 * 4 ];
                                     /* row major index              */
+    AssetFileModelBounds
+                        bounds;     /* meshes and child nodes, in   */
+                                    /*  this node's space           */
     AssetFileModelIndex child_meshes[ ASSET_FILE_MODEL_NODE_CHILD_MESH_MAX_COUNT ];
     AssetFileModelIndex child_nodes[ ASSET_FILE_MODEL_NODE_CHILD_NODE_MAX_COUNT ];
     u16                 child_mesh_count;
@@ -139,12 +224,110 @@ typedef struct _AssetFileModelMaterial
                                     /* material texture maps        */
     } AssetFileModelMaterial;
 
+typedef struct _AssetFileModelMeshLod
+    {
+    u32                 index_offset;
+                                    /* first index, after the full  */
+                                    /*  detail indices              */
+    u32                 index_count;
+    f32                 screen_size;/* use at or below this bounding*/
+                                    /*  sphere diameter, as part of */
+                                    /*  the screen height           */
+    f32                 error;      /* furthest the surface moved   */
+    } AssetFileModelMeshLod;
+
+typedef struct _AssetFileModelMeshlet
+    {
+    f32                 center[ 3 ];/* bounding sphere              */
+    f32                 radius;
+    f32                 cone_apex[ 3 ];
+                                    /* all triangles face away from */
+    f32                 cone_axis[ 3 ];
+                                    /*  a viewer v when dot( norm(  */
+    f32                 cone_cutoff;/*  apex - v ), axis ) >= cutoff*/
+                                    /*  - above 1 if never          */
+    u32                 vertex_offset;
+                                    /* first in the vertex list     */
+    u32                 triangle_offset;
+                                    /* first in the triangle list   */
+    u32                 vertex_count;
+    u32                 triangle_count;
+    } AssetFileModelMeshlet;
+
+typedef struct _AssetFileModelMeshlets
+    {
+    u32                 meshlet_count;
+    u32                 vertex_count;
+                                    /* length of the vertex list    */
+    u32                 triangle_count;
+                                    /* length of the triangle list  */
+    const AssetFileModelMeshlet
+                       *meshlets;
+    const u32          *vertices;   /* mesh vertex per meshlet vert */
+    const u8           *triangles;  /* 3 meshlet vertices per tri   */
+    } AssetFileModelMeshlets;
+
+typedef struct _AssetFileModelMesh
+    {
+    AssetFileModelIndex material;   /* material index               */
+    u32                 vertex_count;
+                                    /* number of vertices           */
+    u32                 index_count;/* number of indices            */
+    AssetFileModelVertexFormat
+                        vertex_format;
+                                    /* stored layout of the vertices*/
+    AssetFileModelIndexFormat
+                        index_format;
+                                    /* stored width of the indices  */
+    f32                 position_offset[ 3 ];
+                                    /* offset + stored * scale gives*/
+    f32                 position_scale[ 3 ];
+                                    /*  the position                */
+    AssetFileModelBounds
+                        bounds;     /* vertex positions             */
+    const void         *vertices;   /* layout per vertex_format     */
+    const void         *indices;    /* u16 or u32 per index_format  */
+    u32                 lod_count;  /* coarser levels of detail     */
+    AssetFileModelMeshLod
+                        lods[ ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT ];
+                                    /* finest first, sharing the    */
+                                    /*  vertices                    */
+    AssetFileModelMeshlets
+                        meshlets;   /* empty unless exported        */
+    } AssetFileModelMesh;
+
+typedef struct _AssetFileModel
+    {
+    u32                 node_count; /* number of nodes              */
+    u32                 mesh_count; /* number of meshes             */
+    u32                 material_count;
+                                    /* number unique materials      */
+    AssetFileModelIndex root_node;  /* node index of the root       */
+    AssetFileModelNode *nodes;      /* node tree                    */
+    AssetFileModelMesh *meshes;     /* meshes with geometry pointers*/
+    AssetFileModelMaterial
+                       *materials;  /* materials                    */
+    } AssetFileModel;
+
 typedef struct _AssetFileSoundPair
     {
     AssetFileAssetId    asset_id;       /* ID of the sound          */
     u32                 subsound_index; /* index within bank        */
     } AssetFileSoundPair; 
 
+typedef struct _AssetFileTerrainLod
+    {
+    u32                 step;       /* samples between vertices     */
+    u32                 index_count;
+    } AssetFileTerrainLod;          /* index pattern over the sample*/
+                                    /*  grid, shared by all tiles   */
+
+typedef struct _AssetFileTerrainMinMax
+    {
+    u16                 min;        /* lowest sample in the cell    */
+    u16                 max;        /* highest sample in the cell   */
+    } AssetFileTerrainMinMax;
+
 typedef struct _AssetFileTextureExtent
     {
     AssetFileAssetId    texture_id; /* ID of the texture            */
@@ -155,69 +338,206 @@ typedef struct _AssetFileTextureExtent
 typedef struct _AssetFileWriter
     {
     fhnd                hnd;        /* file handle                  */
-    u32                 caret;      /* working write location       */
+    u64                 caret;      /* working write location       */
     u32                 table_cnt;  /* number entries in table      */
     AssetFileAssetKind  kind;       /* asset kind under write       */
-    u32                 asset_start;/* start of asset under write   */
+    u64                 asset_start;/* start of asset under write   */
     u32                 model_vertices_written;
     u32                 model_indices_written;
+    AssetFileModelIndexFormat
+                        model_index_format;
+                                    /* width of mesh under write    */
+    AssetFileModelVertexFormat
+                        model_vertex_format;
+                                    /* layout of mesh under write   */
+    f32                 model_position_offset[ 3 ];
+                                    /* quantization of mesh under   */
+    f32                 model_position_scale[ 3 ];
+                                    /*  write                       */
+    u64                 model_mesh_start;
+                                    /* header of mesh under write   */
+    u32                 texture_mips_written;
+    u32                 terrain_tiles_written;
+    u32                 terrain_lods_written;
+    struct _AssetFileTableRow
+                       *table;      /* asset table, written at close*/
+    byte               *buffer;     /* staged output not yet written*/
+    u64                 buffer_start;
+                                    /* file location of buffer[ 0 ] */
+    u64                 buffer_sz;  /* number of staged bytes       */
+    u64                 buffer_cap; /* staging buffer capacity      */
+    struct _AssetFileTableRow
+                       *asset_row;  /* table row of asset under write*/
+    AssetFileCodec      codec;      /* compression for new assets   */
+    u64                *payload_hashes;
+                                    /* stored bytes hash, per row   */
+    u32                *payload_slots;
+                                    /* row index + 1 by hash, or 0  */
+    u32                 payload_slot_cnt;
+                                    /* power of two slot count      */
+    u32                 shared_cnt; /* assets sharing a payload     */
+    u64                 shared_sz;  /* bytes not written by sharing */
     } AssetFileWriter;
 
-typedef struct _AssetFileReader
+typedef struct _AssetFilePack
     {
     fhnd                hnd;        /* file handle                  */
-    AssetFileAssetKind  kind;       /* asset kind under read        */
-    u32                 asset_start;/* start of asset under read    */
+    const byte         *map;        /* mapped file view, or NULL    */
+    u64                 map_sz;     /* byte size of mapped view     */
+    void               *map_hnd;    /* platform mapping handle      */
+    void               *read_hnd;   /* platform positional read     */
+                                    /*  handle, see file_read_at()  */
     u32                 table_cnt;  /* number entries in table      */
+    const struct _AssetFileTableRow
+                       *table;      /* asset table rows, id sorted  */
+    struct _AssetFileTableKey
+                       *table_keys; /* eytzinger ordered table ids  */
+    void               *table_mem;  /* owned table row storage      */
+    } AssetFilePack;
+
+typedef struct _AssetFileReader
+    {
+    const AssetFilePack
+                       *pack;       /* shared file and asset table  */
+    AssetFilePack      *owned_pack; /* pack opened by this reader   */
+    AssetFileAssetKind  kind;       /* asset kind under read        */
+    u64                 asset_start;/* start of asset under read    */
+    const struct _AssetFileTableRow
+                       *asset_row;  /* table row of asset under read*/
+    const byte         *asset_data; /* decompressed asset, or NULL  */
+    const byte         *blob;       /* stored asset in memory, or NULL*/
+    byte               *scratch;    /* decompression buffer         */
+    u64                 scratch_cap;/* decompression buffer capacity*/
     } AssetFileReader;
 
+typedef void (*AssetFileLoadCallback)( const AssetFileAssetId id, AssetFileReader *input, void *user );
+                                    /* input is NULL if load failed */
 
+typedef struct _AssetFileLoadRequest
+    {
+    AssetFileAssetId    id;         /* asset to load                */
+    AssetFileAssetKind  kind;       /* expected kind of the asset   */
+    u32                 priority;   /* higher values load first     */
+    AssetFileLoadCallback
+                        callback;   /* run on the loader thread     */
+    void               *user;       /* passed through to callback   */
+    } AssetFileLoadRequest;
+
+typedef struct _AssetFileLoader
+    {
+    AssetFileReader     input;      /* reader owned by loader thread*/
+    struct _AssetFileLoaderQueue
+                       *queue;      /* requests shared with thread  */
+    } AssetFileLoader;
+
+
+b8  AssetFile_AppendFromMemory( const AssetFileWriter *blob, AssetFileWriter *output );
 b8  AssetFile_BeginReadingAsset( const AssetFileAssetId id, const AssetFileAssetKind kind, AssetFileReader *input );
+b8  AssetFile_BeginReadingBlob( const AssetFileAssetId id, const AssetFileAssetKind kind, const byte *blob, const u64 blob_sz, AssetFileReader *input );
 b8  AssetFile_BeginWritingAsset( const AssetFileAssetId id, const AssetFileAssetKind kind, AssetFileWriter *output );
 b8  AssetFile_BeginWritingModelElement( const AssetFileModelElementKind kind, const AssetFileModelIndex element_index, AssetFileWriter *output );
+b8  AssetFile_BuildTerrainMinMax( const u16 *samples, AssetFileTerrainMinMax *min_max );
 b8  AssetFile_CloseForRead( AssetFileReader *input );
 b8  AssetFile_CloseForWrite( AssetFileWriter *output );
+b8  AssetFile_CloseLoader( AssetFileLoader *loader );
+b8  AssetFile_ClosePack( AssetFilePack *pack );
+b8  AssetFile_CompressTerrainTile( const u16 *samples, const u32 buffer_sz, u32 *byte_size, byte *buffer );
+b8  AssetFile_CopyAsset( const AssetFileAssetId id, AssetFileReader *input, AssetFileWriter *output );
+b8  AssetFile_CreateForMemory( const AssetFileAssetId *ids, const u32 ids_count, AssetFileWriter *output );
 b8  AssetFile_CreateForWrite( const char *filename, const AssetFileAssetId *ids, const u32 ids_count, AssetFileWriter *output );
 b8  AssetFile_DescribeFont( const u8 oversample_x, const u8 oversample_y, const u16 texture_width, const u16 texture_height, const u32 texture_sz, const u8 *pixels, const u16 glyph_cnt, const u8 *glyph_codes, AssetFileWriter *output );
 b8  AssetFile_DescribeModel( const u32 node_count, const u32 mesh_count, const u32 material_count, AssetFileWriter *output );
+b8  AssetFile_DescribeModel2( const u32 node_count, const u32 mesh_count, const u32 material_count, const b8 with_meshlets, AssetFileWriter *output );
 b8  AssetFile_DescribeModelMaterial( const AssetFileModelMaterialBits maps, AssetFileWriter *output );
 b8  AssetFile_DescribeModelMesh( const u32 material_element_index, const u32 vertex_cnt, const u32 index_cnt, AssetFileWriter *output );
+b8  AssetFile_DescribeModelMesh2( const u32 material_element_index, const u32 vertex_cnt, const u32 index_cnt, const AssetFileModelIndexFormat index_format, const AssetFileModelVertexFormat vertex_format, const AssetFileModelBounds *bounds, AssetFileWriter *output );
+b8  AssetFile_DescribeModelMeshLods( const u32 lod_cnt, const AssetFileModelMeshLod *lods, AssetFileWriter *output );
 b8  AssetFile_DescribeModelNode( const u32 node_count, const f32 *mat4x4, const u32 mesh_count, AssetFileWriter *output );
+b8  AssetFile_DescribeModelNode2( const u32 node_count, const f32 *mat4x4, const u32 mesh_count, const AssetFileModelBounds *bounds, AssetFileWriter *output );
 b8  AssetFile_DescribeShader( const u32 byte_size, AssetFileWriter *output );
+b8  AssetFile_DescribeTerrain( AssetFileWriter *output );
 b8  AssetFile_DescribeTexture( const u32 byte_size, AssetFileWriter *output );
-b8  AssetFile_DescribeTexture2( const u32 channel_cnt, const u32 channel_width, const u32 width, const u32 height, const u32 byte_size, AssetFileWriter *output );
+b8  AssetFile_DescribeTexture2( const AssetFileTextureFormat format, const u32 channel_cnt, const u32 channel_width, const u32 width, const u32 height, const u32 byte_size, AssetFileWriter *output );
 b8  AssetFile_DescribeTextureExtents( const u16 element_cnt, AssetFileWriter *output );
+b8  AssetFile_DequantizeModelVertices( const AssetFileModelMesh *mesh, const u32 first_vertex, const u32 vertex_cnt, AssetFileModelVertex *vertices );
 b8  AssetFile_EndReadingAsset( AssetFileReader *input );
 b8  AssetFile_EndWritingAsset( AssetFileWriter *output );
 b8  AssetFile_EndWritingModel( const u32 root_node_element, AssetFileWriter *output );
+b8  AssetFile_FindSoundSubsound( const AssetFileAssetId id, u32 *subsound_index, AssetFileReader *input );
+b8  AssetFile_GetDedupSavings( u32 *asset_cnt, u64 *saved_sz, const AssetFileWriter *output );
+u64 AssetFile_GetLogicalWriteSize( const AssetFileWriter *output );
 u64 AssetFile_GetWriteSize( const AssetFileWriter *output );
+b8  AssetFile_LoadModel( const u64 arena_sz, void *arena, AssetFileModel *model, AssetFileReader *input );
+b8  AssetFile_LoadModelStorageRequirements( u64 *arena_sz, AssetFileReader *input );
+b8  AssetFile_MapFontTexture( const u8 **pixels, u32 *texture_sz, u16 *width, u16 *height, AssetFileReader *input );
+b8  AssetFile_MapModelMesh( const u32 mesh_index, AssetFileModelMesh *mesh, AssetFileReader *input );
+b8  AssetFile_MapModelMeshIndices( const u32 mesh_index, u32 *index_count, const AssetFileModelIndex **indices, AssetFileReader *input );
+b8  AssetFile_MapModelMeshIndices2( const u32 mesh_index, u32 *index_count, AssetFileModelIndexFormat *index_format, const void **indices, AssetFileReader *input );
+b8  AssetFile_MapModelMeshlets( const u32 mesh_index, AssetFileModelMeshlets *meshlets, AssetFileReader *input );
+b8  AssetFile_MapModelMeshVertices( const u32 mesh_index, AssetFileModelIndex *material_index, u32 *vertex_count, const AssetFileModelVertex **vertices, AssetFileReader *input );
+b8  AssetFile_MapShaderBinary( u32 *byte_size, const byte **buffer, AssetFileReader *input );
+b8  AssetFile_MapTerrainLodIndices( const u32 lod_index, u32 *index_count, const u32 **indices, AssetFileReader *input );
+b8  AssetFile_MapTerrainTile( const u32 x, const u32 z, const u16 **samples, AssetFileReader *input );
+b8  AssetFile_MapTerrainTileMinMax( const u32 x, const u32 z, const AssetFileTerrainMinMax **min_max, AssetFileReader *input );
+b8  AssetFile_MapTextureBinary( u32 *byte_size, const byte **buffer, AssetFileReader *input );
+b8  AssetFile_MapTextureMip( const u32 mip_index, u32 *byte_size, const byte **buffer, AssetFileReader *input );
 b8  AssetFile_OpenForRead( const char *filename, AssetFileReader *input );
+b8  AssetFile_OpenForReadFromPack( const AssetFilePack *pack, AssetFileReader *input );
+b8  AssetFile_OpenForReadMapped( const char *filename, AssetFileReader *input );
+b8  AssetFile_OpenLoader( const char *filename, AssetFileLoader *loader );
+b8  AssetFile_OpenPack( const char *filename, AssetFilePack *pack );
+b8  AssetFile_OpenPackMapped( const char *filename, AssetFilePack *pack );
 b8  AssetFile_ReadFontGlyphs( const u16 glyph_capacity, AssetFileFontGlyph *glyphs, AssetFileReader *input );
 b8  AssetFile_ReadFontTexture( const u32 buffer_sz, u8 *pixels, u16 *width, u16 *height, AssetFileReader *input );
 b8  AssetFile_ReadFontStorageRequirements( u16 *glyph_cnt, u32 *texture_sz, AssetFileReader *input );
 b8  AssetFile_ReadModelMaterials( const u32 material_capacity, u32 *material_count, AssetFileModelMaterial *materials, AssetFileReader *input );
+b8  AssetFile_ReadModelMeshBounds( const u32 mesh_index, AssetFileModelBounds *bounds, AssetFileReader *input );
 b8  AssetFile_ReadModelMeshIndices( const u32 mesh_index, const u32 index_capacity, u32 *index_count, AssetFileModelIndex *indices, AssetFileReader *input );
+b8  AssetFile_ReadModelMeshlets( const u32 mesh_index, const u32 meshlet_capacity, AssetFileModelMeshlet *meshlets, const u32 vertex_capacity, u32 *vertices, const u32 triangle_capacity, u8 *triangles, AssetFileReader *input );
+b8  AssetFile_ReadModelMeshletsStorageRequirements( const u32 mesh_index, u32 *meshlet_count, u32 *vertex_count, u32 *triangle_count, AssetFileReader *input );
+b8  AssetFile_ReadModelMeshLodIndices( const u32 mesh_index, const u32 lod_index, const u32 index_capacity, u32 *index_count, AssetFileModelIndex *indices, AssetFileReader *input );
+b8  AssetFile_ReadModelMeshLods( const u32 mesh_index, u32 *lod_count, AssetFileModelMeshLod *lods, AssetFileReader *input );
 b8  AssetFile_ReadModelMeshVertices( const u32 mesh_index, const u32 vertex_capacity, AssetFileModelIndex *material_index, u32 *vertex_count, AssetFileModelVertex *vertices, AssetFileReader *input );
 b8  AssetFile_ReadModelNodes( const u32 node_capacity, u32 *node_count, AssetFileModelNode *nodes, AssetFileReader *input );
 b8  AssetFile_ReadModelStorageRequirements( u32 *vertex_count, u32 *index_count, u32 *mesh_count, u32 *node_count, u32 *material_count, AssetFileReader *input );
 b8  AssetFile_ReadShaderBinary( const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input );
-b8  AssetFile_ReadSoundPairs( u16 num_pairs, AssetFileSoundPair *sound_pairs, AssetFileReader *input );
-b8  AssetFile_ReadSoundPairsStorageRequirements( u16 *num_elements, AssetFileReader *input );
+b8  AssetFile_ReadSoundPairs( const u32 num_pairs, AssetFileSoundPair *sound_pairs, AssetFileReader *input );
+b8  AssetFile_ReadSoundPairsStorageRequirements( u32 *num_elements, AssetFileReader *input );
 b8  AssetFile_ReadShaderStorageRequirements( u32 *byte_count, AssetFileReader *input );
+b8  AssetFile_ReadTerrainLodIndices( const u32 lod_index, const u32 index_capacity, u32 *index_count, u32 *indices, AssetFileReader *input );
+b8  AssetFile_ReadTerrainLods( u32 *lod_count, AssetFileTerrainLod *lods, AssetFileReader *input );
+b8  AssetFile_ReadTerrainStorageRequirements( u32 *tile_count, u32 *sample_count, AssetFileReader *input );
+b8  AssetFile_ReadTerrainTile( const u32 x, const u32 z, const u32 sample_capacity, u16 *samples, AssetFileReader *input );
+b8  AssetFile_ReadTerrainTileMinMax( const u32 x, const u32 z, AssetFileTerrainMinMax *min_max, AssetFileReader *input );
 b8  AssetFile_ReadTextureExtentsStorageRequirements( u16 *num_elements, AssetFileReader *input );
 b8  AssetFile_ReadTextureBinary( const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input );
 b8  AssetFile_ReadTextureStorageRequirements( u32 *channel_cnt, u32 *channel_width, u32 *width, u32 *height, u32 *byte_count, AssetFileReader *input );
 b8  AssetFile_ReadTextureExtents( const u16 output_cnt, AssetFileTextureExtent *out_elements, AssetFileReader *input );
 b8  AssetFile_ReadTextureExtentsStorageRequirements( u16 *element_cnt, AssetFileReader *input );
+b8  AssetFile_ReadTextureFormat( AssetFileTextureFormat *format, AssetFileReader *input );
+b8  AssetFile_ReadTextureMip( const u32 mip_index, const u32 buffer_sz, u32 *read_sz, byte *buffer, AssetFileReader *input );
+b8  AssetFile_ReadTextureMipCount( u32 *mip_cnt, AssetFileReader *input );
+b8  AssetFile_ReadTextureMipStorageRequirements( const u32 mip_index, u32 *width, u32 *height, u32 *byte_count, AssetFileReader *input );
+b8  AssetFile_SetCompression( const AssetFileCodec codec, AssetFileWriter *output );
+b8  AssetFile_SubmitLoads( const AssetFileLoadRequest *requests, const u32 request_cnt, AssetFileLoader *loader );
+b8  AssetFile_WaitForLoads( AssetFileLoader *loader );
 b8  AssetFile_WriteFontGlyph( const u8 glyph, const u16 u0, const u16 v0, const u16 u1, const u16 v1, const f32 pen_dx, const f32 pen_dy, const f32 pen_xadvance, AssetFileWriter *output );
 b8  AssetFile_WriteModelMaterialTextureMaps( const AssetFileAssetId *asset_ids, const u8 count, AssetFileWriter *output );
 b8  AssetFile_WriteModelMeshIndex( const AssetFileModelIndex index, AssetFileWriter *output );
+b8  AssetFile_WriteModelMeshIndices( const AssetFileModelIndex *indices, const u32 count, AssetFileWriter *output );
+b8  AssetFile_WriteModelMeshlets( const AssetFileModelMeshlets *meshlets, AssetFileWriter *output );
 b8  AssetFile_WriteModelMeshVertex( const AssetFileModelVertex *vertex, AssetFileWriter *output );
+b8  AssetFile_WriteModelMeshVertices( const AssetFileModelVertex *vertices, const u32 count, AssetFileWriter *output );
 b8  AssetFile_WriteModelNodeChildElements( const AssetFileModelIndex *element_ids, const u32 count, AssetFileWriter *output );
 b8  AssetFile_WriteShader( const byte *blob, const u32 blob_size, AssetFileWriter *output );
-b8  AssetFile_WriteSoundPairs( const AssetFileSoundPair *sound_pair, const u16 num_pairs, AssetFileWriter *output );
+b8  AssetFile_WriteSoundPairs( const AssetFileSoundPair *sound_pair, const u32 num_pairs, AssetFileWriter *output );
+b8  AssetFile_WriteTerrainLod( const u32 step, const u32 index_count, const u32 *indices, AssetFileWriter *output );
+b8  AssetFile_WriteTerrainTile( const u32 x, const u32 z, const u16 *samples, AssetFileWriter *output );
+b8  AssetFile_WriteTerrainTile2( const u32 x, const u32 z, const AssetFileTerrainMinMax *min_max, const u16 *samples, AssetFileWriter *output );
+b8  AssetFile_WriteTerrainTileCompressed( const u32 x, const u32 z, const AssetFileTerrainMinMax *min_max, const u32 byte_size, const byte *buffer, AssetFileWriter *output );
 b8  AssetFile_WriteTexture( const byte *image, const u32 image_size, AssetFileWriter *output );
 b8  AssetFile_WriteTextureExtent( const AssetFileAssetId id, const u16 width, const u16 height, AssetFileWriter *output );
+b8  AssetFile_WriteTextureMip( const byte *image, const u32 image_size, AssetFileWriter *output );
 
 
 /*******************************************************************
@@ -332,7 +652,9 @@ return( ret );
 *   AssetFile_GetTerrainNameString()
 *
 *   DESCRIPTION:
-*       Get the string name of a terrain height asset.
+*       Get the string name of a terrain height asset.  Tiles of a
+*       terrain kind asset are found by AssetFile_ReadTerrainTile()
+*       without a name.
 *
 *******************************************************************/
 
@@ -347,3 +669,30 @@ sprintf( ret.str, "tex/terr_%u_%u", x, z );
 return( ret );
 
 } /* AssetFile_GetTerrainNameString() */
+
+
+/*******************************************************************
+*
+*   AssetFile_GetTerrainMinMaxIndex()
+*
+*   DESCRIPTION:
+*       Get where a cell of a tile's min/max pyramid is kept.  Level
+*       zero has the finest cells, each level above halves the cells
+*       along each edge, and each level's cells run in rows of
+*       increasing z, each in increasing x.
+*
+*******************************************************************/
+
+static inline u32 AssetFile_GetTerrainMinMaxIndex( const u32 level, const u32 cell_x, const u32 cell_z )
+{
+u32 ret = 0;
+u32 extent = 1u << ( ASSET_FILE_TERRAIN_MINMAX_LEVEL_CNT - 1 );
+for( u32 i = 0; i < level; i++ )
+    {
+    ret += extent * extent;
+    extent >>= 1;
+    }
+
+return( ret + cell_z * extent + cell_x );
+
+} /* AssetFile_GetTerrainMinMaxIndex() */
@@ -0,0 +1,792 @@
+#pragma once
+#include <string.h>
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#include <emmintrin.h>
+#define COMPRESS_USE_SSE2
+#endif
+
+#include "Global.hpp"
+
+/*******************************************************************
+*
+*   LZ block codec
+*
+*   Byte-oriented LZ77 in the LZ4 block layout: each sequence is a
+*   token (literal length : 4, match length - 4 : 4), any extra
+*   literal length bytes, the literals, a little-endian 16-bit match
+*   offset, then any extra match length bytes.  A length nibble of 15
+*   continues in following bytes, each adding up to 255.  The final
+*   sequence is literals only, and matches stop short of the end of
+*   the block so the decoder can copy in 8 byte steps.
+*
+*******************************************************************/
+
+#define COMPRESS_LZ_MIN_MATCH       ( 4 )
+#define COMPRESS_LZ_MAX_OFFSET      ( 65535 )
+#define COMPRESS_LZ_END_LITERALS    ( 5 )
+                                    /* block always ends in literals*/
+#define COMPRESS_LZ_MATCH_LIMIT     ( 12 )
+                                    /* no match starts in last bytes*/
+#define COMPRESS_LZ_HASH_BITS       ( 14 )
+
+static inline void compress_lz_copy8( byte *dst, const byte *src );
+static inline u32  compress_lz_count( const byte *a, const byte *b, const byte *a_limit );
+static inline u32  compress_lz_hash( const byte *src );
+static inline u32  compress_lz_read32( const byte *src );
+static inline byte *compress_lz_write_length( u32 length, byte *dst );
+
+
+/*******************************************************************
+*
+*   compress_lz()
+*
+*   DESCRIPTION:
+*       Compress the source into the destination block.  Returns the
+*       compressed byte count, or zero if it did not fit.
+*
+*******************************************************************/
+
+static inline u32 compress_lz( const byte *src, const u32 src_sz, byte *dst, const u32 dst_cap )
+{
+u32 table[ 1 << COMPRESS_LZ_HASH_BITS ];
+memset( table, 0xff, sizeof( table ) );
+
+const byte *ip       = src;
+const byte *anchor   = src;
+const byte *iend     = src + src_sz;
+const byte *mflimit  = src_sz > COMPRESS_LZ_MATCH_LIMIT ? iend - COMPRESS_LZ_MATCH_LIMIT : src;
+const byte *matchend = src_sz > COMPRESS_LZ_MATCH_LIMIT ? iend - COMPRESS_LZ_END_LITERALS : src;
+byte       *op       = dst;
+byte       *oend     = dst + dst_cap;
+
+while( ip < mflimit )
+    {
+    /* find a match, stepping faster through incompressible data */
+    u32 h = compress_lz_hash( ip );
+    u32 candidate = table[ h ];
+    table[ h ] = (u32)( ip - src );
+    if( candidate == 0xffffffff
+     || (u32)( ip - src ) - candidate > COMPRESS_LZ_MAX_OFFSET
+     || compress_lz_read32( src + candidate ) != compress_lz_read32( ip ) )
+        {
+        ip += 1 + ( ( ip - anchor ) >> 6 );
+        continue;
+        }
+
+    const byte *match = src + candidate;
+
+    /* extend backwards over literals */
+    while( ip > anchor
+        && match > src
+        && ip[ -1 ] == match[ -1 ] )
+        {
+        ip--;
+        match--;
+        }
+
+    /* extend forwards */
+    const byte *mp = ip + COMPRESS_LZ_MIN_MATCH;
+    mp += compress_lz_count( mp, match + COMPRESS_LZ_MIN_MATCH, matchend );
+
+    u32 literal_len = (u32)( ip - anchor );
+    u32 match_len   = (u32)( mp - ip ) - COMPRESS_LZ_MIN_MATCH;
+    if( op + 1 + literal_len / 255 + 1 + literal_len + 2 + match_len / 255 + 1 > oend )
+        {
+        return( 0 );
+        }
+
+    byte *token = op++;
+    *token = (byte)( ( literal_len >= 15 ? 15 : literal_len ) << 4 );
+    if( literal_len >= 15 )
+        {
+        op = compress_lz_write_length( literal_len - 15, op );
+        }
+
+    memcpy( op, anchor, literal_len );
+    op += literal_len;
+
+    u32 offset = (u32)( ip - match );
+    *op++ = (byte)( offset & 0xff );
+    *op++ = (byte)( offset >> 8 );
+
+    *token |= (byte)( match_len >= 15 ? 15 : match_len );
+    if( match_len >= 15 )
+        {
+        op = compress_lz_write_length( match_len - 15, op );
+        }
+
+    ip = mp;
+    anchor = ip;
+    if( ip - 2 > src )
+        {
+        table[ compress_lz_hash( ip - 2 ) ] = (u32)( ip - 2 - src );
+        }
+    }
+
+/* trailing literals */
+u32 literal_len = (u32)( iend - anchor );
+if( op + 1 + literal_len / 255 + 1 + literal_len > oend )
+    {
+    return( 0 );
+    }
+
+*op++ = (byte)( ( literal_len >= 15 ? 15 : literal_len ) << 4 );
+if( literal_len >= 15 )
+    {
+    op = compress_lz_write_length( literal_len - 15, op );
+    }
+
+if( literal_len )
+    {
+    memcpy( op, anchor, literal_len );
+    op += literal_len;
+    }
+
+return( (u32)( op - dst ) );
+
+} /* compress_lz() */
+
+
+/*******************************************************************
+*
+*   compress_lz_bound()
+*
+*   DESCRIPTION:
+*       Worst case compressed size of a source of the given size.
+*
+*******************************************************************/
+
+static inline u32 compress_lz_bound( const u32 src_sz )
+{
+return( src_sz + src_sz / 255 + 16 );
+
+} /* compress_lz_bound() */
+
+
+/*******************************************************************
+*
+*   decompress_lz()
+*
+*   DESCRIPTION:
+*       Decompress the block into exactly dst_sz bytes.  Fails on any
+*       malformed input rather than reading or writing out of bounds.
+*
+*******************************************************************/
+
+static inline b8 decompress_lz( const byte *src, const u32 src_sz, byte *dst, const u32 dst_sz )
+{
+const byte *ip   = src;
+const byte *iend = src + src_sz;
+byte       *op   = dst;
+byte       *oend = dst + dst_sz;
+
+while( ip < iend )
+    {
+    u32 token = *ip++;
+
+    /* literals */
+    u32 literal_len = token >> 4;
+    if( literal_len < 15
+     && iend - ip >= 16 + 2
+     && oend - op >= 16 + 32 )
+        {
+        /* short run well clear of the block ends, copy a fixed 16 bytes and let the excess be overwritten */
+        compress_lz_copy8( op, ip );
+        compress_lz_copy8( op + 8, ip + 8 );
+        ip += literal_len;
+        op += literal_len;
+        }
+    else
+        {
+        if( literal_len == 15 )
+            {
+            u32 extra = 0;
+            do
+                {
+                if( ip >= iend )
+                    {
+                    return( FALSE );
+                    }
+
+                extra = *ip++;
+                literal_len += extra;
+                } while( extra == 255 );
+            }
+
+        if( literal_len > (u32)( iend - ip )
+         || literal_len > (u32)( oend - op ) )
+            {
+            return( FALSE );
+            }
+
+        memcpy( op, ip, literal_len );
+        ip += literal_len;
+        op += literal_len;
+
+        if( ip == iend )
+            {
+            break;
+            }
+
+        if( iend - ip < 2 )
+            {
+            return( FALSE );
+            }
+        }
+
+    /* match */
+    u32 offset = (u32)ip[ 0 ] | ( (u32)ip[ 1 ] << 8 );
+    ip += 2;
+
+    u32 match_len = token & 15;
+    if( match_len == 15 )
+        {
+        u32 extra = 0;
+        do
+            {
+            if( ip >= iend )
+                {
+                return( FALSE );
+                }
+
+            extra = *ip++;
+            match_len += extra;
+            } while( extra == 255 );
+        }
+
+    match_len += COMPRESS_LZ_MIN_MATCH;
+    if( offset == 0
+     || offset > (u32)( op - dst )
+     || match_len > (u32)( oend - op ) )
+        {
+        return( FALSE );
+        }
+
+    const byte *match = op - offset;
+    byte *match_end = op + match_len;
+    if( offset >= 8
+     && match_len <= 16 + COMPRESS_LZ_MIN_MATCH
+     && oend - op >= 24 )
+        {
+        /* short match, copy a fixed 24 bytes */
+        compress_lz_copy8( op, match );
+        compress_lz_copy8( op + 8, match + 8 );
+        compress_lz_copy8( op + 16, match + 16 );
+        op = match_end;
+        continue;
+        }
+
+    if( (u32)( oend - match_end ) < 8 )
+        {
+        while( op < match_end )
+            {
+            *op++ = *match++;
+            }
+
+        continue;
+        }
+
+    if( offset < 8 )
+        {
+        /* short repeating pattern, widen the offset to a whole number of periods of at least 8 bytes */
+        byte *pattern_end = op + ( match_len < 8 ? match_len : 8 );
+        while( op < pattern_end )
+            {
+            *op++ = *match++;
+            }
+
+        if( op < match_end )
+            {
+            match = op - offset * ( ( 8 + offset - 1 ) / offset );
+            }
+        }
+
+    /* may write up to 7 bytes past the match, which get overwritten */
+    while( op < match_end )
+        {
+        compress_lz_copy8( op, match );
+        op += 8;
+        match += 8;
+        }
+
+    op = match_end;
+    }
+
+return( op == oend );
+
+} /* decompress_lz() */
+
+
+/*******************************************************************
+*
+*   compress_lz_copy8()
+*
+*******************************************************************/
+
+static inline void compress_lz_copy8( byte *dst, const byte *src )
+{
+memcpy( dst, src, 8 );
+
+} /* compress_lz_copy8() */
+
+
+/*******************************************************************
+*
+*   compress_lz_count()
+*
+*   DESCRIPTION:
+*       Count the matching bytes at a and b, a word at a time.
+*
+*******************************************************************/
+
+static inline u32 compress_lz_count( const byte *a, const byte *b, const byte *a_limit )
+{
+const byte *start = a;
+while( a_limit - a >= 8 )
+    {
+    u64 wa;
+    u64 wb;
+    memcpy( &wa, a, sizeof( wa ) );
+    memcpy( &wb, b, sizeof( wb ) );
+
+    u64 diff = wa ^ wb;
+    if( diff )
+        {
+        /* little-endian, so the lowest set bit is the first differing byte */
+#if defined( _MSC_VER )
+        unsigned long bit;
+        _BitScanForward64( &bit, diff );
+#else
+        u32 bit = (u32)__builtin_ctzll( diff );
+#endif
+        return( (u32)( a - start ) + (u32)( bit >> 3 ) );
+        }
+
+    a += 8;
+    b += 8;
+    }
+
+while( a < a_limit
+    && *a == *b )
+    {
+    a++;
+    b++;
+    }
+
+return( (u32)( a - start ) );
+
+} /* compress_lz_count() */
+
+
+/*******************************************************************
+*
+*   compress_lz_hash()
+*
+*******************************************************************/
+
+static inline u32 compress_lz_hash( const byte *src )
+{
+return( ( compress_lz_read32( src ) * 2654435761u ) >> ( 32 - COMPRESS_LZ_HASH_BITS ) );
+
+} /* compress_lz_hash() */
+
+
+/*******************************************************************
+*
+*   compress_lz_read32()
+*
+*******************************************************************/
+
+static inline u32 compress_lz_read32( const byte *src )
+{
+u32 ret;
+memcpy( &ret, src, sizeof( ret ) );
+
+return( ret );
+
+} /* compress_lz_read32() */
+
+
+/*******************************************************************
+*
+*   compress_lz_write_length()
+*
+*******************************************************************/
+
+static inline byte *compress_lz_write_length( u32 length, byte *dst )
+{
+while( length >= 255 )
+    {
+    *dst++ = 255;
+    length -= 255;
+    }
+
+*dst++ = (byte)length;
+
+return( dst );
+
+} /* compress_lz_write_length() */
+
+
+/*******************************************************************
+*
+*   Terrain height codec
+*
+*   Lossless coding of a grid of 16-bit heights.  Each sample is
+*   predicted as left + up - up_left, the plane through its three
+*   earlier neighbours, with samples outside the grid taken as zero,
+*   and the residual kept modulo 2^16.  Residuals are zigzag mapped
+*   and Rice coded into an LSB-first bit stream, in blocks which
+*   each start with a 4-bit Rice parameter.  A quotient that reaches
+*   the escape is written as that many one bits, then the zigzagged
+*   residual in 16 bits.
+*
+*   Undoing the prediction is a running sum along each row of the
+*   residual plus the slope of the row above, so the decoder does it
+*   eight samples at a time where SSE2 is available.
+*
+*******************************************************************/
+
+#define COMPRESS_TERRAIN_BLOCK_CNT  ( 32 )
+                                    /* residuals per Rice parameter */
+#define COMPRESS_TERRAIN_K_BITS     ( 4 )
+#define COMPRESS_TERRAIN_ESCAPE     ( 16 )
+                                    /* quotient coded as raw bits   */
+
+typedef struct
+    {
+    byte               *op;
+    byte               *oend;
+    u64                 acc;        /* bits not yet stored          */
+    u32                 bits;       /* number of bits in acc        */
+    } CompressTerrainBits;
+
+static inline u32  compress_terrain_ctz( const u64 value );
+static inline b8   compress_terrain_put( const u32 value, const u32 cnt, CompressTerrainBits *bits );
+static inline u16  compress_terrain_residual( const u16 *src, const u32 width, const u32 index );
+static inline void compress_terrain_unpredict_row( const u16 *up, const u32 width, u16 *row );
+
+
+/*******************************************************************
+*
+*   compress_terrain()
+*
+*   DESCRIPTION:
+*       Compress a width by height grid of heights, stored in rows,
+*       into the destination.  Returns the compressed byte count, or
+*       zero if it did not fit.
+*
+*******************************************************************/
+
+static inline u32 compress_terrain( const u16 *src, const u32 width, const u32 height, byte *dst, const u32 dst_cap )
+{
+const u32 sample_cnt = width * height;
+
+CompressTerrainBits out = {};
+out.op   = dst;
+out.oend = dst + dst_cap;
+
+for( u32 first = 0; first < sample_cnt; first += COMPRESS_TERRAIN_BLOCK_CNT )
+    {
+    u32 block_cnt = sample_cnt - first;
+    if( block_cnt > COMPRESS_TERRAIN_BLOCK_CNT )
+        {
+        block_cnt = COMPRESS_TERRAIN_BLOCK_CNT;
+        }
+
+    u16 values[ COMPRESS_TERRAIN_BLOCK_CNT ];
+    for( u32 i = 0; i < block_cnt; i++ )
+        {
+        u32 residual = compress_terrain_residual( src, width, first + i );
+        values[ i ] = (u16)( ( residual << 1 ) ^ ( 0 - ( residual >> 15 ) ) );
+        }
+
+    /* pick the Rice parameter which codes this block the smallest */
+    u32 best_k = 0;
+    u32 best_sz = 0xffffffff;
+    for( u32 k = 0; k < ( 1u << COMPRESS_TERRAIN_K_BITS ); k++ )
+        {
+        u32 block_sz = 0;
+        for( u32 i = 0; i < block_cnt; i++ )
+            {
+            u32 quotient = values[ i ] >> k;
+            block_sz += quotient < COMPRESS_TERRAIN_ESCAPE ? quotient + 1 + k : COMPRESS_TERRAIN_ESCAPE + 16;
+            }
+
+        if( block_sz < best_sz )
+            {
+            best_sz = block_sz;
+            best_k  = k;
+            }
+        }
+
+    if( !compress_terrain_put( best_k, COMPRESS_TERRAIN_K_BITS, &out ) )
+        {
+        return( 0 );
+        }
+
+    for( u32 i = 0; i < block_cnt; i++ )
+        {
+        u32 quotient = values[ i ] >> best_k;
+        b8 fits = FALSE;
+        if( quotient < COMPRESS_TERRAIN_ESCAPE )
+            {
+            fits = compress_terrain_put( ( 1u << quotient ) - 1, quotient + 1, &out )
+                && compress_terrain_put( values[ i ] & ( ( 1u << best_k ) - 1 ), best_k, &out );
+            }
+        else
+            {
+            fits = compress_terrain_put( ( 1u << COMPRESS_TERRAIN_ESCAPE ) - 1, COMPRESS_TERRAIN_ESCAPE, &out )
+                && compress_terrain_put( values[ i ], 16, &out );
+            }
+
+        if( !fits )
+            {
+            return( 0 );
+            }
+        }
+    }
+
+/* store the partial last bytes */
+while( out.bits )
+    {
+    if( out.op >= out.oend )
+        {
+        return( 0 );
+        }
+
+    *out.op++ = (byte)out.acc;
+    out.acc >>= 8;
+    out.bits = out.bits > 8 ? out.bits - 8 : 0;
+    }
+
+return( (u32)( out.op - dst ) );
+
+} /* compress_terrain() */
+
+
+/*******************************************************************
+*
+*   decompress_terrain()
+*
+*   DESCRIPTION:
+*       Decompress a width by height grid of heights into dst.  Fails
+*       on any malformed input rather than reading out of bounds.
+*
+*******************************************************************/
+
+static inline b8 decompress_terrain( const byte *src, const u32 src_sz, const u32 width, const u32 height, u16 *dst )
+{
+const u32 sample_cnt = width * height;
+const byte *ip   = src;
+const byte *iend = src + src_sz;
+u64 acc  = 0;
+u32 bits = 0;
+
+/* decode the residuals in place first, then undo the prediction row by row */
+for( u32 first = 0; first < sample_cnt; first += COMPRESS_TERRAIN_BLOCK_CNT )
+    {
+    u32 block_end = sample_cnt - first > COMPRESS_TERRAIN_BLOCK_CNT ? first + COMPRESS_TERRAIN_BLOCK_CNT : sample_cnt;
+    u32 k = 0;
+    for( u32 i = first; i < block_end; i++ )
+        {
+        /* top up to at least 56 buffered bits while the input lasts */
+        if( iend - ip >= 8 )
+            {
+            u64 word;
+            memcpy( &word, ip, sizeof( word ) );
+            acc  |= word << bits;
+            ip   += ( 63 - bits ) >> 3;
+            bits |= 56;
+            }
+        else
+            {
+            while( bits <= 56
+                && ip < iend )
+                {
+                acc |= (u64)*ip++ << bits;
+                bits += 8;
+                }
+            }
+
+        if( i == first )
+            {
+            if( bits < COMPRESS_TERRAIN_K_BITS )
+                {
+                return( FALSE );
+                }
+
+            k = (u32)acc & ( ( 1u << COMPRESS_TERRAIN_K_BITS ) - 1 );
+            acc >>= COMPRESS_TERRAIN_K_BITS;
+            bits -= COMPRESS_TERRAIN_K_BITS;
+            }
+
+        /* bits past the buffered ones may be real stream bits, but only
+           a count below the escape is trusted and the bounds checks below
+           catch a short buffer; the top bit keeps a run of 64 ones defined */
+        u32 quotient = compress_terrain_ctz( ~acc | ( 1ull << 63 ) );
+        u32 value;
+        if( quotient >= COMPRESS_TERRAIN_ESCAPE )
+            {
+            if( bits < COMPRESS_TERRAIN_ESCAPE + 16 )
+                {
+                return( FALSE );
+                }
+
+            value = (u32)( acc >> COMPRESS_TERRAIN_ESCAPE ) & 0xffff;
+            acc >>= COMPRESS_TERRAIN_ESCAPE + 16;
+            bits -= COMPRESS_TERRAIN_ESCAPE + 16;
+            }
+        else
+            {
+            if( bits < quotient + 1 + k )
+                {
+                return( FALSE );
+                }
+
+            acc >>= quotient + 1;
+            value = ( quotient << k ) | ( (u32)acc & ( ( 1u << k ) - 1 ) );
+            acc >>= k;
+            bits -= quotient + 1 + k;
+            }
+
+        dst[ i ] = (u16)( ( value >> 1 ) ^ ( 0 - ( value & 1 ) ) );
+        }
+    }
+
+for( u32 z = 0; z < height; z++ )
+    {
+    compress_terrain_unpredict_row( z ? &dst[ ( z - 1 ) * width ] : NULL, width, &dst[ z * width ] );
+    }
+
+return( TRUE );
+
+} /* decompress_terrain() */
+
+
+/*******************************************************************
+*
+*   compress_terrain_ctz()
+*
+*   DESCRIPTION:
+*       Count the trailing zero bits of a non-zero value.
+*
+*******************************************************************/
+
+static inline u32 compress_terrain_ctz( const u64 value )
+{
+#if defined( _MSC_VER )
+unsigned long bit;
+_BitScanForward64( &bit, value );
+return( (u32)bit );
+#else
+return( (u32)__builtin_ctzll( value ) );
+#endif
+
+} /* compress_terrain_ctz() */
+
+
+/*******************************************************************
+*
+*   compress_terrain_put()
+*
+*   DESCRIPTION:
+*       Append up to 16 bits to the stream, storing whole words as
+*       they fill.  Returns false if the destination is full.
+*
+*******************************************************************/
+
+static inline b8 compress_terrain_put( const u32 value, const u32 cnt, CompressTerrainBits *bits )
+{
+bits->acc  |= (u64)value << bits->bits;
+bits->bits += cnt;
+if( bits->bits < 32 )
+    {
+    return( TRUE );
+    }
+
+if( bits->oend - bits->op < 4 )
+    {
+    return( FALSE );
+    }
+
+for( u32 i = 0; i < 4; i++ )
+    {
+    *bits->op++ = (byte)( bits->acc >> ( 8 * i ) );
+    }
+
+bits->acc >>= 32;
+bits->bits -= 32;
+
+return( TRUE );
+
+} /* compress_terrain_put() */
+
+
+/*******************************************************************
+*
+*   compress_terrain_residual()
+*
+*   DESCRIPTION:
+*       Get the prediction residual of the sample at the index.
+*
+*******************************************************************/
+
+static inline u16 compress_terrain_residual( const u16 *src, const u32 width, const u32 index )
+{
+u32 x = index % width;
+u32 z = index / width;
+u32 left    = x      ? src[ index - 1 ] : 0;
+u32 up      = z      ? src[ index - width ] : 0;
+u32 up_left = x && z ? src[ index - width - 1 ] : 0;
+
+return( (u16)( src[ index ] - left - up + up_left ) );
+
+} /* compress_terrain_residual() */
+
+
+/*******************************************************************
+*
+*   compress_terrain_unpredict_row()
+*
+*   DESCRIPTION:
+*       Turn a row of residuals back into heights, given the row
+*       above, or NULL for the first row.
+*
+*******************************************************************/
+
+static inline void compress_terrain_unpredict_row( const u16 *up, const u32 width, u16 *row )
+{
+u16 left = (u16)( row[ 0 ] + ( up ? up[ 0 ] : 0 ) );
+row[ 0 ] = left;
+
+u32 x = 1;
+#if defined( COMPRESS_USE_SSE2 )
+/* eight lane running sum by shifted adds, carrying in the last height */
+for( ; x + 8 <= width; x += 8 )
+    {
+    __m128i sum = _mm_loadu_si128( (const __m128i*)&row[ x ] );
+    if( up )
+        {
+        sum = _mm_add_epi16( sum, _mm_sub_epi16( _mm_loadu_si128( (const __m128i*)&up[ x ] ), _mm_loadu_si128( (const __m128i*)&up[ x - 1 ] ) ) );
+        }
+
+    sum = _mm_add_epi16( sum, _mm_slli_si128( sum, 2 ) );
+    sum = _mm_add_epi16( sum, _mm_slli_si128( sum, 4 ) );
+    sum = _mm_add_epi16( sum, _mm_slli_si128( sum, 8 ) );
+    sum = _mm_add_epi16( sum, _mm_set1_epi16( (short)left ) );
+    _mm_storeu_si128( (__m128i*)&row[ x ], sum );
+    left = (u16)_mm_extract_epi16( sum, 7 );
+    }
+#endif
+
+for( ; x < width; x++ )
+    {
+    left = (u16)( left + row[ x ] + ( up ? up[ x ] - up[ x - 1 ] : 0 ) );
+    row[ x ] = left;
+    }
+
+} /* compress_terrain_unpredict_row() */
@@ -1,6 +1,19 @@
 #pragma once
 #include <stdio.h>
 
+#if defined( _WIN32 )
+#if !defined( NOMINMAX )
+#define NOMINMAX
+#endif
+#include <io.h>
+#include <windows.h>
+#else
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "Global.hpp"
 
 static inline b8 file_read_buffer( fhnd hnd, const u64 buffer_sz, const u64 read_sz, void *buffer );
@@ -20,6 +33,31 @@ return( result == 0 );
 }   /* file_close() */
 
 
+/*******************************************************************
+*
+*   file_close_read_at()
+*
+*   DESCRIPTION:
+*       Release a handle from file_open_read_at().
+*
+*******************************************************************/
+
+static inline b8 file_close_read_at( void *read_hnd )
+{
+#if defined( _WIN32 )
+if( read_hnd )
+    {
+    return( CloseHandle( (HANDLE)read_hnd ) != 0 );
+    }
+#else
+(void)read_hnd;
+#endif
+
+return( TRUE );
+
+}   /* file_close_read_at() */
+
+
 /*******************************************************************
 *
 *   file_delete()
@@ -41,7 +79,11 @@ return( !remove( filename_w_path ) );
 
 static inline u64 file_get_pos( fhnd hnd )
 {
-long result = ftell( (FILE*)hnd );
+#if defined( _WIN32 )
+s64 result = _ftelli64( (FILE*)hnd );
+#else
+s64 result = (s64)ftello( (FILE*)hnd );
+#endif
 if( result < 0 )
     {
     return( 0 );
@@ -52,6 +94,72 @@ return( (u64)result );
 }   /* file_get_pos() */
 
 
+/*******************************************************************
+*
+*   file_map()
+*
+*   DESCRIPTION:
+*       Map the whole of an open file into memory as read-only.
+*
+*******************************************************************/
+
+static inline b8 file_map( fhnd hnd, const void **view, u64 *view_sz, void **map_hnd )
+{
+*view    = NULL;
+*view_sz = 0;
+*map_hnd = NULL;
+
+#if defined( _WIN32 )
+HANDLE file = (HANDLE)_get_osfhandle( _fileno( (FILE*)hnd ) );
+LARGE_INTEGER file_sz = {};
+if( file == INVALID_HANDLE_VALUE
+ || !GetFileSizeEx( file, &file_sz )
+ || file_sz.QuadPart == 0 )
+    {
+    return( FALSE );
+    }
+
+HANDLE mapping = CreateFileMappingA( file, NULL, PAGE_READONLY, 0, 0, NULL );
+if( !mapping )
+    {
+    return( FALSE );
+    }
+
+void *result = MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+if( !result )
+    {
+    CloseHandle( mapping );
+    return( FALSE );
+    }
+
+*map_hnd = (void*)mapping;
+*view_sz = (u64)file_sz.QuadPart;
+*view    = result;
+#else
+int fd = fileno( (FILE*)hnd );
+struct stat file_stat = {};
+if( fd < 0
+ || fstat( fd, &file_stat ) != 0
+ || file_stat.st_size <= 0 )
+    {
+    return( FALSE );
+    }
+
+void *result = mmap( NULL, (size_t)file_stat.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+if( result == MAP_FAILED )
+    {
+    return( FALSE );
+    }
+
+*view_sz = (u64)file_stat.st_size;
+*view    = result;
+#endif
+
+return( TRUE );
+
+}   /* file_map() */
+
+
 /*******************************************************************
 *
 *   file_open()
@@ -67,6 +175,38 @@ return( *hnd != 0 );
 }   /* file_open() */
 
 
+/*******************************************************************
+*
+*   file_open_read_at()
+*
+*   DESCRIPTION:
+*       Open the platform handle file_read_at() reads through.  On
+*       Windows this is a second, overlapped handle to the file, so
+*       reads never share a file pointer.  Elsewhere pread() works
+*       on the stream's own descriptor, and the handle is NULL.
+*
+*******************************************************************/
+
+static inline b8 file_open_read_at( const char *filename_w_path, void **read_hnd )
+{
+*read_hnd = NULL;
+#if defined( _WIN32 )
+HANDLE file = CreateFileA( filename_w_path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL );
+if( file == INVALID_HANDLE_VALUE )
+    {
+    return( FALSE );
+    }
+
+*read_hnd = (void*)file;
+#else
+(void)filename_w_path;
+#endif
+
+return( TRUE );
+
+}   /* file_open_read_at() */
+
+
 /*******************************************************************
 *
 *   file_read()
@@ -80,6 +220,91 @@ return( file_read_buffer( hnd, read_sz, read_sz, out ) );
 }   /* file_read() */
 
 
+/*******************************************************************
+*
+*   file_read_at()
+*
+*   DESCRIPTION:
+*       Read from an absolute file location without using or moving
+*       the stream position, so threads may share one handle.  The
+*       read handle comes from file_open_read_at(); on Windows each
+*       read is issued on it as its own overlapped request and
+*       waited on with a private event.
+*
+*******************************************************************/
+
+static inline b8 file_read_at( fhnd hnd, void *read_hnd, const u64 location, const u64 read_sz, void *out )
+{
+u64 done_sz = 0;
+#if defined( _WIN32 )
+(void)hnd;
+HANDLE file = (HANDLE)read_hnd;
+HANDLE event = CreateEventA( NULL, TRUE, FALSE, NULL );
+if( !file
+ || !event )
+    {
+    if( event )
+        {
+        CloseHandle( event );
+        }
+
+    return( FALSE );
+    }
+
+b8 ret = TRUE;
+while( ret
+    && done_sz < read_sz )
+    {
+    u64 at = location + done_sz;
+    DWORD chunk_sz = (DWORD)( read_sz - done_sz < 0x40000000 ? read_sz - done_sz : 0x40000000 );
+
+    OVERLAPPED overlapped = {};
+    overlapped.Offset     = (DWORD)( at & 0xffffffff );
+    overlapped.OffsetHigh = (DWORD)( at >> 32 );
+    overlapped.hEvent     = event;
+
+    DWORD got_sz = 0;
+    if( ( !ReadFile( file, (byte*)out + done_sz, chunk_sz, NULL, &overlapped )
+       && GetLastError() != ERROR_IO_PENDING )
+     || !GetOverlappedResult( file, &overlapped, &got_sz, TRUE )
+     || got_sz == 0 )
+        {
+        ret = FALSE;
+        }
+
+    done_sz += got_sz;
+    }
+
+CloseHandle( event );
+if( !ret )
+    {
+    return( FALSE );
+    }
+#else
+(void)read_hnd;
+int fd = fileno( (FILE*)hnd );
+while( done_sz < read_sz )
+    {
+    ssize_t got_sz = pread( fd, (byte*)out + done_sz, (size_t)( read_sz - done_sz ), (off_t)( location + done_sz ) );
+    if( got_sz < 0
+     && errno == EINTR )
+        {
+        continue;
+        }
+    else if( got_sz <= 0 )
+        {
+        return( FALSE );
+        }
+
+    done_sz += (u64)got_sz;
+    }
+#endif
+
+return( TRUE );
+
+}   /* file_read_at() */
+
+
 /*******************************************************************
 *
 *   file_read_array()
@@ -153,7 +378,12 @@ rewind( (FILE*)hnd );
 
 static inline b8 file_seek( fhnd hnd, const u64 location )
 {
-int result = fseek( (FILE*)hnd, (long)location, SEEK_SET );
+/* long is 32 bits on Windows, so use the 64-bit variants */
+#if defined( _WIN32 )
+int result = _fseeki64( (FILE*)hnd, (__int64)location, SEEK_SET );
+#else
+int result = fseeko( (FILE*)hnd, (off_t)location, SEEK_SET );
+#endif
 return( result == 0 );
 
 }   /* file_seek() */
@@ -167,12 +397,44 @@ return( result == 0 );
 
 static inline b8 file_seek_rel( fhnd hnd, const s64 offset )
 {
-int result = fseek( (FILE*)hnd, (long)offset, SEEK_CUR );
+#if defined( _WIN32 )
+int result = _fseeki64( (FILE*)hnd, (__int64)offset, SEEK_CUR );
+#else
+int result = fseeko( (FILE*)hnd, (off_t)offset, SEEK_CUR );
+#endif
 return( result == 0 );
 
 }   /* file_seek_rel() */
 
 
+/*******************************************************************
+*
+*   file_unmap()
+*
+*   DESCRIPTION:
+*       Release a view previously created by file_map().
+*
+*******************************************************************/
+
+static inline b8 file_unmap( const void *view, const u64 view_sz, void *map_hnd )
+{
+if( !view )
+    {
+    return( TRUE );
+    }
+
+#if defined( _WIN32 )
+b8 ret = ( UnmapViewOfFile( view ) != 0 );
+ret = ( CloseHandle( (HANDLE)map_hnd ) != 0 ) && ret;
+return( ret );
+#else
+(void)map_hnd;
+return( munmap( (void*)view, (size_t)view_sz ) == 0 );
+#endif
+
+}   /* file_unmap() */
+
+
 /*******************************************************************
 *
 *   file_write()
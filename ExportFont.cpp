@@ -113,7 +113,7 @@ static bool        WriteToAssetFile( const AssetFileAssetId id, const std::strin
 bool ExportFont_Export( const AssetFileAssetId id, const char *asset_id_str, const char *filename, const int point_size, const char *glyphs, WriteStats &stats, std::vector<std::string> &out_strs, AssetFileWriter *output )
 {
 stats = {};
-size_t write_start_size = AssetFile_GetWriteSize( output );
+size_t write_start_size = AssetFile_GetLogicalWriteSize( output );
 
 /* Read font from disk */
 FontFile font_data( filename );
@@ -256,7 +256,7 @@ if( !WriteToAssetFile( id, strip_filename( asset_id_str ), (uint8_t*)final_textu
     return( false );
     }
 
-size_t write_total_size = AssetFile_GetWriteSize( output ) - write_start_size;
+size_t write_total_size = AssetFile_GetLogicalWriteSize( output ) - write_start_size;
 stats.written_sz += write_total_size;
 std::ostringstream os;
 os << "glyphs: " << (int)char_data.size()
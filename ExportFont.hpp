@@ -2,4 +2,7 @@
 #include "AssetFile.hpp"
 #include "ResourceUtilities.hpp"
 
+#define EXPORT_FONT_VERSION         ( 1 )
+                                    /* bump when the output changes */
+
 bool ExportFont_Export( const AssetFileAssetId id, const char *asset_id_str, const char *filename, const int point_size, const char *glyphs, WriteStats &stats, std::vector<std::string> &out_strs, AssetFileWriter *output );
@@ -0,0 +1,1407 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "AssetFile.hpp"
+#include "ExportMesh.hpp"
+
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define EXPORT_MESH_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define ANALYZE_CACHE_SIZE          ( 16 )
+                                    /* FIFO entries, post-transform */
+#define FORSYTH_CACHE_SIZE          ( 32 )
+                                    /* LRU entries when ordering   */
+#define FORSYTH_CACHE_DECAY_POWER   ( 1.5f )
+#define FORSYTH_LAST_TRIANGLE_SCORE ( 0.75f )
+#define FORSYTH_VALENCE_BOOST_POWER ( 0.5f )
+#define FORSYTH_VALENCE_BOOST_SCALE ( 2.0f )
+#define INVALID_INDEX               ( 0xffffffff )
+#define MESHLET_CONE_MIN_DOT        ( 0.1f )
+                                    /* wider cones are not worth it */
+#define MESHLET_CONE_NEVER          ( 2.0f )
+                                    /* cutoff no view dot reaches   */
+#define SIMPLIFY_MIN_NORMAL_DOT     ( 0.5f )
+                                    /* cos of most a face may turn  */
+
+typedef struct
+    {
+    uint32_t            start;      /* first triangle               */
+    uint32_t            end;        /* one past the last triangle   */
+    float               centroid[ 3 ];
+                                    /* area weighted sum            */
+    float               normal[ 3 ];/* area weighted sum            */
+    float               area;
+    float               sort_key;   /* larger faces further outward */
+    } MeshCluster;
+
+typedef struct
+    {
+    float               normal[ 3 ];/* unit length                  */
+    uint8_t             corner;     /* meshlet vertex on the plane  */
+    } MeshletFace;
+
+typedef struct
+    {
+    double              a[ 10 ];    /* upper triangle of the 4x4    */
+                                    /*  sum of area * plane plane^T */
+    double              area;       /* total weight                 */
+    } MeshQuadric;
+
+typedef struct
+    {
+    AssetFileModelIndex from;       /* vertex removed               */
+    AssetFileModelIndex to;         /* vertex kept                  */
+    double              cost;       /* squared distance moved       */
+    } MeshCollapse;
+
+static void     AddQuadric( const MeshQuadric *add, MeshQuadric *sum );
+static void     BoundMeshlet( const AssetFileModelVertex *vertices, const uint32_t *meshlet_vertices, const uint8_t *meshlet_triangles, AssetFileModelMeshlet *meshlet );
+static float    Distance( const float *a, const float *b );
+static double   EvaluateQuadric( const MeshQuadric *quadric, const float *position );
+static float    GetVertexScore( const int cache_position, const uint32_t remaining );
+static uint32_t SimulateCache( const AssetFileModelIndex *triangle, uint32_t *timestamps, uint32_t *time );
+
+
+/*******************************************************************
+*
+*   ExportMesh_AnalyzeVertexCache()
+*
+*   DESCRIPTION:
+*       Count the vertex shader invocations a FIFO post-transform
+*       cache would make drawing the triangle list.  ACMR is the
+*       transformed count per triangle (0.5 at best, 3.0 at worst) and
+*       ATVR the transformed count per vertex (1.0 at best).
+*
+*******************************************************************/
+
+void ExportMesh_AnalyzeVertexCache( const AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count, ExportMeshCacheStats *stats )
+{
+*stats = {};
+stats->triangle_cnt = index_count / 3;
+stats->vertex_cnt   = vertex_count;
+
+std::vector<uint32_t> timestamps( vertex_count, 0 );
+uint32_t time = ANALYZE_CACHE_SIZE + 1;
+for( uint32_t i = 0; i < stats->triangle_cnt; i++ )
+    {
+    stats->transformed_cnt += SimulateCache( &indices[ 3 * i ], timestamps.data(), &time );
+    }
+
+} /* ExportMesh_AnalyzeVertexCache() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_BuildMeshlets()
+*
+*   DESCRIPTION:
+*       Partition the triangle list into meshlets within the format's
+*       vertex and triangle limits.  Each meshlet grows by the
+*       triangle next to it that adds the fewest vertices; when none
+*       is left it carries on in index order, which the cache
+*       optimization keeps spatially coherent.
+*
+*******************************************************************/
+
+void ExportMesh_BuildMeshlets( const AssetFileModelIndex *indices, const uint32_t index_count, const AssetFileModelVertex *vertices, const uint32_t vertex_count, std::vector<AssetFileModelMeshlet> *meshlets, std::vector<uint32_t> *meshlet_vertices, std::vector<uint8_t> *meshlet_triangles )
+{
+meshlets->clear();
+meshlet_vertices->clear();
+meshlet_triangles->clear();
+
+uint32_t triangle_count = index_count / 3;
+if( triangle_count == 0 )
+    {
+    return;
+    }
+
+/* triangles using each vertex */
+std::vector<uint32_t> adjacency_offsets( vertex_count + 1, 0 );
+for( uint32_t i = 0; i < 3 * triangle_count; i++ )
+    {
+    adjacency_offsets[ indices[ i ] + 1 ]++;
+    }
+
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    adjacency_offsets[ i + 1 ] += adjacency_offsets[ i ];
+    }
+
+std::vector<uint32_t> adjacency( 3 * triangle_count );
+std::vector<uint32_t> fill( adjacency_offsets.begin(), adjacency_offsets.end() - 1 );
+for( uint32_t i = 0; i < 3 * triangle_count; i++ )
+    {
+    adjacency[ fill[ indices[ i ] ]++ ] = i / 3;
+    }
+
+/* local index of each vertex in the open meshlet */
+std::vector<uint32_t> local( vertex_count, INVALID_INDEX );
+auto count_new = [&]( uint32_t triangle )
+    {
+    const AssetFileModelIndex *corners = &indices[ 3 * triangle ];
+    return( (uint32_t)( local[ corners[ 0 ] ] == INVALID_INDEX )
+          + (uint32_t)( local[ corners[ 1 ] ] == INVALID_INDEX && corners[ 1 ] != corners[ 0 ] )
+          + (uint32_t)( local[ corners[ 2 ] ] == INVALID_INDEX && corners[ 2 ] != corners[ 0 ] && corners[ 2 ] != corners[ 1 ] ) );
+    };
+
+AssetFileModelMeshlet meshlet = {};
+auto close_meshlet = [&]()
+    {
+    BoundMeshlet( vertices, &( *meshlet_vertices )[ meshlet.vertex_offset ], &( *meshlet_triangles )[ 3 * meshlet.triangle_offset ], &meshlet );
+    for( uint32_t i = 0; i < meshlet.vertex_count; i++ )
+        {
+        local[ ( *meshlet_vertices )[ meshlet.vertex_offset + i ] ] = INVALID_INDEX;
+        }
+
+    meshlets->push_back( meshlet );
+    meshlet = {};
+    meshlet.vertex_offset   = (uint32_t)meshlet_vertices->size();
+    meshlet.triangle_offset = (uint32_t)( meshlet_triangles->size() / 3 );
+    };
+
+std::vector<bool> is_emitted( triangle_count, false );
+uint32_t scan = 0;
+for( uint32_t emitted = 0; emitted < triangle_count; emitted++ )
+    {
+    /* the neighbour adding the fewest vertices */
+    uint32_t best = INVALID_INDEX;
+    uint32_t best_new = 4;
+    for( uint32_t i = 0; i < meshlet.vertex_count && best_new > 0; i++ )
+        {
+        uint32_t vertex = ( *meshlet_vertices )[ meshlet.vertex_offset + i ];
+        for( uint32_t j = adjacency_offsets[ vertex ]; j < adjacency_offsets[ vertex + 1 ]; j++ )
+            {
+            uint32_t triangle = adjacency[ j ];
+            uint32_t added = is_emitted[ triangle ] ? 4 : count_new( triangle );
+            if( added < best_new )
+                {
+                best = triangle;
+                best_new = added;
+                }
+            }
+        }
+
+    if( best == INVALID_INDEX )
+        {
+        while( is_emitted[ scan ] )
+            {
+            scan++;
+            }
+
+        best = scan;
+        best_new = count_new( best );
+        }
+
+    if( meshlet.vertex_count + best_new > ASSET_FILE_MODEL_MESHLET_MAX_VERTICES
+     || meshlet.triangle_count == ASSET_FILE_MODEL_MESHLET_MAX_TRIANGLES )
+        {
+        close_meshlet();
+        }
+
+    for( int k = 0; k < 3; k++ )
+        {
+        AssetFileModelIndex vertex = indices[ 3 * best + k ];
+        if( local[ vertex ] == INVALID_INDEX )
+            {
+            local[ vertex ] = meshlet.vertex_count++;
+            meshlet_vertices->push_back( vertex );
+            }
+
+        meshlet_triangles->push_back( (uint8_t)local[ vertex ] );
+        }
+
+    meshlet.triangle_count++;
+    is_emitted[ best ] = true;
+    }
+
+close_meshlet();
+
+} /* ExportMesh_BuildMeshlets() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_ComputeBounds()
+*
+*   DESCRIPTION:
+*       Compute the box and a bounding sphere of the vertex
+*       positions.  The sphere is centered by Ritter's method or on
+*       the box, whichever turns out smaller, and its radius is the
+*       exact distance to the farthest vertex.
+*
+*******************************************************************/
+
+void ExportMesh_ComputeBounds( const AssetFileModelVertex *vertices, const uint32_t vertex_count, AssetFileModelBounds *bounds )
+{
+*bounds = {};
+if( vertex_count == 0 )
+    {
+    bounds->radius = -1.0f;
+    return;
+    }
+
+/* box, also noting the vertices extreme along each axis */
+uint32_t extreme_min[ 3 ] = {};
+uint32_t extreme_max[ 3 ] = {};
+#if defined( EXPORT_MESH_USE_SSE2 )
+/* x, y, z and u0 load together, the last lane is ignored */
+__m128 min4 = _mm_loadu_ps( &vertices[ 0 ].x );
+__m128 max4 = min4;
+for( uint32_t i = 1; i < vertex_count; i++ )
+    {
+    __m128 position = _mm_loadu_ps( &vertices[ i ].x );
+    min4 = _mm_min_ps( min4, position );
+    max4 = _mm_max_ps( max4, position );
+    }
+
+float min_out[ 4 ];
+float max_out[ 4 ];
+_mm_storeu_ps( min_out, min4 );
+_mm_storeu_ps( max_out, max4 );
+memcpy( bounds->min, min_out, sizeof( bounds->min ) );
+memcpy( bounds->max, max_out, sizeof( bounds->max ) );
+#else
+bounds->min[ 0 ] = bounds->max[ 0 ] = vertices[ 0 ].x;
+bounds->min[ 1 ] = bounds->max[ 1 ] = vertices[ 0 ].y;
+bounds->min[ 2 ] = bounds->max[ 2 ] = vertices[ 0 ].z;
+for( uint32_t i = 1; i < vertex_count; i++ )
+    {
+    bounds->min[ 0 ] = std::min( bounds->min[ 0 ], vertices[ i ].x );
+    bounds->min[ 1 ] = std::min( bounds->min[ 1 ], vertices[ i ].y );
+    bounds->min[ 2 ] = std::min( bounds->min[ 2 ], vertices[ i ].z );
+    bounds->max[ 0 ] = std::max( bounds->max[ 0 ], vertices[ i ].x );
+    bounds->max[ 1 ] = std::max( bounds->max[ 1 ], vertices[ i ].y );
+    bounds->max[ 2 ] = std::max( bounds->max[ 2 ], vertices[ i ].z );
+    }
+#endif
+
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    const float *position = &vertices[ i ].x;
+    for( int k = 0; k < 3; k++ )
+        {
+        if( position[ k ] == bounds->min[ k ] )
+            {
+            extreme_min[ k ] = i;
+            }
+
+        if( position[ k ] == bounds->max[ k ] )
+            {
+            extreme_max[ k ] = i;
+            }
+        }
+    }
+
+/* Ritter - start from the widest pair of extremes, then grow to take in each outlier */
+int widest = 0;
+float widest_distance = -1.0f;
+for( int k = 0; k < 3; k++ )
+    {
+    float distance = Distance( &vertices[ extreme_min[ k ] ].x, &vertices[ extreme_max[ k ] ].x );
+    if( distance > widest_distance )
+        {
+        widest = k;
+        widest_distance = distance;
+        }
+    }
+
+float ritter_center[ 3 ];
+const float *a = &vertices[ extreme_min[ widest ] ].x;
+const float *b = &vertices[ extreme_max[ widest ] ].x;
+for( int k = 0; k < 3; k++ )
+    {
+    ritter_center[ k ] = 0.5f * ( a[ k ] + b[ k ] );
+    }
+
+float ritter_radius = 0.5f * widest_distance;
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    const float *position = &vertices[ i ].x;
+    float distance = Distance( ritter_center, position );
+    if( distance > ritter_radius )
+        {
+        float grown = 0.5f * ( ritter_radius + distance );
+        for( int k = 0; k < 3; k++ )
+            {
+            ritter_center[ k ] += ( grown - ritter_radius ) / distance * ( position[ k ] - ritter_center[ k ] );
+            }
+
+        ritter_radius = grown;
+        }
+    }
+
+/* exact radius about either center, so rounding never leaves a vertex outside */
+float box_center[ 3 ];
+for( int k = 0; k < 3; k++ )
+    {
+    box_center[ k ] = 0.5f * ( bounds->min[ k ] + bounds->max[ k ] );
+    }
+
+ritter_radius = 0.0f;
+float box_radius = 0.0f;
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    ritter_radius = std::max( ritter_radius, Distance( ritter_center, &vertices[ i ].x ) );
+    box_radius    = std::max( box_radius, Distance( box_center, &vertices[ i ].x ) );
+    }
+
+if( ritter_radius < box_radius )
+    {
+    memcpy( bounds->center, ritter_center, sizeof( bounds->center ) );
+    bounds->radius = ritter_radius;
+    }
+else
+    {
+    memcpy( bounds->center, box_center, sizeof( bounds->center ) );
+    bounds->radius = box_radius;
+    }
+
+} /* ExportMesh_ComputeBounds() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_MergeBounds()
+*
+*   DESCRIPTION:
+*       Bound both inputs, either of which may be empty.  The output
+*       may be one of the inputs.
+*
+*******************************************************************/
+
+void ExportMesh_MergeBounds( const AssetFileModelBounds *a, const AssetFileModelBounds *b, AssetFileModelBounds *out )
+{
+if( b->radius < 0.0f )
+    {
+    *out = *a;
+    return;
+    }
+else if( a->radius < 0.0f )
+    {
+    *out = *b;
+    return;
+    }
+
+AssetFileModelBounds merged = {};
+for( int k = 0; k < 3; k++ )
+    {
+    merged.min[ k ] = std::min( a->min[ k ], b->min[ k ] );
+    merged.max[ k ] = std::max( a->max[ k ], b->max[ k ] );
+    }
+
+/* smallest sphere around both spheres */
+float distance = Distance( a->center, b->center );
+if( distance + b->radius <= a->radius )
+    {
+    memcpy( merged.center, a->center, sizeof( merged.center ) );
+    merged.radius = a->radius;
+    }
+else if( distance + a->radius <= b->radius )
+    {
+    memcpy( merged.center, b->center, sizeof( merged.center ) );
+    merged.radius = b->radius;
+    }
+else
+    {
+    merged.radius = 0.5f * ( distance + a->radius + b->radius );
+    for( int k = 0; k < 3; k++ )
+        {
+        merged.center[ k ] = a->center[ k ] + ( merged.radius - a->radius ) / distance * ( b->center[ k ] - a->center[ k ] );
+        }
+    }
+
+*out = merged;
+
+} /* ExportMesh_MergeBounds() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_OptimizeOverdraw()
+*
+*   DESCRIPTION:
+*       Reorder a cache optimized triangle list so that clusters
+*       facing out from the mesh center draw first and occlude the
+*       rest.  Clusters are cut where the cache runs cold, then again
+*       wherever a run has recovered to within threshold of its
+*       cluster's ACMR, so sorting them costs little cache efficiency.
+*
+*******************************************************************/
+
+void ExportMesh_OptimizeOverdraw( AssetFileModelIndex *indices, const uint32_t index_count, const AssetFileModelVertex *vertices, const uint32_t vertex_count, const float threshold )
+{
+uint32_t triangle_count = index_count / 3;
+if( triangle_count < 2 )
+    {
+    return;
+    }
+
+std::vector<uint32_t> timestamps( vertex_count, 0 );
+uint32_t time = ANALYZE_CACHE_SIZE + 1;
+
+/* hard boundaries, where every vertex of a triangle missed */
+std::vector<uint32_t> hard_starts;
+for( uint32_t i = 0; i < triangle_count; i++ )
+    {
+    if( SimulateCache( &indices[ 3 * i ], timestamps.data(), &time ) == 3
+     || i == 0 )
+        {
+        hard_starts.push_back( i );
+        }
+    }
+
+hard_starts.push_back( triangle_count );
+
+/* soft boundaries inside each, starting each run on a cold cache */
+std::vector<MeshCluster> clusters;
+for( size_t i = 0; i + 1 < hard_starts.size(); i++ )
+    {
+    uint32_t start = hard_starts[ i ];
+    uint32_t end   = hard_starts[ i + 1 ];
+
+    time += ANALYZE_CACHE_SIZE + 1;
+    uint32_t misses = 0;
+    for( uint32_t j = start; j < end; j++ )
+        {
+        misses += SimulateCache( &indices[ 3 * j ], timestamps.data(), &time );
+        }
+
+    float cluster_threshold = threshold * (float)misses / (float)( end - start );
+
+    time += ANALYZE_CACHE_SIZE + 1;
+    uint32_t run_start = start;
+    uint32_t run_misses = 0;
+    for( uint32_t j = start; j < end; j++ )
+        {
+        run_misses += SimulateCache( &indices[ 3 * j ], timestamps.data(), &time );
+        if( j + 1 == end
+         || (float)run_misses <= cluster_threshold * (float)( j + 1 - run_start ) )
+            {
+            MeshCluster cluster = {};
+            cluster.start = run_start;
+            cluster.end   = j + 1;
+            clusters.push_back( cluster );
+
+            run_start  = j + 1;
+            run_misses = 0;
+            time += ANALYZE_CACHE_SIZE + 1;
+            }
+        }
+    }
+
+/* area weighted centroid and normal of each cluster and the whole mesh */
+float mesh_centroid[ 3 ] = {};
+float mesh_area = 0.0f;
+for( MeshCluster &cluster : clusters )
+    {
+    for( uint32_t i = cluster.start; i < cluster.end; i++ )
+        {
+        const AssetFileModelVertex *a = &vertices[ indices[ 3 * i + 0 ] ];
+        const AssetFileModelVertex *b = &vertices[ indices[ 3 * i + 1 ] ];
+        const AssetFileModelVertex *c = &vertices[ indices[ 3 * i + 2 ] ];
+
+        float ab[ 3 ] = { b->x - a->x, b->y - a->y, b->z - a->z };
+        float ac[ 3 ] = { c->x - a->x, c->y - a->y, c->z - a->z };
+        float normal[ 3 ] =
+            {
+            ab[ 1 ] * ac[ 2 ] - ab[ 2 ] * ac[ 1 ],
+            ab[ 2 ] * ac[ 0 ] - ab[ 0 ] * ac[ 2 ],
+            ab[ 0 ] * ac[ 1 ] - ab[ 1 ] * ac[ 0 ]
+            };
+        float area = 0.5f * sqrtf( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+        float centroid[ 3 ] =
+            {
+            ( a->x + b->x + c->x ) / 3.0f,
+            ( a->y + b->y + c->y ) / 3.0f,
+            ( a->z + b->z + c->z ) / 3.0f
+            };
+
+        for( int k = 0; k < 3; k++ )
+            {
+            cluster.centroid[ k ] += centroid[ k ] * area;
+            cluster.normal[ k ]   += normal[ k ];
+            }
+
+        cluster.area += area;
+        }
+
+    for( int k = 0; k < 3; k++ )
+        {
+        mesh_centroid[ k ] += cluster.centroid[ k ];
+        }
+
+    mesh_area += cluster.area;
+    }
+
+if( mesh_area <= 0.0f )
+    {
+    return;
+    }
+
+for( int k = 0; k < 3; k++ )
+    {
+    mesh_centroid[ k ] /= mesh_area;
+    }
+
+/* the winding convention is unknown, so take the one giving the mesh positive volume */
+float volume = 0.0f;
+for( MeshCluster &cluster : clusters )
+    {
+    if( cluster.area <= 0.0f )
+        {
+        continue;
+        }
+
+    float outward = 0.0f;
+    float normal_length = 0.0f;
+    for( int k = 0; k < 3; k++ )
+        {
+        outward       += ( cluster.centroid[ k ] / cluster.area - mesh_centroid[ k ] ) * cluster.normal[ k ];
+        normal_length += cluster.normal[ k ] * cluster.normal[ k ];
+        }
+
+    volume += outward;
+    if( normal_length > 0.0f )
+        {
+        cluster.sort_key = outward / sqrtf( normal_length );
+        }
+    }
+
+if( volume < 0.0f )
+    {
+    for( MeshCluster &cluster : clusters )
+        {
+        cluster.sort_key = -cluster.sort_key;
+        }
+    }
+
+std::stable_sort( clusters.begin(), clusters.end(), []( const MeshCluster &a, const MeshCluster &b ) { return( a.sort_key > b.sort_key ); } );
+
+std::vector<AssetFileModelIndex> sorted;
+sorted.reserve( index_count );
+for( const MeshCluster &cluster : clusters )
+    {
+    sorted.insert( sorted.end(), &indices[ 3 * cluster.start ], &indices[ 3 * cluster.end ] );
+    }
+
+memcpy( indices, sorted.data(), sorted.size() * sizeof( *indices ) );
+
+} /* ExportMesh_OptimizeOverdraw() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_OptimizeVertexCache()
+*
+*   DESCRIPTION:
+*       Reorder the triangle list for post-transform cache locality
+*       using Tom Forsyth's linear-speed scoring.  Each step emits
+*       the best scoring triangle touching the simulated LRU cache,
+*       falling back to input order at a dead end.
+*
+*******************************************************************/
+
+void ExportMesh_OptimizeVertexCache( AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count )
+{
+uint32_t triangle_count = index_count / 3;
+if( triangle_count == 0 )
+    {
+    return;
+    }
+
+/* triangles using each vertex, retired as they are emitted */
+std::vector<uint32_t> adjacency_offsets( vertex_count + 1, 0 );
+for( uint32_t i = 0; i < 3 * triangle_count; i++ )
+    {
+    adjacency_offsets[ indices[ i ] + 1 ]++;
+    }
+
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    adjacency_offsets[ i + 1 ] += adjacency_offsets[ i ];
+    }
+
+std::vector<uint32_t> remaining( vertex_count );
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    remaining[ i ] = adjacency_offsets[ i + 1 ] - adjacency_offsets[ i ];
+    }
+
+std::vector<uint32_t> adjacency( 3 * triangle_count );
+std::vector<uint32_t> fill( adjacency_offsets.begin(), adjacency_offsets.end() - 1 );
+for( uint32_t i = 0; i < 3 * triangle_count; i++ )
+    {
+    adjacency[ fill[ indices[ i ] ]++ ] = i / 3;
+    }
+
+std::vector<float> vertex_scores( vertex_count );
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    vertex_scores[ i ] = GetVertexScore( -1, remaining[ i ] );
+    }
+
+std::vector<float> triangle_scores( triangle_count );
+uint32_t best = 0;
+for( uint32_t i = 0; i < triangle_count; i++ )
+    {
+    triangle_scores[ i ] = vertex_scores[ indices[ 3 * i + 0 ] ]
+                         + vertex_scores[ indices[ 3 * i + 1 ] ]
+                         + vertex_scores[ indices[ 3 * i + 2 ] ];
+    if( triangle_scores[ i ] > triangle_scores[ best ] )
+        {
+        best = i;
+        }
+    }
+
+std::vector<bool> is_emitted( triangle_count, false );
+std::vector<AssetFileModelIndex> ordered( 3 * triangle_count );
+uint32_t cache[ FORSYTH_CACHE_SIZE + 3 ];
+uint32_t cache_cnt = 0;
+uint32_t input_cursor = 0;
+
+for( uint32_t emitted = 0; emitted < triangle_count; emitted++ )
+    {
+    if( best == INVALID_INDEX )
+        {
+        while( is_emitted[ input_cursor ] )
+            {
+            input_cursor++;
+            }
+
+        best = input_cursor;
+        }
+
+    const AssetFileModelIndex *triangle = &indices[ 3 * best ];
+    memcpy( &ordered[ 3 * emitted ], triangle, 3 * sizeof( *triangle ) );
+    is_emitted[ best ] = true;
+
+    for( int k = 0; k < 3; k++ )
+        {
+        uint32_t *list = &adjacency[ adjacency_offsets[ triangle[ k ] ] ];
+        uint32_t &cnt = remaining[ triangle[ k ] ];
+        for( uint32_t j = 0; j < cnt; j++ )
+            {
+            if( list[ j ] == best )
+                {
+                list[ j ] = list[ cnt - 1 ];
+                cnt--;
+                break;
+                }
+            }
+        }
+
+    /* move the triangle's vertices to the front, the tail spills out */
+    uint32_t next_cache[ FORSYTH_CACHE_SIZE + 3 ];
+    uint32_t next_cnt = 0;
+    for( int k = 0; k < 3; k++ )
+        {
+        if( std::find( next_cache, next_cache + next_cnt, triangle[ k ] ) == next_cache + next_cnt )
+            {
+            next_cache[ next_cnt++ ] = triangle[ k ];
+            }
+        }
+
+    for( uint32_t i = 0; i < cache_cnt; i++ )
+        {
+        if( cache[ i ] != triangle[ 0 ]
+         && cache[ i ] != triangle[ 1 ]
+         && cache[ i ] != triangle[ 2 ] )
+            {
+            next_cache[ next_cnt++ ] = cache[ i ];
+            }
+        }
+
+    for( uint32_t i = 0; i < next_cnt; i++ )
+        {
+        uint32_t vertex = next_cache[ i ];
+        float score = GetVertexScore( i < FORSYTH_CACHE_SIZE ? (int)i : -1, remaining[ vertex ] );
+        float delta = score - vertex_scores[ vertex ];
+        vertex_scores[ vertex ] = score;
+
+        const uint32_t *list = &adjacency[ adjacency_offsets[ vertex ] ];
+        for( uint32_t j = 0; j < remaining[ vertex ]; j++ )
+            {
+            triangle_scores[ list[ j ] ] += delta;
+            }
+        }
+
+    cache_cnt = std::min( next_cnt, (uint32_t)FORSYTH_CACHE_SIZE );
+    memcpy( cache, next_cache, cache_cnt * sizeof( *cache ) );
+
+    best = INVALID_INDEX;
+    for( uint32_t i = 0; i < cache_cnt; i++ )
+        {
+        const uint32_t *list = &adjacency[ adjacency_offsets[ cache[ i ] ] ];
+        for( uint32_t j = 0; j < remaining[ cache[ i ] ]; j++ )
+            {
+            if( best == INVALID_INDEX
+             || triangle_scores[ list[ j ] ] > triangle_scores[ best ] )
+                {
+                best = list[ j ];
+                }
+            }
+        }
+    }
+
+memcpy( indices, ordered.data(), ordered.size() * sizeof( *indices ) );
+
+} /* ExportMesh_OptimizeVertexCache() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_OptimizeVertexFetch()
+*
+*   DESCRIPTION:
+*       Renumber the vertices in the order the indices first use
+*       them so vertex fetch walks memory forward.  Unreferenced
+*       vertices are dropped; returns the new vertex count.
+*
+*******************************************************************/
+
+uint32_t ExportMesh_OptimizeVertexFetch( AssetFileModelVertex *vertices, AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count )
+{
+std::vector<AssetFileModelIndex> remap( vertex_count, INVALID_INDEX );
+std::vector<AssetFileModelVertex> ordered;
+ordered.reserve( vertex_count );
+
+for( uint32_t i = 0; i < index_count; i++ )
+    {
+    AssetFileModelIndex &index = indices[ i ];
+    if( remap[ index ] == INVALID_INDEX )
+        {
+        remap[ index ] = (AssetFileModelIndex)ordered.size();
+        ordered.push_back( vertices[ index ] );
+        }
+
+    index = remap[ index ];
+    }
+
+std::copy( ordered.begin(), ordered.end(), vertices );
+
+return( (uint32_t)ordered.size() );
+
+} /* ExportMesh_OptimizeVertexFetch() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_Simplify()
+*
+*   DESCRIPTION:
+*       Reduce the triangle list towards the target index count by
+*       quadric error edge collapses, each moving a vertex onto a
+*       neighbour so the vertex buffer is shared with the source.
+*       Vertices on open borders or UV seams stay put, and no collapse
+*       may turn a triangle by more than 60 degrees.  Writes up to
+*       index_count indices to out, returns the count and the largest
+*       distance any surface moved.
+*
+*******************************************************************/
+
+uint32_t ExportMesh_Simplify( const AssetFileModelIndex *indices, const uint32_t index_count, const AssetFileModelVertex *vertices, const uint32_t vertex_count, const uint32_t target_index_count, AssetFileModelIndex *out, float *error )
+{
+*error = 0.0f;
+uint32_t count = index_count - index_count % 3;
+memcpy( out, indices, count * sizeof( *out ) );
+
+/* vertices sharing a position are split by attributes, lock them so seams don't open */
+uint32_t slot_cnt = 16;
+while( slot_cnt < 2 * (uint64_t)vertex_count )
+    {
+    slot_cnt *= 2;
+    }
+
+std::vector<uint32_t> slots( slot_cnt, 0 );
+std::vector<uint32_t> position_ids( vertex_count );
+std::vector<bool> is_locked( vertex_count, false );
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    const size_t position_sz = 3 * sizeof( float );
+    uint32_t slot = AssetFile_FNV1a( &vertices[ i ].x, position_sz ) & ( slot_cnt - 1 );
+    while( slots[ slot ]
+        && memcmp( &vertices[ slots[ slot ] - 1 ].x, &vertices[ i ].x, position_sz ) )
+        {
+        slot = ( slot + 1 ) & ( slot_cnt - 1 );
+        }
+
+    if( !slots[ slot ] )
+        {
+        slots[ slot ] = i + 1;
+        }
+    else
+        {
+        is_locked[ slots[ slot ] - 1 ] = true;
+        is_locked[ i ] = true;
+        }
+
+    position_ids[ i ] = slots[ slot ] - 1;
+    }
+
+/* so do the ends of edges on an open border */
+std::unordered_map<uint64_t, uint32_t> edge_uses;
+for( uint32_t i = 0; i < count; i++ )
+    {
+    uint64_t a = position_ids[ out[ i ] ];
+    uint64_t b = position_ids[ out[ i - i % 3 + ( i + 1 ) % 3 ] ];
+    edge_uses[ a < b ? ( a << 32 ) | b : ( b << 32 ) | a ]++;
+    }
+
+for( uint32_t i = 0; i < count; i++ )
+    {
+    AssetFileModelIndex a = out[ i ];
+    AssetFileModelIndex b = out[ i - i % 3 + ( i + 1 ) % 3 ];
+    uint64_t pa = position_ids[ a ];
+    uint64_t pb = position_ids[ b ];
+    if( edge_uses[ pa < pb ? ( pa << 32 ) | pb : ( pb << 32 ) | pa ] == 1 )
+        {
+        is_locked[ a ] = true;
+        is_locked[ b ] = true;
+        }
+    }
+
+/* area weighted plane quadrics */
+std::vector<MeshQuadric> quadrics( vertex_count, MeshQuadric{} );
+for( uint32_t i = 0; i < count; i += 3 )
+    {
+    const float *p0 = &vertices[ out[ i + 0 ] ].x;
+    const float *p1 = &vertices[ out[ i + 1 ] ].x;
+    const float *p2 = &vertices[ out[ i + 2 ] ].x;
+    double e1[ 3 ] = { (double)p1[ 0 ] - p0[ 0 ], (double)p1[ 1 ] - p0[ 1 ], (double)p1[ 2 ] - p0[ 2 ] };
+    double e2[ 3 ] = { (double)p2[ 0 ] - p0[ 0 ], (double)p2[ 1 ] - p0[ 1 ], (double)p2[ 2 ] - p0[ 2 ] };
+    double n[ 3 ] =
+        {
+        e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ],
+        e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ],
+        e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ]
+        };
+
+    double length = sqrt( n[ 0 ] * n[ 0 ] + n[ 1 ] * n[ 1 ] + n[ 2 ] * n[ 2 ] );
+    if( length == 0.0 )
+        {
+        continue;
+        }
+
+    double plane[ 4 ] = { n[ 0 ] / length, n[ 1 ] / length, n[ 2 ] / length, 0.0 };
+    plane[ 3 ] = -( plane[ 0 ] * p0[ 0 ] + plane[ 1 ] * p0[ 1 ] + plane[ 2 ] * p0[ 2 ] );
+
+    MeshQuadric quadric = {};
+    quadric.area = 0.5 * length;
+    int k = 0;
+    for( int r = 0; r < 4; r++ )
+        {
+        for( int c = r; c < 4; c++ )
+            {
+            quadric.a[ k++ ] = quadric.area * plane[ r ] * plane[ c ];
+            }
+        }
+
+    for( int j = 0; j < 3; j++ )
+        {
+        AddQuadric( &quadric, &quadrics[ out[ i + j ] ] );
+        }
+    }
+
+/* passes of independent collapses, cheapest first, until the target is met */
+double max_cost = 0.0;
+std::vector<uint32_t> adjacency_offsets( vertex_count + 1 );
+std::vector<uint32_t> adjacency;
+std::vector<MeshCollapse> collapses;
+std::vector<bool> is_dirty( vertex_count );
+while( count > target_index_count )
+    {
+    std::fill( adjacency_offsets.begin(), adjacency_offsets.end(), 0 );
+    for( uint32_t i = 0; i < count; i++ )
+        {
+        adjacency_offsets[ out[ i ] + 1 ]++;
+        }
+
+    for( uint32_t i = 0; i < vertex_count; i++ )
+        {
+        adjacency_offsets[ i + 1 ] += adjacency_offsets[ i ];
+        }
+
+    adjacency.resize( count );
+    std::vector<uint32_t> fill( adjacency_offsets.begin(), adjacency_offsets.end() - 1 );
+    for( uint32_t i = 0; i < count; i++ )
+        {
+        adjacency[ fill[ out[ i ] ]++ ] = i / 3;
+        }
+
+    collapses.clear();
+    for( uint32_t i = 0; i < count; i++ )
+        {
+        AssetFileModelIndex a = out[ i ];
+        AssetFileModelIndex b = out[ i - i % 3 + ( i + 1 ) % 3 ];
+        for( int direction = 0; direction < 2; direction++ )
+            {
+            if( !is_locked[ a ] )
+                {
+                double area = quadrics[ a ].area + quadrics[ b ].area;
+                double cost = EvaluateQuadric( &quadrics[ a ], &vertices[ b ].x ) + EvaluateQuadric( &quadrics[ b ], &vertices[ b ].x );
+                collapses.push_back( { a, b, area > 0.0 ? std::max( cost, 0.0 ) / area : 0.0 } );
+                }
+
+            std::swap( a, b );
+            }
+        }
+
+    std::sort( collapses.begin(), collapses.end(), []( const MeshCollapse &x, const MeshCollapse &y ) { return( x.cost < y.cost ); } );
+
+    /* a collapse usually removes two triangles */
+    uint32_t removed = 0;
+    uint32_t needed = ( count - target_index_count + 2 ) / 3;
+    uint32_t collapsed = 0;
+    std::fill( is_dirty.begin(), is_dirty.end(), false );
+    for( const MeshCollapse &collapse : collapses )
+        {
+        if( removed >= needed )
+            {
+            break;
+            }
+
+        if( is_dirty[ collapse.from ]
+         || is_dirty[ collapse.to ] )
+            {
+            continue;
+            }
+
+        /* reject any collapse that turns a surviving triangle too far */
+        bool is_flipped = false;
+        for( uint32_t j = adjacency_offsets[ collapse.from ]; j < adjacency_offsets[ collapse.from + 1 ] && !is_flipped; j++ )
+            {
+            const AssetFileModelIndex *triangle = &out[ 3 * adjacency[ j ] ];
+            if( triangle[ 0 ] == collapse.to
+             || triangle[ 1 ] == collapse.to
+             || triangle[ 2 ] == collapse.to )
+                {
+                continue;
+                }
+
+            const float *before[ 3 ];
+            const float *after[ 3 ];
+            for( int k = 0; k < 3; k++ )
+                {
+                before[ k ] = &vertices[ triangle[ k ] ].x;
+                after[ k ]  = triangle[ k ] == collapse.from ? &vertices[ collapse.to ].x : before[ k ];
+                }
+
+            float normals[ 2 ][ 3 ];
+            const float **corners[ 2 ] = { before, after };
+            for( int n = 0; n < 2; n++ )
+                {
+                const float **p = corners[ n ];
+                float e1[ 3 ] = { p[ 1 ][ 0 ] - p[ 0 ][ 0 ], p[ 1 ][ 1 ] - p[ 0 ][ 1 ], p[ 1 ][ 2 ] - p[ 0 ][ 2 ] };
+                float e2[ 3 ] = { p[ 2 ][ 0 ] - p[ 0 ][ 0 ], p[ 2 ][ 1 ] - p[ 0 ][ 1 ], p[ 2 ][ 2 ] - p[ 0 ][ 2 ] };
+                normals[ n ][ 0 ] = e1[ 1 ] * e2[ 2 ] - e1[ 2 ] * e2[ 1 ];
+                normals[ n ][ 1 ] = e1[ 2 ] * e2[ 0 ] - e1[ 0 ] * e2[ 2 ];
+                normals[ n ][ 2 ] = e1[ 0 ] * e2[ 1 ] - e1[ 1 ] * e2[ 0 ];
+                }
+
+            float dot = normals[ 0 ][ 0 ] * normals[ 1 ][ 0 ] + normals[ 0 ][ 1 ] * normals[ 1 ][ 1 ] + normals[ 0 ][ 2 ] * normals[ 1 ][ 2 ];
+            float lengths = sqrtf( ( normals[ 0 ][ 0 ] * normals[ 0 ][ 0 ] + normals[ 0 ][ 1 ] * normals[ 0 ][ 1 ] + normals[ 0 ][ 2 ] * normals[ 0 ][ 2 ] )
+                                 * ( normals[ 1 ][ 0 ] * normals[ 1 ][ 0 ] + normals[ 1 ][ 1 ] * normals[ 1 ][ 1 ] + normals[ 1 ][ 2 ] * normals[ 1 ][ 2 ] ) );
+            is_flipped = dot <= SIMPLIFY_MIN_NORMAL_DOT * lengths;
+            }
+
+        if( is_flipped )
+            {
+            continue;
+            }
+
+        /* move the vertex, its neighbourhood sits out the rest of the pass */
+        for( uint32_t j = adjacency_offsets[ collapse.from ]; j < adjacency_offsets[ collapse.from + 1 ]; j++ )
+            {
+            AssetFileModelIndex *triangle = &out[ 3 * adjacency[ j ] ];
+            for( int k = 0; k < 3; k++ )
+                {
+                if( triangle[ k ] == collapse.from )
+                    {
+                    triangle[ k ] = collapse.to;
+                    }
+
+                is_dirty[ triangle[ k ] ] = true;
+                }
+
+            if( triangle[ 0 ] == triangle[ 1 ]
+             || triangle[ 1 ] == triangle[ 2 ]
+             || triangle[ 2 ] == triangle[ 0 ] )
+                {
+                removed++;
+                }
+            }
+
+        AddQuadric( &quadrics[ collapse.from ], &quadrics[ collapse.to ] );
+        is_dirty[ collapse.from ] = true;
+        max_cost = std::max( max_cost, collapse.cost );
+        collapsed++;
+        }
+
+    if( collapsed == 0 )
+        {
+        break;
+        }
+
+    /* drop the triangles that collapsed */
+    uint32_t kept = 0;
+    for( uint32_t i = 0; i < count; i += 3 )
+        {
+        if( out[ i + 0 ] != out[ i + 1 ]
+         && out[ i + 1 ] != out[ i + 2 ]
+         && out[ i + 2 ] != out[ i + 0 ] )
+            {
+            out[ kept++ ] = out[ i + 0 ];
+            out[ kept++ ] = out[ i + 1 ];
+            out[ kept++ ] = out[ i + 2 ];
+            }
+        }
+
+    count = kept;
+    }
+
+*error = (float)sqrt( max_cost );
+return( count );
+
+} /* ExportMesh_Simplify() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_TransformBounds()
+*
+*   DESCRIPTION:
+*       Move the bounds through a row major transform applied to
+*       column vectors, as Assimp stores them.  The box is refit
+*       around the moved box; the sphere radius grows by the longest
+*       axis scale, which holds for rotation and scale but not shear.
+*
+*******************************************************************/
+
+void ExportMesh_TransformBounds( const AssetFileModelBounds *bounds, const float *mat4x4, AssetFileModelBounds *out )
+{
+if( bounds->radius < 0.0f )
+    {
+    *out = *bounds;
+    return;
+    }
+
+AssetFileModelBounds moved = {};
+float axis_scale = 0.0f;
+for( int k = 0; k < 3; k++ )
+    {
+    axis_scale = std::max( axis_scale, mat4x4[ 0 * 4 + k ] * mat4x4[ 0 * 4 + k ]
+                                     + mat4x4[ 1 * 4 + k ] * mat4x4[ 1 * 4 + k ]
+                                     + mat4x4[ 2 * 4 + k ] * mat4x4[ 2 * 4 + k ] );
+    }
+
+for( int r = 0; r < 3; r++ )
+    {
+    const float *row = &mat4x4[ r * 4 ];
+    float box_center = row[ 3 ];
+    float box_extent = 0.0f;
+    moved.center[ r ] = row[ 3 ];
+    for( int k = 0; k < 3; k++ )
+        {
+        box_center += row[ k ] * 0.5f * ( bounds->min[ k ] + bounds->max[ k ] );
+        box_extent += fabsf( row[ k ] ) * 0.5f * ( bounds->max[ k ] - bounds->min[ k ] );
+        moved.center[ r ] += row[ k ] * bounds->center[ k ];
+        }
+
+    moved.min[ r ] = box_center - box_extent;
+    moved.max[ r ] = box_center + box_extent;
+    }
+
+moved.radius = bounds->radius * sqrtf( axis_scale );
+*out = moved;
+
+} /* ExportMesh_TransformBounds() */
+
+
+/*******************************************************************
+*
+*   ExportMesh_WeldVertices()
+*
+*   DESCRIPTION:
+*       Merge bitwise identical vertices through a hashed vertex map,
+*       compacting the survivors in first-seen order and remapping
+*       the indices.  Returns the new vertex count.
+*
+*******************************************************************/
+
+uint32_t ExportMesh_WeldVertices( AssetFileModelVertex *vertices, AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count )
+{
+/* open addressed, unique vertex + 1 or 0, kept at most half full */
+uint32_t slot_cnt = 16;
+while( slot_cnt < 2 * (uint64_t)vertex_count )
+    {
+    slot_cnt *= 2;
+    }
+
+std::vector<uint32_t> slots( slot_cnt, 0 );
+std::vector<AssetFileModelIndex> remap( vertex_count );
+uint32_t unique_cnt = 0;
+for( uint32_t i = 0; i < vertex_count; i++ )
+    {
+    uint32_t slot = AssetFile_FNV1a( &vertices[ i ], sizeof( *vertices ) ) & ( slot_cnt - 1 );
+    while( slots[ slot ]
+        && memcmp( &vertices[ slots[ slot ] - 1 ], &vertices[ i ], sizeof( *vertices ) ) )
+        {
+        slot = ( slot + 1 ) & ( slot_cnt - 1 );
+        }
+
+    if( !slots[ slot ] )
+        {
+        vertices[ unique_cnt ] = vertices[ i ];
+        slots[ slot ] = ++unique_cnt;
+        }
+
+    remap[ i ] = slots[ slot ] - 1;
+    }
+
+for( uint32_t i = 0; i < index_count; i++ )
+    {
+    indices[ i ] = remap[ indices[ i ] ];
+    }
+
+return( unique_cnt );
+
+} /* ExportMesh_WeldVertices() */
+
+
+/*******************************************************************
+*
+*   AddQuadric()
+*
+*******************************************************************/
+
+static void AddQuadric( const MeshQuadric *add, MeshQuadric *sum )
+{
+for( int i = 0; i < 10; i++ )
+    {
+    sum->a[ i ] += add->a[ i ];
+    }
+
+sum->area += add->area;
+
+} /* AddQuadric() */
+
+
+/*******************************************************************
+*
+*   BoundMeshlet()
+*
+*   DESCRIPTION:
+*       Set the meshlet's bounding sphere and the cone its triangles
+*       face into.  The apex is pulled back along the axis until it
+*       lies behind every triangle's plane.
+*
+*******************************************************************/
+
+static void BoundMeshlet( const AssetFileModelVertex *vertices, const uint32_t *meshlet_vertices, const uint8_t *meshlet_triangles, AssetFileModelMeshlet *meshlet )
+{
+std::vector<AssetFileModelVertex> positions( meshlet->vertex_count );
+for( uint32_t i = 0; i < meshlet->vertex_count; i++ )
+    {
+    positions[ i ] = vertices[ meshlet_vertices[ i ] ];
+    }
+
+AssetFileModelBounds bounds;
+ExportMesh_ComputeBounds( positions.data(), meshlet->vertex_count, &bounds );
+memcpy( meshlet->center, bounds.center, sizeof( meshlet->center ) );
+meshlet->radius = bounds.radius;
+
+/* unit normals of the triangles with area */
+std::vector<MeshletFace> faces;
+faces.reserve( meshlet->triangle_count );
+float axis[ 3 ] = {};
+for( uint32_t i = 0; i < meshlet->triangle_count; i++ )
+    {
+    const float *a = &positions[ meshlet_triangles[ 3 * i + 0 ] ].x;
+    const float *b = &positions[ meshlet_triangles[ 3 * i + 1 ] ].x;
+    const float *c = &positions[ meshlet_triangles[ 3 * i + 2 ] ].x;
+    float ab[ 3 ] = { b[ 0 ] - a[ 0 ], b[ 1 ] - a[ 1 ], b[ 2 ] - a[ 2 ] };
+    float ac[ 3 ] = { c[ 0 ] - a[ 0 ], c[ 1 ] - a[ 1 ], c[ 2 ] - a[ 2 ] };
+    float normal[ 3 ] =
+        {
+        ab[ 1 ] * ac[ 2 ] - ab[ 2 ] * ac[ 1 ],
+        ab[ 2 ] * ac[ 0 ] - ab[ 0 ] * ac[ 2 ],
+        ab[ 0 ] * ac[ 1 ] - ab[ 1 ] * ac[ 0 ]
+        };
+
+    float length = sqrtf( normal[ 0 ] * normal[ 0 ] + normal[ 1 ] * normal[ 1 ] + normal[ 2 ] * normal[ 2 ] );
+    if( length == 0.0f )
+        {
+        continue;
+        }
+
+    MeshletFace face = {};
+    for( int k = 0; k < 3; k++ )
+        {
+        face.normal[ k ] = normal[ k ] / length;
+        axis[ k ] += face.normal[ k ];
+        }
+
+    face.corner = meshlet_triangles[ 3 * i ];
+    faces.push_back( face );
+    }
+
+memcpy( meshlet->cone_apex, meshlet->center, sizeof( meshlet->cone_apex ) );
+meshlet->cone_axis[ 2 ] = 1.0f;
+meshlet->cone_cutoff    = MESHLET_CONE_NEVER;
+
+float axis_length = sqrtf( axis[ 0 ] * axis[ 0 ] + axis[ 1 ] * axis[ 1 ] + axis[ 2 ] * axis[ 2 ] );
+if( axis_length == 0.0f )
+    {
+    return;
+    }
+
+float min_dot = 1.0f;
+for( int k = 0; k < 3; k++ )
+    {
+    axis[ k ] /= axis_length;
+    }
+
+for( const MeshletFace &face : faces )
+    {
+    min_dot = std::min( min_dot, face.normal[ 0 ] * axis[ 0 ] + face.normal[ 1 ] * axis[ 1 ] + face.normal[ 2 ] * axis[ 2 ] );
+    }
+
+if( min_dot <= MESHLET_CONE_MIN_DOT )
+    {
+    return;
+    }
+
+/* back the apex off so every triangle's plane has it on the back side */
+float apex_distance = 0.0f;
+for( const MeshletFace &face : faces )
+    {
+    const float *normal = face.normal;
+    const float *corner = &positions[ face.corner ].x;
+    float center_side = ( meshlet->center[ 0 ] - corner[ 0 ] ) * normal[ 0 ]
+                      + ( meshlet->center[ 1 ] - corner[ 1 ] ) * normal[ 1 ]
+                      + ( meshlet->center[ 2 ] - corner[ 2 ] ) * normal[ 2 ];
+    float axis_dot = axis[ 0 ] * normal[ 0 ] + axis[ 1 ] * normal[ 1 ] + axis[ 2 ] * normal[ 2 ];
+    apex_distance = std::max( apex_distance, center_side / axis_dot );
+    }
+
+for( int k = 0; k < 3; k++ )
+    {
+    meshlet->cone_apex[ k ] = meshlet->center[ k ] - axis[ k ] * apex_distance;
+    }
+
+memcpy( meshlet->cone_axis, axis, sizeof( meshlet->cone_axis ) );
+meshlet->cone_cutoff = sqrtf( 1.0f - min_dot * min_dot );
+
+} /* BoundMeshlet() */
+
+
+/*******************************************************************
+*
+*   Distance()
+*
+*******************************************************************/
+
+static float Distance( const float *a, const float *b )
+{
+float dx = a[ 0 ] - b[ 0 ];
+float dy = a[ 1 ] - b[ 1 ];
+float dz = a[ 2 ] - b[ 2 ];
+
+return( sqrtf( dx * dx + dy * dy + dz * dz ) );
+
+} /* Distance() */
+
+
+/*******************************************************************
+*
+*   EvaluateQuadric()
+*
+*   DESCRIPTION:
+*       Area weighted sum of squared distances from the position to
+*       the quadric's planes.
+*
+*******************************************************************/
+
+static double EvaluateQuadric( const MeshQuadric *quadric, const float *position )
+{
+const double *a = quadric->a;
+double x = position[ 0 ];
+double y = position[ 1 ];
+double z = position[ 2 ];
+
+return( a[ 0 ] * x * x + 2.0 * a[ 1 ] * x * y + 2.0 * a[ 2 ] * x * z + 2.0 * a[ 3 ] * x
+      + a[ 4 ] * y * y + 2.0 * a[ 5 ] * y * z + 2.0 * a[ 6 ] * y
+      + a[ 7 ] * z * z + 2.0 * a[ 8 ] * z
+      + a[ 9 ] );
+
+} /* EvaluateQuadric() */
+
+
+/*******************************************************************
+*
+*   GetVertexScore()
+*
+*   DESCRIPTION:
+*       Forsyth's vertex score.  The three most recent entries score
+*       flat so the next triangle does not just reuse the last edge,
+*       and vertices with few triangles left are boosted to finish
+*       them off before they fall out of the cache.
+*
+*******************************************************************/
+
+static float GetVertexScore( const int cache_position, const uint32_t remaining )
+{
+if( remaining == 0 )
+    {
+    return( -1.0f );
+    }
+
+float score = 0.0f;
+if( cache_position >= 3 )
+    {
+    float scale = 1.0f / (float)( FORSYTH_CACHE_SIZE - 3 );
+    score = powf( 1.0f - (float)( cache_position - 3 ) * scale, FORSYTH_CACHE_DECAY_POWER );
+    }
+else if( cache_position >= 0 )
+    {
+    score = FORSYTH_LAST_TRIANGLE_SCORE;
+    }
+
+score += FORSYTH_VALENCE_BOOST_SCALE * powf( (float)remaining, -FORSYTH_VALENCE_BOOST_POWER );
+
+return( score );
+
+} /* GetVertexScore() */
+
+
+/*******************************************************************
+*
+*   SimulateCache()
+*
+*   DESCRIPTION:
+*       Draw one triangle through a FIFO cache kept as per vertex
+*       insertion times.  Returns the number of misses.  Advancing
+*       the time by more than the cache size empties it.
+*
+*******************************************************************/
+
+static uint32_t SimulateCache( const AssetFileModelIndex *triangle, uint32_t *timestamps, uint32_t *time )
+{
+uint32_t misses = 0;
+for( int k = 0; k < 3; k++ )
+    {
+    if( *time - timestamps[ triangle[ k ] ] > ANALYZE_CACHE_SIZE )
+        {
+        timestamps[ triangle[ k ] ] = ( *time )++;
+        misses++;
+        }
+    }
+
+return( misses );
+
+} /* SimulateCache() */
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <vector>
+
+#include "AssetFile.hpp"
+
+#define EXPORT_MESH_OVERDRAW_THRESHOLD \
+                                    ( 1.05f )
+                                    /* ACMR allowed for sorting    */
+
+typedef struct
+    {
+    uint32_t            triangle_cnt;
+    uint32_t            vertex_cnt;
+    uint32_t            transformed_cnt;
+                                    /* simulated cache misses       */
+    } ExportMeshCacheStats;
+
+
+void     ExportMesh_AnalyzeVertexCache( const AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count, ExportMeshCacheStats *stats );
+void     ExportMesh_BuildMeshlets( const AssetFileModelIndex *indices, const uint32_t index_count, const AssetFileModelVertex *vertices, const uint32_t vertex_count, std::vector<AssetFileModelMeshlet> *meshlets, std::vector<uint32_t> *meshlet_vertices, std::vector<uint8_t> *meshlet_triangles );
+void     ExportMesh_ComputeBounds( const AssetFileModelVertex *vertices, const uint32_t vertex_count, AssetFileModelBounds *bounds );
+void     ExportMesh_MergeBounds( const AssetFileModelBounds *a, const AssetFileModelBounds *b, AssetFileModelBounds *out );
+void     ExportMesh_OptimizeOverdraw( AssetFileModelIndex *indices, const uint32_t index_count, const AssetFileModelVertex *vertices, const uint32_t vertex_count, const float threshold );
+void     ExportMesh_OptimizeVertexCache( AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count );
+uint32_t ExportMesh_OptimizeVertexFetch( AssetFileModelVertex *vertices, AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count );
+uint32_t ExportMesh_Simplify( const AssetFileModelIndex *indices, const uint32_t index_count, const AssetFileModelVertex *vertices, const uint32_t vertex_count, const uint32_t target_index_count, AssetFileModelIndex *out, float *error );
+void     ExportMesh_TransformBounds( const AssetFileModelBounds *bounds, const float *mat4x4, AssetFileModelBounds *out );
+uint32_t ExportMesh_WeldVertices( AssetFileModelVertex *vertices, AssetFileModelIndex *indices, const uint32_t index_count, const uint32_t vertex_count );
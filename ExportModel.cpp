@@ -1,9 +1,13 @@
+#include <algorithm>
 #include <cassert>
+#include <cfloat>
+#include <iomanip>
 #include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 
 #include "AssetFile.hpp"
+#include "ExportMesh.hpp"
 #include "ExportModel.hpp"
 #include "ResourceUtilities.hpp"
 
@@ -21,10 +25,17 @@ static const LocalMatrix4x4 IDENTITY_4x4 =
 	0.0f, 0.0f, 0.0f, 1.0f
 	};
 
+static const char *VERTEX_FORMAT_NAMES[ ASSET_FILE_MODEL_VERTEX_FORMAT_CNT ] =
+	{
+	"f32",
+	"packed"
+	};
+
 typedef struct _LocalNode
 	{
 	const aiNode          *node;
 	LocalMatrix4x4         transform;
+	AssetFileModelBounds   bounds;
 	std::vector<_LocalNode>
 	                       children;
 	} LocalNode;
@@ -149,6 +160,7 @@ c[ 15 ] = a[ 0 + 3 * 4 ] * b[ 3 + 0 * 4 ]
 }   /* Multiply4x4() */
 
 
+static void     BoundNode( LocalNode *node, const std::vector<AssetFileModelBounds> *mesh_bounds );
 static uint32_t ParseNode( const aiNode *node, const LocalMatrix4x4 *transform, LocalNode *parent );
 static bool     WriteNode( const LocalNode *node, const AssetFileModelIndex element_id, const std::unordered_map<uint32_t, uint32_t> *mesh_index_to_element_index, uint32_t *element_count, AssetFileWriter *output );
 
@@ -158,15 +170,22 @@ static bool     WriteNode( const LocalNode *node, const AssetFileModelIndex elem
 *   ExportModel_Export()
 *
 *   DESCRIPTION:
-*       Export the given model by filename.
+*       Export the given model by filename.  Identical vertices are
+*       welded, and meshes that then fit use 16-bit indices.  Unless
+*       disabled, each triangle mesh is reordered for the
+*       post-transform cache, then for overdraw, then its vertices for
+*       fetch order.  Every mesh and node is stored with its bounds,
+*       and meshes are split into meshlets if asked.  Triangle meshes
+*       get a simplified level of detail per requested ratio, kept
+*       only while each one sheds enough triangles.
 *
 *******************************************************************/
 
-bool ExportModel_Export( const AssetFileAssetId id, const char *filename, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output )
+bool ExportModel_Export( const AssetFileAssetId id, const char *filename, const ExportModelOptions *options, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output )
 {
 *stats = {};
 Assimp::Importer importer;
-size_t write_start_size = AssetFile_GetWriteSize( output );
+size_t write_start_size = AssetFile_GetLogicalWriteSize( output );
 
 const aiScene *scene = importer.ReadFile( std::string( filename ), aiProcess_Triangulate | aiProcess_ConvertToLeftHanded );
 if( !scene )
@@ -191,7 +210,7 @@ for( unsigned int i = 0; i < scene->mRootNode->mNumChildren; i++ )
 	node_count += ParseNode( root_node.node, &root_node.transform, &root_node );
 	}
 
-if( !AssetFile_DescribeModel( node_count, (uint32_t)scene->mNumMeshes, (uint32_t)scene->mNumMaterials, output ) )
+if( !AssetFile_DescribeModel2( node_count, (uint32_t)scene->mNumMeshes, (uint32_t)scene->mNumMaterials, options->meshlets, output ) )
 	{
 	print_error( "ExportModel_Export() could not write model header (%s).", filename );
 	return( false );
@@ -200,6 +219,9 @@ if( !AssetFile_DescribeModel( node_count, (uint32_t)scene->mNumMeshes, (uint32_t
 uint32_t max_element_count = node_count + (uint32_t)scene->mNumMeshes + (uint32_t)scene->mNumMaterials;
 uint32_t element_count = 0;
 
+/* meshlet elements follow all the others, in mesh order */
+uint32_t meshlets_element_base = max_element_count;
+
 /* Materials */
 std::unordered_map<uint32_t, uint32_t> map_material_index_to_element_index;
 for( unsigned int i = 0; i < scene->mNumMaterials; i++ )
@@ -269,6 +291,18 @@ for( unsigned int i = 0; i < scene->mNumMaterials; i++ )
 
 /* Meshes */
 std::unordered_map<uint32_t, uint32_t> map_mesh_index_to_element_index;
+std::vector<AssetFileModelVertex> staged_vertices;
+std::vector<AssetFileModelIndex> staged_indices;
+std::vector<AssetFileModelBounds> mesh_bounds( scene->mNumMeshes );
+ExportMeshCacheStats cache_before = {};
+ExportMeshCacheStats cache_after = {};
+uint32_t welded_count = 0;
+std::vector<AssetFileModelMeshlet> meshlets;
+std::vector<uint32_t> meshlet_vertices;
+std::vector<uint8_t> meshlet_triangles;
+uint32_t meshlet_count = 0;
+std::vector<AssetFileModelIndex> lod_indices;
+uint32_t lod_total_count = 0;
 for( unsigned int i = 0; i < scene->mNumMeshes; i++ )
 	{
 	aiMesh *mesh = scene->mMeshes[ i ];
@@ -279,38 +313,166 @@ for( unsigned int i = 0; i < scene->mNumMeshes; i++ )
 		index_count += (uint32_t)mesh->mFaces[ j ].mNumIndices;
 		}
 
-	if( !AssetFile_BeginWritingModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, element_count, output )
-	 || !AssetFile_DescribeModelMesh( map_material_index_to_element_index[ mesh->mMaterialIndex ], (uint32_t)mesh->mNumVertices, index_count, output ) )
+	/* Vertices - kept as straight strided copies so the compiler can vectorize them */
+	uint32_t vertex_count = (uint32_t)mesh->mNumVertices;
+	staged_vertices.assign( vertex_count, AssetFileModelVertex{} );
+
+	AssetFileModelVertex *vertices = staged_vertices.data();
+	const aiVector3D *positions = mesh->mVertices;
+	for( uint32_t j = 0; j < vertex_count; j++ )
 		{
-		print_error( "ExportModel_Export() could not start writing new model mesh element (%s).", filename );
-		return( false );
+		vertices[ j ].x = positions[ j ].x;
+		vertices[ j ].y = positions[ j ].y;
+		vertices[ j ].z = positions[ j ].z;
 		}
 
-	/* Vertices */
-	for( unsigned int j = 0; j < mesh->mNumVertices; j++ )
+	const aiVector3D *uvs = mesh->mTextureCoords[ 0 ];
+	if( uvs )
 		{
-		AssetFileModelVertex v = {};
-		v.x = mesh->mVertices[ j ].x;
-		v.y = mesh->mVertices[ j ].y;
-		v.z = mesh->mVertices[ j ].z;
-
-		if( mesh->mTextureCoords[ 0 ] )
+		for( uint32_t j = 0; j < vertex_count; j++ )
 			{
-			v.u0 = mesh->mTextureCoords[ 0 ][ j ].x;
-			v.v0 = mesh->mTextureCoords[ 0 ][ j ].y;
+			vertices[ j ].u0 = uvs[ j ].x;
+			vertices[ j ].v0 = uvs[ j ].y;
 			}
-
-		AssetFile_WriteModelMeshVertex( &v, output );
 		}
 
 	/* Indices */
+	staged_indices.resize( index_count );
+	AssetFileModelIndex *indices = staged_indices.data();
 	for( unsigned int j = 0; j < mesh->mNumFaces; j++ )
 		{
-		aiFace *face = &mesh->mFaces[ j ];
+		const aiFace *face = &mesh->mFaces[ j ];
 		for( unsigned int k = 0; k < face->mNumIndices; k++ )
 			{
-			AssetFile_WriteModelMeshIndex( (AssetFileModelIndex)face->mIndices[ k ], output );
+			*indices++ = (AssetFileModelIndex)face->mIndices[ k ];
+			}
+		}
+
+	/* Welding */
+	uint32_t unique_count = ExportMesh_WeldVertices( staged_vertices.data(), staged_indices.data(), index_count, vertex_count );
+	welded_count += vertex_count - unique_count;
+	vertex_count = unique_count;
+
+	/* Ordering - point and line meshes are left as they are */
+	if( options->optimize
+	 && index_count == 3 * (uint32_t)mesh->mNumFaces )
+		{
+		ExportMeshCacheStats mesh_cache;
+		ExportMesh_AnalyzeVertexCache( staged_indices.data(), index_count, vertex_count, &mesh_cache );
+		cache_before.triangle_cnt    += mesh_cache.triangle_cnt;
+		cache_before.vertex_cnt      += mesh_cache.vertex_cnt;
+		cache_before.transformed_cnt += mesh_cache.transformed_cnt;
+
+		ExportMesh_OptimizeVertexCache( staged_indices.data(), index_count, vertex_count );
+		ExportMesh_OptimizeOverdraw( staged_indices.data(), index_count, staged_vertices.data(), vertex_count, EXPORT_MESH_OVERDRAW_THRESHOLD );
+		vertex_count = ExportMesh_OptimizeVertexFetch( staged_vertices.data(), staged_indices.data(), index_count, vertex_count );
+
+		ExportMesh_AnalyzeVertexCache( staged_indices.data(), index_count, vertex_count, &mesh_cache );
+		cache_after.triangle_cnt    += mesh_cache.triangle_cnt;
+		cache_after.vertex_cnt      += mesh_cache.vertex_cnt;
+		cache_after.transformed_cnt += mesh_cache.transformed_cnt;
+		}
+
+	/* Bounds - for culling, and packed vertices are quantized against them */
+	ExportMesh_ComputeBounds( staged_vertices.data(), vertex_count, &mesh_bounds[ i ] );
+
+	/* Levels of detail - each simplified from the full mesh, so errors do not compound */
+	AssetFileModelMeshLod lods[ ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT ];
+	uint32_t lod_count = 0;
+	lod_indices.clear();
+	if( index_count == 3 * (uint32_t)mesh->mNumFaces )
+		{
+		uint32_t previous_count = index_count;
+		float previous_size = FLT_MAX;
+		for( size_t j = 0; j < options->lod_ratios.size() && lod_count < ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT; j++ )
+			{
+			uint32_t target_count = 3 * (uint32_t)( (float)( index_count / 3 ) * options->lod_ratios[ j ] );
+			if( target_count < 3 )
+				{
+				target_count = 3;
+				}
+
+			size_t lod_start = lod_indices.size();
+			lod_indices.resize( lod_start + index_count );
+
+			float error = 0.0f;
+			uint32_t lod_index_count = ExportMesh_Simplify( staged_indices.data(), index_count, staged_vertices.data(), vertex_count, target_count, lod_indices.data() + lod_start, &error );
+			if( lod_index_count == 0
+			 || (float)lod_index_count >= EXPORT_MODEL_LOD_MIN_REDUCTION * (float)previous_count )
+				{
+				lod_indices.resize( lod_start );
+				break;
+				}
+
+			lod_indices.resize( lod_start + lod_index_count );
+			if( options->optimize )
+				{
+				ExportMesh_OptimizeVertexCache( lod_indices.data() + lod_start, lod_index_count, vertex_count );
+				}
+
+			/* largest on-screen diameter at which the error stays under the tolerance */
+			float screen_size = previous_size;
+			if( error > 0.0f )
+				{
+				screen_size = std::min( previous_size, EXPORT_MODEL_LOD_SCREEN_ERROR * 2.0f * mesh_bounds[ i ].radius / error );
+				}
+
+			AssetFileModelMeshLod *lod = &lods[ lod_count++ ];
+			lod->index_offset = index_count + (uint32_t)lod_start;
+			lod->index_count  = lod_index_count;
+			lod->screen_size  = screen_size;
+			lod->error        = error;
+
+			previous_count = lod_index_count;
+			previous_size  = screen_size;
+			}
+		}
+
+	lod_total_count += lod_count;
+
+	AssetFileModelIndexFormat index_format = vertex_count <= 0x10000 ? ASSET_FILE_MODEL_INDEX_FORMAT_U16 : ASSET_FILE_MODEL_INDEX_FORMAT_U32;
+	if( !AssetFile_BeginWritingModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESH, element_count, output )
+	 || !AssetFile_DescribeModelMesh2( map_material_index_to_element_index[ mesh->mMaterialIndex ], vertex_count, index_count, index_format, options->vertex_format, &mesh_bounds[ i ], output )
+	 || !AssetFile_DescribeModelMeshLods( lod_count, lods, output ) )
+		{
+		print_error( "ExportModel_Export() could not start writing new model mesh element (%s).", filename );
+		return( false );
+		}
+
+	if( !AssetFile_WriteModelMeshVertices( staged_vertices.data(), vertex_count, output )
+	 || !AssetFile_WriteModelMeshIndices( staged_indices.data(), index_count, output )
+	 || !AssetFile_WriteModelMeshIndices( lod_indices.data(), (uint32_t)lod_indices.size(), output ) )
+		{
+		print_error( "ExportModel_Export() failed to write mesh data (%s).", filename );
+		return( false );
+		}
+
+	/* Meshlets - point and line meshes get none */
+	if( options->meshlets )
+		{
+		meshlets.clear();
+		meshlet_vertices.clear();
+		meshlet_triangles.clear();
+		if( index_count == 3 * (uint32_t)mesh->mNumFaces )
+			{
+			ExportMesh_BuildMeshlets( staged_indices.data(), index_count, staged_vertices.data(), vertex_count, &meshlets, &meshlet_vertices, &meshlet_triangles );
+			}
+
+		AssetFileModelMeshlets mesh_meshlets = {};
+		mesh_meshlets.meshlet_count  = (uint32_t)meshlets.size();
+		mesh_meshlets.vertex_count   = (uint32_t)meshlet_vertices.size();
+		mesh_meshlets.triangle_count = (uint32_t)meshlet_triangles.size() / 3;
+		mesh_meshlets.meshlets       = meshlets.data();
+		mesh_meshlets.vertices       = meshlet_vertices.data();
+		mesh_meshlets.triangles      = meshlet_triangles.data();
+		if( !AssetFile_BeginWritingModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_MESHLETS, meshlets_element_base + i, output )
+		 || !AssetFile_WriteModelMeshlets( &mesh_meshlets, output ) )
+			{
+			print_error( "ExportModel_Export() failed to write mesh meshlets (%s).", filename );
+			return( false );
 			}
+
+		meshlet_count += mesh_meshlets.meshlet_count;
 		}
 
 	map_mesh_index_to_element_index[ (uint32_t)i ] = element_count;
@@ -321,6 +483,7 @@ for( unsigned int i = 0; i < scene->mNumMeshes; i++ )
 	}
 
 /* Nodes */
+BoundNode( &root_node, &mesh_bounds );
 uint32_t root_node_element_index = {};
 if( !WriteNode( &root_node, element_count++, &map_mesh_index_to_element_index, &element_count, output )
  || !AssetFile_EndWritingModel( root_node_element_index, output ) )
@@ -330,14 +493,33 @@ if( !WriteNode( &root_node, element_count++, &map_mesh_index_to_element_index, &
 	}
 
 stats->nodes_written += node_count;
-size_t write_total_size = AssetFile_GetWriteSize( output ) - write_start_size;
+size_t write_total_size = AssetFile_GetLogicalWriteSize( output ) - write_start_size;
 stats->written_sz += write_total_size;
 
 std::ostringstream os;
 os << "meshes: " << (int)stats->meshes_written
    << ", materials: " << (int)stats->materials_written
    << ", nodes: " << (int)stats->nodes_written
-   << ", " << (int)write_total_size << " bytes";
+   << ", " << (int)write_total_size << " bytes"
+   << ", welded: " << welded_count;
+if( options->meshlets )
+	{
+	os << ", meshlets: " << meshlet_count;
+	}
+
+if( !options->lod_ratios.empty() )
+	{
+	os << ", lods: " << lod_total_count;
+	}
+
+if( cache_before.triangle_cnt > 0 )
+	{
+	os << std::fixed << std::setprecision( 2 )
+	   << ", acmr: " << (float)cache_before.transformed_cnt / (float)cache_before.triangle_cnt
+	   << " -> " << (float)cache_after.transformed_cnt / (float)cache_after.triangle_cnt
+	   << ", atvr: " << (float)cache_before.transformed_cnt / (float)cache_before.vertex_cnt
+	   << " -> " << (float)cache_after.transformed_cnt / (float)cache_after.vertex_cnt;
+	}
 out_strs.push_back( sprint_info( ASSET_STR_FORMAT_STRING, "[MODEL]", strip_filename( filename ).c_str(), os.str().c_str() ) );
 
 return( true );
@@ -345,6 +527,62 @@ return( true );
 } /* ExportModel_Export() */
 
 
+/*******************************************************************
+*
+*   ExportModel_ParseVertexFormat()
+*
+*   DESCRIPTION:
+*       Look up a vertex format by its definition JSON name.
+*
+*******************************************************************/
+
+bool ExportModel_ParseVertexFormat( const char *str, AssetFileModelVertexFormat *format )
+{
+for( int i = 0; i < ASSET_FILE_MODEL_VERTEX_FORMAT_CNT; i++ )
+	{
+	if( strcmp( str, VERTEX_FORMAT_NAMES[ i ] ) == 0 )
+		{
+		*format = (AssetFileModelVertexFormat)i;
+		return( true );
+		}
+	}
+
+return( false );
+
+} /* ExportModel_ParseVertexFormat() */
+
+
+/*******************************************************************
+*
+*   BoundNode()
+*
+*   DESCRIPTION:
+*       Bound the node's meshes and, through their transforms, its
+*       child nodes, so the whole subtree can be culled at once.
+*
+*******************************************************************/
+
+static void BoundNode( LocalNode *node, const std::vector<AssetFileModelBounds> *mesh_bounds )
+{
+node->bounds = {};
+node->bounds.radius = -1.0f;
+for( unsigned int i = 0; i < node->node->mNumMeshes; i++ )
+	{
+	ExportMesh_MergeBounds( &node->bounds, &mesh_bounds->at( node->node->mMeshes[ i ] ), &node->bounds );
+	}
+
+for( LocalNode &child : node->children )
+	{
+	BoundNode( &child, mesh_bounds );
+
+	AssetFileModelBounds child_bounds;
+	ExportMesh_TransformBounds( &child.bounds, child.transform.a, &child_bounds );
+	ExportMesh_MergeBounds( &node->bounds, &child_bounds, &node->bounds );
+	}
+
+}   /* BoundNode() */
+
+
 /*******************************************************************
 *
 *   ParseNode()
@@ -411,7 +649,7 @@ for( unsigned int i = 0; i < node->node->mNumMeshes; i++ )
 	
 /* write this node */
 if( !AssetFile_BeginWritingModelElement( ASSET_FILE_MODEL_ELEMENT_KIND_NODE, element_id, output )
- || !AssetFile_DescribeModelNode( (uint32_t)node->children.size(), node->transform.a, (uint32_t)node->node->mNumMeshes, output ) )
+ || !AssetFile_DescribeModelNode2( (uint32_t)node->children.size(), node->transform.a, (uint32_t)node->node->mNumMeshes, &node->bounds, output ) )
 	{
 	print_error( "ExportModel_Export() could not start writing new model node element." );
 	return( false );
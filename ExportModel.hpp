@@ -1,9 +1,33 @@
 #pragma once
 
 #include <unordered_map>
+#include <vector>
 
 #include "AssetFile.hpp"
 #include "ResourceUtilities.hpp"
 
+#define EXPORT_MODEL_VERSION        ( 7 )
+                                    /* bump when the output changes */
+#define EXPORT_MODEL_LOD_SCREEN_ERROR \
+                                    ( 0.001f )
+                                    /* error per screen height      */
+#define EXPORT_MODEL_LOD_MIN_REDUCTION \
+                                    ( 0.95f )
+                                    /* drop levels that barely help */
 
-bool ExportModel_Export( const AssetFileAssetId id, const char *filename, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output );
\ No newline at end of file
+typedef struct
+    {
+    bool                optimize = true;
+                                    /* reorder for cache/overdraw   */
+    bool                meshlets = false;
+                                    /* add culling clusters         */
+    std::vector<float>  lod_ratios;
+                                    /* triangle fraction per level  */
+    AssetFileModelVertexFormat
+                        vertex_format = ASSET_FILE_MODEL_VERTEX_FORMAT_F32;
+                                    /* stored vertex layout         */
+    } ExportModelOptions;
+
+
+bool ExportModel_Export( const AssetFileAssetId id, const char *filename, const ExportModelOptions *options, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output );
+bool ExportModel_ParseVertexFormat( const char *str, AssetFileModelVertexFormat *format );
\ No newline at end of file
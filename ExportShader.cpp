@@ -48,7 +48,7 @@ if( hr != S_OK )
     return( false );
     }
 
-size_t write_start_size = AssetFile_GetWriteSize( output );
+size_t write_start_size = AssetFile_GetLogicalWriteSize( output );
 if( !AssetFile_BeginWritingAsset( id, ASSET_FILE_ASSET_KIND_SHADER, output ) )
 	{
     byte_code->Release();
@@ -69,7 +69,7 @@ if( !AssetFile_DescribeShader( (uint32_t)byte_code->GetBufferSize(), output )
 byte_code->Release();
 byte_code = NULL;
 
-size_t write_total_size = AssetFile_GetWriteSize( output ) - write_start_size;
+size_t write_total_size = AssetFile_GetLogicalWriteSize( output ) - write_start_size;
 stats->written_sz += write_total_size;
 print_info( "[SHADER]    %s     %d bytes.", strip_filename( filename ).c_str(), (int)write_total_size );
 
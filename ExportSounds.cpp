@@ -185,7 +185,7 @@ if( !AssetFile_BeginWritingAsset( bank_id, kind, output ) )
     return false;
     }
 
-if( !AssetFile_WriteSoundPairs( pairs.data(), (uint16_t)pairs.size(), output ) ) 
+if( !AssetFile_WriteSoundPairs( pairs.data(), (uint32_t)pairs.size(), output ) ) 
     {
     print_error( "ERROR: The Sound bank pair data had an error in AssetFile_WriteSoundPairs. \n" );
     return false;
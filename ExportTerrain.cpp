@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "AssetFile.hpp"
+#include "ExportTerrain.hpp"
+#include "ResourceUtilities.hpp"
+
+#define TILE_EXTENT                 ( ASSET_FILE_TERRAIN_HEIGHT_SAMPLES_EXTENT )
+#define TILE_STEP                   ( TILE_EXTENT - 1 )
+                                    /* neighbours share edge samples*/
+#define LOD_CNT                     ( 5 )
+                                    /* every 1st through 16th sample*/
+
+typedef struct
+    {
+    fhnd                hnd;        /* source heightmap file        */
+    void               *read_hnd;   /* handle file_read_at() uses   */
+    uint32_t            width;      /* samples per source row       */
+    uint32_t            height;     /* source rows                  */
+    uint32_t            used_width; /* leading samples the tiles use*/
+    } TerrainSource;
+
+static void     AddTriangle( const uint32_t a, const uint32_t b, const uint32_t c, std::vector<uint32_t> *indices );
+static void     BuildLodPattern( const uint32_t step, std::vector<uint32_t> *indices );
+static void     CutTile( const uint16_t *band, const uint32_t used_width, const uint32_t tile_x, uint16_t *out );
+static bool     ReadBand( const TerrainSource *source, const uint32_t tile_z, uint16_t *out );
+
+
+/*******************************************************************
+*
+*   ExportTerrain_Export()
+*
+*   DESCRIPTION:
+*       Slice a raw 16-bit little-endian heightmap into the terrain
+*       tile grid.  The source is streamed one band of tile rows at
+*       a time, with the next band read while the threads cut the
+*       current one, so memory stays bounded by the source width
+*       however tall the heightmap is.  Samples past the source edge
+*       repeat the last row or column.  The threads also build each
+*       tile's min/max pyramid, and compress the tiles when the
+*       output compresses its assets.  The LOD index patterns are the
+*       same for every tile, so they are written once.
+*
+*******************************************************************/
+
+bool ExportTerrain_Export( const AssetFileAssetId id, const char *filename, const ExportTerrainOptions *options, const unsigned int thread_count, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output )
+{
+*stats = {};
+size_t write_start_size = AssetFile_GetLogicalWriteSize( output );
+
+FileInfo info = {};
+if( options->width == 0
+ || options->height == 0
+ || !get_file_info( filename, &info )
+ || info.size < (uint64_t)options->width * options->height * sizeof( uint16_t ) )
+    {
+    print_error( "ExportTerrain_Export() heightmap is smaller than its %ux%u definition (%s).", options->width, options->height, filename );
+    return( false );
+    }
+
+uint32_t tiles_x = std::min<uint32_t>( std::max<uint32_t>( ( options->width - 1 + TILE_STEP - 1 ) / TILE_STEP, 1 ), ASSET_FILE_TERRAIN_AXES_CNT );
+uint32_t tiles_z = std::min<uint32_t>( std::max<uint32_t>( ( options->height - 1 + TILE_STEP - 1 ) / TILE_STEP, 1 ), ASSET_FILE_TERRAIN_AXES_CNT );
+if( (uint64_t)tiles_x * TILE_STEP + 1 < options->width
+ || (uint64_t)tiles_z * TILE_STEP + 1 < options->height )
+    {
+    print_warning( "ExportTerrain_Export() heightmap is larger than the terrain grid, and will be cropped (%s).", filename );
+    }
+
+TerrainSource source = {};
+source.width      = options->width;
+source.height     = options->height;
+source.used_width = std::min<uint32_t>( options->width, tiles_x * TILE_STEP + 1 );
+if( !file_open( filename, "rb", &source.hnd ) )
+    {
+    print_error( "ExportTerrain_Export() could not open heightmap (%s).", filename );
+    return( false );
+    }
+
+if( !file_open_read_at( filename, &source.read_hnd ) )
+    {
+    file_close( source.hnd );
+    print_error( "ExportTerrain_Export() could not open heightmap (%s).", filename );
+    return( false );
+    }
+
+bool lods_written = AssetFile_BeginWritingAsset( id, ASSET_FILE_ASSET_KIND_TERRAIN, output )
+                 && AssetFile_DescribeTerrain( output );
+for( uint32_t i = 0; lods_written && i < LOD_CNT; i++ )
+    {
+    std::vector<uint32_t> indices;
+    BuildLodPattern( 1u << i, &indices );
+    lods_written = AssetFile_WriteTerrainLod( 1u << i, (uint32_t)indices.size(), indices.data(), output );
+    }
+
+if( !lods_written )
+    {
+    file_close_read_at( source.read_hnd );
+    file_close( source.hnd );
+    print_error( "ExportTerrain_Export() could not begin writing asset.  Reason: Asset was not in file table (%s).", filename );
+    return( false );
+    }
+
+/* two bands, one being cut while the other is read */
+size_t band_cnt = (size_t)TILE_EXTENT * source.used_width;
+std::vector<uint16_t> bands[ 2 ];
+bands[ 0 ].resize( band_cnt );
+bands[ 1 ].resize( band_cnt );
+std::vector<uint16_t> tiles( (size_t)tiles_x * ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT );
+
+const uint32_t raw_sz = ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT * sizeof( uint16_t );
+bool compress = output->codec != ASSET_FILE_CODEC_NONE;
+std::vector<byte> compressed( compress ? (size_t)tiles_x * raw_sz : 0 );
+std::vector<uint32_t> compressed_szs( tiles_x );
+std::vector<AssetFileTerrainMinMax> min_maxes( (size_t)tiles_x * ASSET_FILE_TERRAIN_MINMAX_CNT );
+
+unsigned int worker_cnt = std::min( std::max( thread_count, 1u ), tiles_x );
+bool success = ReadBand( &source, 0, bands[ 0 ].data() );
+for( uint32_t z = 0; success && z < tiles_z; z++ )
+    {
+    const uint16_t *band = bands[ z & 1 ].data();
+    bool next_read = true;
+    std::thread reader;
+    if( z + 1 < tiles_z )
+        {
+        reader = std::thread( [&]{ next_read = ReadBand( &source, z + 1, bands[ ( z + 1 ) & 1 ].data() ); } );
+        }
+
+    std::atomic<uint32_t> next_tile( 0 );
+    auto cutter = [&]()
+        {
+        for( uint32_t x = next_tile++; x < tiles_x; x = next_tile++ )
+            {
+            uint16_t *tile = &tiles[ (size_t)x * ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT ];
+            CutTile( band, source.used_width, x, tile );
+            AssetFile_BuildTerrainMinMax( tile, &min_maxes[ (size_t)x * ASSET_FILE_TERRAIN_MINMAX_CNT ] );
+
+            /* zero keeps the raw samples, for tiles that would not shrink */
+            compressed_szs[ x ] = 0;
+            if( compress
+             && !AssetFile_CompressTerrainTile( tile, raw_sz, &compressed_szs[ x ], &compressed[ (size_t)x * raw_sz ] ) )
+                {
+                compressed_szs[ x ] = 0;
+                }
+            }
+        };
+
+    std::vector<std::thread> workers;
+    for( unsigned int i = 1; i < worker_cnt; i++ )
+        {
+        workers.emplace_back( cutter );
+        }
+
+    cutter();
+    for( std::thread &worker : workers )
+        {
+        worker.join();
+        }
+
+    if( reader.joinable() )
+        {
+        reader.join();
+        }
+
+    for( uint32_t x = 0; success && x < tiles_x; x++ )
+        {
+        const AssetFileTerrainMinMax *min_max = &min_maxes[ (size_t)x * ASSET_FILE_TERRAIN_MINMAX_CNT ];
+        if( compressed_szs[ x ] )
+            {
+            success = AssetFile_WriteTerrainTileCompressed( x, z, min_max, compressed_szs[ x ], &compressed[ (size_t)x * raw_sz ], output );
+            }
+        else
+            {
+            success = AssetFile_WriteTerrainTile2( x, z, min_max, &tiles[ (size_t)x * ASSET_FILE_TERRAIN_TILE_SAMPLE_CNT ], output );
+            }
+        }
+
+    success = success && next_read;
+    }
+
+file_close_read_at( source.read_hnd );
+file_close( source.hnd );
+if( !success
+ || !AssetFile_EndWritingAsset( output ) )
+    {
+    print_error( "ExportTerrain_Export() failed to write terrain tiles (%s).", filename );
+    return( false );
+    }
+
+size_t write_total_size = AssetFile_GetLogicalWriteSize( output ) - write_start_size;
+stats->written_sz += write_total_size;
+
+std::ostringstream os;
+os << "tiles: " << tiles_x << "x" << tiles_z
+   << ", lods: " << LOD_CNT
+   << ", " << (uint64_t)write_total_size << " bytes";
+out_strs.push_back( sprint_info( ASSET_STR_FORMAT_STRING, "[TERRAIN]", strip_filename( filename ).c_str(), os.str().c_str() ) );
+
+return( true );
+
+} /* ExportTerrain_Export() */
+
+
+/*******************************************************************
+*
+*   AddTriangle()
+*
+*   DESCRIPTION:
+*       Add a triangle of tile sample indices, wound counter-clockwise
+*       seen from above, with +y up.
+*
+*******************************************************************/
+
+static void AddTriangle( const uint32_t a, const uint32_t b, const uint32_t c, std::vector<uint32_t> *indices )
+{
+int64_t ax = a % TILE_EXTENT, az = a / TILE_EXTENT;
+int64_t bx = b % TILE_EXTENT, bz = b / TILE_EXTENT;
+int64_t cx = c % TILE_EXTENT, cz = c / TILE_EXTENT;
+bool is_ccw = ( bz - az ) * ( cx - ax ) - ( bx - ax ) * ( cz - az ) > 0;
+
+indices->push_back( a );
+indices->push_back( is_ccw ? b : c );
+indices->push_back( is_ccw ? c : b );
+
+} /* AddTriangle() */
+
+
+/*******************************************************************
+*
+*   BuildLodPattern()
+*
+*   DESCRIPTION:
+*       Build the index pattern which uses every step'th sample.
+*       Cells on the tile edge keep every edge sample, fanned from
+*       the cell center, so the pattern meets any neighbour's.
+*
+*******************************************************************/
+
+static void BuildLodPattern( const uint32_t step, std::vector<uint32_t> *indices )
+{
+indices->clear();
+for( uint32_t z0 = 0; z0 < TILE_STEP; z0 += step )
+    {
+    for( uint32_t x0 = 0; x0 < TILE_STEP; x0 += step )
+        {
+        uint32_t x1 = x0 + step;
+        uint32_t z1 = z0 + step;
+        if( step == 1
+         || ( x0 > 0 && z0 > 0 && x1 < TILE_STEP && z1 < TILE_STEP ) )
+            {
+            AddTriangle( z0 * TILE_EXTENT + x0, z1 * TILE_EXTENT + x0, z0 * TILE_EXTENT + x1, indices );
+            AddTriangle( z0 * TILE_EXTENT + x1, z1 * TILE_EXTENT + x0, z1 * TILE_EXTENT + x1, indices );
+            continue;
+            }
+
+        /* walk the cell's edges, one sample at a time along the tile edge */
+        uint32_t center = ( z0 + step / 2 ) * TILE_EXTENT + x0 + step / 2;
+        uint32_t corners[ 5 ][ 2 ] = { { x0, z0 }, { x1, z0 }, { x1, z1 }, { x0, z1 }, { x0, z0 } };
+        for( uint32_t side = 0; side < 4; side++ )
+            {
+            uint32_t from_x = corners[ side ][ 0 ], from_z = corners[ side ][ 1 ];
+            uint32_t to_x = corners[ side + 1 ][ 0 ], to_z = corners[ side + 1 ][ 1 ];
+            bool on_edge = ( from_x == to_x && ( from_x == 0 || from_x == TILE_STEP ) )
+                        || ( from_z == to_z && ( from_z == 0 || from_z == TILE_STEP ) );
+            uint32_t segments = on_edge ? step : 1;
+            int32_t delta = ( ( (int32_t)to_z - (int32_t)from_z ) * TILE_EXTENT + (int32_t)to_x - (int32_t)from_x ) / (int32_t)segments;
+            uint32_t a = from_z * TILE_EXTENT + from_x;
+            for( uint32_t i = 0; i < segments; i++, a += delta )
+                {
+                AddTriangle( center, a, a + delta, indices );
+                }
+            }
+        }
+    }
+
+} /* BuildLodPattern() */
+
+
+/*******************************************************************
+*
+*   CutTile()
+*
+*   DESCRIPTION:
+*       Copy one tile's samples out of its band, repeating the last
+*       column where the tile runs past the source.
+*
+*******************************************************************/
+
+static void CutTile( const uint16_t *band, const uint32_t used_width, const uint32_t tile_x, uint16_t *out )
+{
+uint32_t first = tile_x * TILE_STEP;
+uint32_t inside = std::min<uint32_t>( used_width - first, TILE_EXTENT );
+for( uint32_t row = 0; row < TILE_EXTENT; row++ )
+    {
+    const uint16_t *src = &band[ (size_t)row * used_width + first ];
+    uint16_t *dst = &out[ row * TILE_EXTENT ];
+    memcpy( dst, src, inside * sizeof( *dst ) );
+    std::fill( dst + inside, dst + TILE_EXTENT, src[ inside - 1 ] );
+    }
+
+} /* CutTile() */
+
+
+/*******************************************************************
+*
+*   ReadBand()
+*
+*   DESCRIPTION:
+*       Read the source rows under one row of tiles, repeating the
+*       last row where the band runs past the source.
+*
+*******************************************************************/
+
+static bool ReadBand( const TerrainSource *source, const uint32_t tile_z, uint16_t *out )
+{
+uint32_t first_row = tile_z * TILE_STEP;
+uint32_t inside = std::min<uint32_t>( source->height - first_row, TILE_EXTENT );
+size_t row_sz = (size_t)source->used_width * sizeof( *out );
+
+/* whole rows are contiguous in the source, so read them together */
+if( source->used_width == source->width )
+    {
+    if( !file_read_at( source->hnd, source->read_hnd, (uint64_t)first_row * row_sz, (uint64_t)inside * row_sz, out ) )
+        {
+        return( false );
+        }
+    }
+else
+    {
+    for( uint32_t row = 0; row < inside; row++ )
+        {
+        uint64_t location = (uint64_t)( first_row + row ) * source->width * sizeof( *out );
+        if( !file_read_at( source->hnd, source->read_hnd, location, row_sz, &out[ (size_t)row * source->used_width ] ) )
+            {
+            return( false );
+            }
+        }
+    }
+
+for( uint32_t row = inside; row < TILE_EXTENT; row++ )
+    {
+    memcpy( &out[ (size_t)row * source->used_width ], &out[ (size_t)( inside - 1 ) * source->used_width ], row_sz );
+    }
+
+return( true );
+
+} /* ReadBand() */
@@ -0,0 +1,15 @@
+#pragma once
+#include "AssetFile.hpp"
+#include "ResourceUtilities.hpp"
+
+#define EXPORT_TERRAIN_VERSION      ( 3 )
+                                    /* bump when the output changes */
+
+typedef struct
+    {
+    uint32_t            width = 0;  /* source samples per row       */
+    uint32_t            height = 0; /* source rows                  */
+    } ExportTerrainOptions;
+
+
+bool ExportTerrain_Export( const AssetFileAssetId id, const char *filename, const ExportTerrainOptions *options, const unsigned int thread_count, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output );
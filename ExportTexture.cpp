@@ -1,3 +1,9 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #define STB_IMAGE_WRITE_IMPLEMENTATION
@@ -7,20 +13,85 @@
 #include "ExportTexture.hpp"
 #include "ResourceUtilities.hpp"
 
+#if defined( __SSE2__ ) || defined( _M_X64 )
+#define EXPORT_TEXTURE_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#define BLOCK_EXTENT                ( 4 )
+#define BLOCK_TEXEL_CNT             ( BLOCK_EXTENT * BLOCK_EXTENT )
+#define BC4_BLOCK_SZ                ( 8 )
+#define ENDPOINT_REFINE_CNT         ( 2 )
+                                    /* least squares endpoint passes*/
+#define PRINCIPAL_AXIS_ITERATION_CNT \
+                                    ( 8 )
+
+#define IS_COLOR_CHANNEL( _c, _cnt ) \
+                                    ( ( _cnt ) <= 2 ? ( _c ) == 0 : ( _c ) < 3 )
+                                    /* grey/alpha or RGB(A) layout  */
+
+typedef struct
+    {
+    const char         *name;       /* definition JSON format string*/
+    uint32_t            block_sz;   /* bytes per 4x4 block          */
+    uint32_t            channel_cnt;/* channels after GPU decode    */
+    } TextureFormatInfo;
+
+typedef struct
+    {
+    float               channels[ 4 ][ BLOCK_TEXEL_CNT ];
+                                    /* RGBA planes, 0..255          */
+    } TexelBlock;
+
+static const TextureFormatInfo FORMAT_INFO[ ASSET_FILE_TEXTURE_FORMAT_CNT ] =
+    {
+    { "raw", 0,  0 },
+    { "bc1", 8,  4 },
+    { "bc3", 16, 4 },
+    { "bc4", 8,  1 },
+    { "bc5", 16, 2 },
+    { "bc7", 16, 4 }
+    };
+
+static const float BC1_WEIGHTS[ 4 ] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+static const int   BC7_WEIGHTS[ 16 ] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static void     DownsampleRows( const float *row0, const float *row1, const int width, const int channel_count, float *out );
+static void     EncodeBC1Block( const TexelBlock *block, uint8_t *out );
+static void     EncodeBC4Block( const TexelBlock *block, const int channel, uint8_t *out );
+static void     EncodeBC7Block( const TexelBlock *block, uint8_t *out );
+static void     EncodeBlocks( const AssetFileTextureFormat format, const uint8_t *rgba, const int width, const int height, uint8_t *out );
+static void     ExpandToRGBA8( const AssetFileTextureFormat format, const unsigned char *image, const int width, const int height, const int channel_count, const uint8_t channel_width, uint8_t *out );
+static void     FindEndpoints( const TexelBlock *block, const int channel_cnt, float *e0, float *e1 );
+static bool     FitEndpoints( const TexelBlock *block, const int channel_cnt, const float *weights, const uint8_t *indices, float *e0, float *e1 );
+static void     GetBlock( const uint8_t *rgba, const int width, const int height, const int block_x, const int block_y, TexelBlock *block );
+static uint32_t GetLevelByteSize( const AssetFileTextureFormat format, const int width, const int height, const int channel_count, const uint8_t channel_width );
+static float    LinearToSRGB( const float value );
+static void     LinearToTexels( const float *linear, const int texel_cnt, const int channel_count, const uint8_t channel_width, const bool is_linear_data, uint8_t *out );
+static uint16_t PackRGB565( const float *color );
+static float    PickIndices( const TexelBlock *block, const int channel_cnt, const float ( *palette )[ 4 ], const int palette_cnt, uint8_t *indices );
+static float    PickRampIndices( const TexelBlock *block, const int channel_cnt, const float ( *palette )[ 4 ], const int palette_cnt, uint8_t *indices );
+static float    SRGBToLinear( const float value );
+static void     TexelsToLinear( const uint8_t *texels, const int texel_cnt, const int channel_count, const uint8_t channel_width, const bool is_linear_data, float *out );
+static void     UnpackRGB565( const uint16_t color, float *out );
+static void     WriteBits( const uint32_t value, const int bit_cnt, int *bit_pos, uint8_t *out );
+static bool     WriteLevel( const AssetFileTextureFormat format, const uint8_t *texels, const int width, const int height, const int channel_count, const uint8_t channel_width, AssetFileWriter *output );
+
 
 /*******************************************************************
 *
 *   ExportTexture_Export()
 *
 *   DESCRIPTION:
-*       Load the given texture by filename.
+*       Load the given texture by filename, build its mip chain and
+*       encode every level into the requested pixel format.
 *
 *******************************************************************/
 
-bool ExportTexture_Export( const AssetFileAssetId id, const char *filename, AssetIdToExtentMap &extent_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output )
+bool ExportTexture_Export( const AssetFileAssetId id, const char *filename, const AssetFileTextureFormat format, const bool has_mips, const bool is_srgb, AssetIdToExtentMap &extent_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output )
 {
 *stats = {};
-size_t write_start_size = AssetFile_GetWriteSize( output );
+size_t write_start_size = AssetFile_GetLogicalWriteSize( output );
 int width = {};
 int height = {};
 int channel_count = {};
@@ -82,20 +153,92 @@ if( !AssetFile_BeginWritingAsset( id, ASSET_FILE_ASSET_KIND_TEXTURE, output ) )
     return( false );
     }
 
-int pixels_length = width * height * channel_count * channel_width;
-if( !AssetFile_DescribeTexture2( channel_count, channel_width, width, height, pixels_length, output )
- || !AssetFile_WriteTexture( image, pixels_length, output ) )
+int mip_cnt = 1;
+while( has_mips
+    && mip_cnt < ASSET_FILE_TEXTURE_MAX_MIP_CNT
+    && ( ( width >> mip_cnt ) || ( height >> mip_cnt ) ) )
+    {
+    mip_cnt++;
+    }
+
+/* block formats store their own channel layout */
+int stored_channel_count = channel_count;
+int stored_channel_width = channel_width;
+if( format != ASSET_FILE_TEXTURE_FORMAT_RAW )
+    {
+    stored_channel_count = (int)FORMAT_INFO[ format ].channel_cnt;
+    stored_channel_width = 1;
+    }
+
+bool success = AssetFile_DescribeTexture2( format, stored_channel_count, stored_channel_width, width, height, GetLevelByteSize( format, width, height, channel_count, channel_width ), output )
+            && WriteLevel( format, image, width, height, channel_count, channel_width, output );
+
+/* filter each level from the one above in linear light, starting from the source image */
+bool is_linear_data = !is_srgb
+                   || format == ASSET_FILE_TEXTURE_FORMAT_BC4
+                   || format == ASSET_FILE_TEXTURE_FORMAT_BC5;
+int level_width = width;
+int level_height = height;
+std::vector<float> level;
+std::vector<float> source_rows;
+std::vector<uint8_t> level_texels;
+for( int mip = 1; success && mip < mip_cnt; mip++ )
+    {
+    int next_width = std::max( level_width >> 1, 1 );
+    int next_height = std::max( level_height >> 1, 1 );
+    size_t row_floats = (size_t)level_width * channel_count;
+    std::vector<float> next( (size_t)next_width * next_height * channel_count );
+    for( int y = 0; y < next_height; y++ )
+        {
+        int y0 = std::min( 2 * y, level_height - 1 );
+        int y1 = std::min( 2 * y + 1, level_height - 1 );
+        float *dst = &next[ (size_t)y * next_width * channel_count ];
+        if( mip == 1 )
+            {
+            size_t row_bytes = (size_t)level_width * channel_count * channel_width;
+            source_rows.resize( 2 * row_floats );
+            TexelsToLinear( &image[ y0 * row_bytes ], level_width, channel_count, channel_width, is_linear_data, &source_rows[ 0 ] );
+            TexelsToLinear( &image[ y1 * row_bytes ], level_width, channel_count, channel_width, is_linear_data, &source_rows[ row_floats ] );
+            DownsampleRows( &source_rows[ 0 ], &source_rows[ row_floats ], level_width, channel_count, dst );
+            }
+        else
+            {
+            DownsampleRows( &level[ y0 * row_floats ], &level[ y1 * row_floats ], level_width, channel_count, dst );
+            }
+        }
+
+    level.swap( next );
+    level_width = next_width;
+    level_height = next_height;
+
+    level_texels.resize( (size_t)level_width * level_height * channel_count * channel_width );
+    LinearToTexels( level.data(), level_width * level_height, channel_count, channel_width, is_linear_data, level_texels.data() );
+    success = WriteLevel( format, level_texels.data(), level_width, level_height, channel_count, channel_width, output );
+    }
+
+stbi_image_free( image );
+if( !success
+ || !AssetFile_EndWritingAsset( output ) )
     {
     print_error( "ExportTexture_Export could not write texture asset header to binary (%s).", filename );
     return( false );
     }
 
-
-size_t write_total_size = AssetFile_GetWriteSize( output ) - write_start_size;
+size_t write_total_size = AssetFile_GetLogicalWriteSize( output ) - write_start_size;
 stats->written_sz += write_total_size;
 
 std::ostringstream os;
 os << (int)write_total_size << " bytes";
+if( format != ASSET_FILE_TEXTURE_FORMAT_RAW )
+    {
+    os << ", " << FORMAT_INFO[ format ].name;
+    }
+
+if( mip_cnt > 1 )
+    {
+    os << ", " << mip_cnt << " mips";
+    }
+
 out_strs.push_back( sprint_info( ASSET_STR_FORMAT_STRING, "[TEXTURE]", strip_filename( filename ).c_str(), os.str().c_str() ) );
 
 return( true );
@@ -103,6 +246,31 @@ return( true );
 } /* ExportTexture_Export() */
 
 
+/*******************************************************************
+*
+*   ExportTexture_ParseFormat()
+*
+*   DESCRIPTION:
+*       Look up a texture format by its definition JSON name.
+*
+*******************************************************************/
+
+bool ExportTexture_ParseFormat( const char *str, AssetFileTextureFormat *format )
+{
+for( int i = 0; i < ASSET_FILE_TEXTURE_FORMAT_CNT; i++ )
+    {
+    if( strcmp( str, FORMAT_INFO[ i ].name ) == 0 )
+        {
+        *format = (AssetFileTextureFormat)i;
+        return( true );
+        }
+    }
+
+return( false );
+
+} /* ExportTexture_ParseFormat() */
+
+
 /*******************************************************************
 *
 *   ExportTexture_WriteTextureExtents()
@@ -140,3 +308,1070 @@ if( !AssetFile_EndWritingAsset( output ) )
 return( true );
 
 }   /* ExportTexture_WriteTextureExtents() */
+
+
+/*******************************************************************
+*
+*   DownsampleRows()
+*
+*   DESCRIPTION:
+*       2x2 box filter a pair of linear rows into one row of half the
+*       width.  An odd last column is folded into its neighbour.
+*
+*******************************************************************/
+
+static void DownsampleRows( const float *row0, const float *row1, const int width, const int channel_count, float *out )
+{
+int out_width = std::max( width >> 1, 1 );
+int x = 0;
+#if defined( EXPORT_TEXTURE_USE_SSE2 )
+/* four output floats from eight input floats of each row, while both texels of every pair exist */
+if( channel_count != 3 )
+    {
+    const __m128 quarter = _mm_set1_ps( 0.25f );
+    int pair_floats = ( width >> 1 ) * channel_count;
+    int i = 0;
+    for( ; i + 4 <= pair_floats; i += 4 )
+        {
+        __m128 lo = _mm_add_ps( _mm_loadu_ps( &row0[ 2 * i ] ), _mm_loadu_ps( &row1[ 2 * i ] ) );
+        __m128 hi = _mm_add_ps( _mm_loadu_ps( &row0[ 2 * i + 4 ] ), _mm_loadu_ps( &row1[ 2 * i + 4 ] ) );
+        __m128 sum;
+        if( channel_count == 1 )
+            {
+            sum = _mm_add_ps( _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 2, 0, 2, 0 ) ), _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 1, 3, 1 ) ) );
+            }
+        else if( channel_count == 2 )
+            {
+            sum = _mm_add_ps( _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 1, 0, 1, 0 ) ), _mm_shuffle_ps( lo, hi, _MM_SHUFFLE( 3, 2, 3, 2 ) ) );
+            }
+        else
+            {
+            sum = _mm_add_ps( lo, hi );
+            }
+
+        _mm_storeu_ps( &out[ i ], _mm_mul_ps( sum, quarter ) );
+        }
+
+    x = i / channel_count;
+    }
+else
+    {
+    /* RGB texels load four floats at a time, and the spare lane each store writes is
+       overwritten by the next texel; the last texel is left to the scalar loop */
+    const __m128 quarter = _mm_set1_ps( 0.25f );
+    for( ; x + 1 < out_width; x++ )
+        {
+        __m128 left = _mm_add_ps( _mm_loadu_ps( &row0[ 6 * x ] ), _mm_loadu_ps( &row1[ 6 * x ] ) );
+        __m128 right = _mm_add_ps( _mm_loadu_ps( &row0[ 6 * x + 3 ] ), _mm_loadu_ps( &row1[ 6 * x + 3 ] ) );
+        _mm_storeu_ps( &out[ 3 * x ], _mm_mul_ps( _mm_add_ps( left, right ), quarter ) );
+        }
+    }
+#endif
+
+for( ; x < out_width; x++ )
+    {
+    const float *a0 = &row0[ std::min( 2 * x, width - 1 ) * channel_count ];
+    const float *a1 = &row0[ std::min( 2 * x + 1, width - 1 ) * channel_count ];
+    const float *b0 = &row1[ std::min( 2 * x, width - 1 ) * channel_count ];
+    const float *b1 = &row1[ std::min( 2 * x + 1, width - 1 ) * channel_count ];
+    for( int c = 0; c < channel_count; c++ )
+        {
+        out[ x * channel_count + c ] = 0.25f * ( ( a0[ c ] + b0[ c ] ) + ( a1[ c ] + b1[ c ] ) );
+        }
+    }
+
+} /* DownsampleRows() */
+
+
+/*******************************************************************
+*
+*   EncodeBC1Block()
+*
+*   DESCRIPTION:
+*       Encode the block as two RGB565 endpoints and 2-bit indices,
+*       always in four color mode.
+*
+*******************************************************************/
+
+static void EncodeBC1Block( const TexelBlock *block, uint8_t *out )
+{
+float e0[ 4 ] = {};
+float e1[ 4 ] = {};
+FindEndpoints( block, 3, e0, e1 );
+
+float best_error = FLT_MAX;
+uint16_t best_colors[ 2 ] = {};
+uint8_t best_indices[ BLOCK_TEXEL_CNT ] = {};
+for( int pass = 0; pass <= ENDPOINT_REFINE_CNT; pass++ )
+    {
+    /* color0 > color1 selects four color mode, and equal endpoints mean every index must be 0 */
+    uint16_t c0 = PackRGB565( e0 );
+    uint16_t c1 = PackRGB565( e1 );
+    if( c0 < c1 )
+        {
+        std::swap( c0, c1 );
+        std::swap( e0, e1 );
+        }
+
+    float palette[ 4 ][ 4 ] = {};
+    UnpackRGB565( c0, palette[ 0 ] );
+    UnpackRGB565( c1, palette[ 1 ] );
+    for( int c = 0; c < 3; c++ )
+        {
+        palette[ 2 ][ c ] = c0 == c1 ? palette[ 0 ][ c ] : ( 2.0f * palette[ 0 ][ c ] + palette[ 1 ][ c ] ) / 3.0f;
+        palette[ 3 ][ c ] = c0 == c1 ? palette[ 0 ][ c ] : ( palette[ 0 ][ c ] + 2.0f * palette[ 1 ][ c ] ) / 3.0f;
+        }
+
+    uint8_t indices[ BLOCK_TEXEL_CNT ];
+    float error = PickIndices( block, 3, palette, 4, indices );
+    if( c0 == c1 )
+        {
+        memset( indices, 0, sizeof( indices ) );
+        }
+
+    if( error < best_error )
+        {
+        best_error = error;
+        best_colors[ 0 ] = c0;
+        best_colors[ 1 ] = c1;
+        memcpy( best_indices, indices, sizeof( best_indices ) );
+        }
+
+    if( error == 0.0f
+     || !FitEndpoints( block, 3, BC1_WEIGHTS, indices, e0, e1 ) )
+        {
+        break;
+        }
+    }
+
+out[ 0 ] = (uint8_t)( best_colors[ 0 ] & 0xff );
+out[ 1 ] = (uint8_t)( best_colors[ 0 ] >> 8 );
+out[ 2 ] = (uint8_t)( best_colors[ 1 ] & 0xff );
+out[ 3 ] = (uint8_t)( best_colors[ 1 ] >> 8 );
+
+int bit_pos = 32;
+memset( &out[ 4 ], 0, 4 );
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    WriteBits( best_indices[ i ], 2, &bit_pos, out );
+    }
+
+} /* EncodeBC1Block() */
+
+
+/*******************************************************************
+*
+*   EncodeBC4Block()
+*
+*   DESCRIPTION:
+*       Encode one channel of the block as two 8-bit endpoints and
+*       3-bit indices into the eight value ramp between them.
+*
+*******************************************************************/
+
+static void EncodeBC4Block( const TexelBlock *block, const int channel, uint8_t *out )
+{
+const float *values = block->channels[ channel ];
+float lo = values[ 0 ];
+float hi = values[ 0 ];
+for( int i = 1; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    lo = std::min( lo, values[ i ] );
+    hi = std::max( hi, values[ i ] );
+    }
+
+int a0 = (int)hi;
+int a1 = (int)lo;
+
+/* a0 > a1 selects the eight value ramp, entries 2..7 step from a0 towards a1 */
+float palette[ 8 ][ 4 ] = {};
+palette[ 0 ][ 0 ] = (float)a0;
+palette[ 1 ][ 0 ] = (float)a1;
+for( int i = 2; i < 8; i++ )
+    {
+    palette[ i ][ 0 ] = a0 == a1 ? (float)a0 : (float)( ( 8 - i ) * a0 + ( i - 1 ) * a1 ) / 7.0f;
+    }
+
+TexelBlock single = {};
+memcpy( single.channels[ 0 ], values, sizeof( single.channels[ 0 ] ) );
+
+uint8_t indices[ BLOCK_TEXEL_CNT ];
+PickIndices( &single, 1, palette, 8, indices );
+
+out[ 0 ] = (uint8_t)a0;
+out[ 1 ] = (uint8_t)a1;
+
+int bit_pos = 16;
+memset( &out[ 2 ], 0, BC4_BLOCK_SZ - 2 );
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    WriteBits( indices[ i ], 3, &bit_pos, out );
+    }
+
+} /* EncodeBC4Block() */
+
+
+/*******************************************************************
+*
+*   EncodeBC7Block()
+*
+*   DESCRIPTION:
+*       Encode the block in BC7 mode 6: a single subset with RGBA
+*       7.7.7.7 endpoints, a p-bit per endpoint and 4-bit indices.
+*
+*******************************************************************/
+
+static void EncodeBC7Block( const TexelBlock *block, uint8_t *out )
+{
+float e0[ 4 ] = {};
+float e1[ 4 ] = {};
+FindEndpoints( block, 4, e0, e1 );
+
+float weights[ 16 ];
+for( int i = 0; i < 16; i++ )
+    {
+    weights[ i ] = (float)BC7_WEIGHTS[ i ] / 64.0f;
+    }
+
+float best_error = FLT_MAX;
+int best_endpoints[ 2 ][ 4 ] = {};
+int best_pbits[ 2 ] = {};
+uint8_t best_indices[ BLOCK_TEXEL_CNT ] = {};
+for( int pass = 0; pass <= ENDPOINT_REFINE_CNT; pass++ )
+    {
+    /* quantize each endpoint to 7 bits, choosing the shared p-bit that lands closest */
+    int endpoints[ 2 ][ 4 ] = {};
+    int pbits[ 2 ] = {};
+    const float *ends[ 2 ] = { e0, e1 };
+    for( int e = 0; e < 2; e++ )
+        {
+        float pbit_error = FLT_MAX;
+        for( int p = 0; p < 2; p++ )
+            {
+            int quantized[ 4 ];
+            float error = 0.0f;
+            for( int c = 0; c < 4; c++ )
+                {
+                quantized[ c ] = std::clamp( (int)( ( ends[ e ][ c ] - (float)p ) / 2.0f + 0.5f ), 0, 127 );
+                float diff = (float)( ( quantized[ c ] << 1 ) | p ) - ends[ e ][ c ];
+                error += diff * diff;
+                }
+
+            if( error < pbit_error )
+                {
+                pbit_error = error;
+                pbits[ e ] = p;
+                memcpy( endpoints[ e ], quantized, sizeof( quantized ) );
+                }
+            }
+        }
+
+    float palette[ 16 ][ 4 ];
+    for( int i = 0; i < 16; i++ )
+        {
+        for( int c = 0; c < 4; c++ )
+            {
+            int v0 = ( endpoints[ 0 ][ c ] << 1 ) | pbits[ 0 ];
+            int v1 = ( endpoints[ 1 ][ c ] << 1 ) | pbits[ 1 ];
+            palette[ i ][ c ] = (float)( ( ( 64 - BC7_WEIGHTS[ i ] ) * v0 + BC7_WEIGHTS[ i ] * v1 + 32 ) >> 6 );
+            }
+        }
+
+    uint8_t indices[ BLOCK_TEXEL_CNT ];
+    float error = PickRampIndices( block, 4, palette, 16, indices );
+    if( error < best_error )
+        {
+        best_error = error;
+        memcpy( best_endpoints, endpoints, sizeof( best_endpoints ) );
+        memcpy( best_pbits, pbits, sizeof( best_pbits ) );
+        memcpy( best_indices, indices, sizeof( best_indices ) );
+        }
+
+    if( error == 0.0f
+     || !FitEndpoints( block, 4, weights, indices, e0, e1 ) )
+        {
+        break;
+        }
+    }
+
+/* the first index is stored without its high bit, so flip the ramp if it is set */
+if( best_indices[ 0 ] & 8 )
+    {
+    for( int c = 0; c < 4; c++ )
+        {
+        std::swap( best_endpoints[ 0 ][ c ], best_endpoints[ 1 ][ c ] );
+        }
+
+    std::swap( best_pbits[ 0 ], best_pbits[ 1 ] );
+    for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+        {
+        best_indices[ i ] = (uint8_t)( 15 - best_indices[ i ] );
+        }
+    }
+
+memset( out, 0, FORMAT_INFO[ ASSET_FILE_TEXTURE_FORMAT_BC7 ].block_sz );
+int bit_pos = 0;
+WriteBits( 1 << 6, 7, &bit_pos, out );
+for( int c = 0; c < 4; c++ )
+    {
+    WriteBits( best_endpoints[ 0 ][ c ], 7, &bit_pos, out );
+    WriteBits( best_endpoints[ 1 ][ c ], 7, &bit_pos, out );
+    }
+
+WriteBits( best_pbits[ 0 ], 1, &bit_pos, out );
+WriteBits( best_pbits[ 1 ], 1, &bit_pos, out );
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    WriteBits( best_indices[ i ], i == 0 ? 3 : 4, &bit_pos, out );
+    }
+
+} /* EncodeBC7Block() */
+
+
+/*******************************************************************
+*
+*   EncodeBlocks()
+*
+*   DESCRIPTION:
+*       Encode the RGBA8 image into rows of 4x4 blocks of the given
+*       format.  Edge blocks repeat the last row and column.
+*
+*******************************************************************/
+
+static void EncodeBlocks( const AssetFileTextureFormat format, const uint8_t *rgba, const int width, const int height, uint8_t *out )
+{
+int blocks_wide = ( width + BLOCK_EXTENT - 1 ) / BLOCK_EXTENT;
+int blocks_high = ( height + BLOCK_EXTENT - 1 ) / BLOCK_EXTENT;
+for( int block_y = 0; block_y < blocks_high; block_y++ )
+    {
+    for( int block_x = 0; block_x < blocks_wide; block_x++ )
+        {
+        TexelBlock block;
+        GetBlock( rgba, width, height, block_x, block_y, &block );
+
+        switch( format )
+            {
+            case ASSET_FILE_TEXTURE_FORMAT_BC1:
+                EncodeBC1Block( &block, out );
+                break;
+
+            case ASSET_FILE_TEXTURE_FORMAT_BC3:
+                EncodeBC4Block( &block, 3, out );
+                EncodeBC1Block( &block, out + BC4_BLOCK_SZ );
+                break;
+
+            case ASSET_FILE_TEXTURE_FORMAT_BC4:
+                EncodeBC4Block( &block, 0, out );
+                break;
+
+            case ASSET_FILE_TEXTURE_FORMAT_BC5:
+                EncodeBC4Block( &block, 0, out );
+                EncodeBC4Block( &block, 1, out + BC4_BLOCK_SZ );
+                break;
+
+            case ASSET_FILE_TEXTURE_FORMAT_BC7:
+                EncodeBC7Block( &block, out );
+                break;
+
+            default:
+                assert( false );
+                break;
+            }
+
+        out += FORMAT_INFO[ format ].block_sz;
+        }
+    }
+
+} /* EncodeBlocks() */
+
+
+/*******************************************************************
+*
+*   ExpandToRGBA8()
+*
+*   DESCRIPTION:
+*       Convert the loaded image to 8-bit RGBA.  One and two channel
+*       images are grey and grey/alpha, as loaded by stb_image, except
+*       that formats storing at most two channels take a two channel
+*       image as plain data in red and green.
+*
+*******************************************************************/
+
+static void ExpandToRGBA8( const AssetFileTextureFormat format, const unsigned char *image, const int width, const int height, const int channel_count, const uint8_t channel_width, uint8_t *out )
+{
+bool is_two_channel_data = channel_count == 2
+                        && FORMAT_INFO[ format ].channel_cnt <= 2;
+size_t texel_cnt = (size_t)width * (size_t)height;
+for( size_t i = 0; i < texel_cnt; i++ )
+    {
+    uint8_t src[ 4 ] = { 0, 0, 0, 255 };
+    for( int c = 0; c < channel_count && c < 4; c++ )
+        {
+        size_t at = i * channel_count + c;
+        if( channel_width == 2 )
+            {
+            uint32_t wide = ( (const uint16_t*)image )[ at ];
+            src[ c ] = (uint8_t)( ( wide * 255 + 32767 ) / 65535 );
+            }
+        else
+            {
+            src[ c ] = image[ at ];
+            }
+        }
+
+    uint8_t *dst = &out[ i * 4 ];
+    if( is_two_channel_data )
+        {
+        dst[ 0 ] = src[ 0 ];
+        dst[ 1 ] = src[ 1 ];
+        dst[ 2 ] = 0;
+        dst[ 3 ] = 255;
+        }
+    else if( channel_count <= 2 )
+        {
+        dst[ 0 ] = dst[ 1 ] = dst[ 2 ] = src[ 0 ];
+        dst[ 3 ] = channel_count == 2 ? src[ 1 ] : 255;
+        }
+    else
+        {
+        memcpy( dst, src, 4 );
+        }
+    }
+
+} /* ExpandToRGBA8() */
+
+
+/*******************************************************************
+*
+*   FindEndpoints()
+*
+*   DESCRIPTION:
+*       Initial endpoints at the extremes of the block along its
+*       principal axis, found by power iteration on the covariance.
+*
+*******************************************************************/
+
+static void FindEndpoints( const TexelBlock *block, const int channel_cnt, float *e0, float *e1 )
+{
+float mean[ 4 ] = {};
+float lo[ 4 ];
+float hi[ 4 ];
+for( int c = 0; c < channel_cnt; c++ )
+    {
+    lo[ c ] = hi[ c ] = block->channels[ c ][ 0 ];
+    for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+        {
+        mean[ c ] += block->channels[ c ][ i ];
+        lo[ c ] = std::min( lo[ c ], block->channels[ c ][ i ] );
+        hi[ c ] = std::max( hi[ c ], block->channels[ c ][ i ] );
+        }
+
+    mean[ c ] /= (float)BLOCK_TEXEL_CNT;
+    }
+
+float covariance[ 4 ][ 4 ] = {};
+for( int a = 0; a < channel_cnt; a++ )
+    {
+    for( int b = a; b < channel_cnt; b++ )
+        {
+        float sum = 0.0f;
+        for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+            {
+            sum += ( block->channels[ a ][ i ] - mean[ a ] ) * ( block->channels[ b ][ i ] - mean[ b ] );
+            }
+
+        covariance[ a ][ b ] = covariance[ b ][ a ] = sum;
+        }
+    }
+
+/* start from the bounding box diagonal, which is already close for most blocks */
+float axis[ 4 ] = {};
+for( int c = 0; c < channel_cnt; c++ )
+    {
+    axis[ c ] = hi[ c ] - lo[ c ];
+    }
+
+for( int iteration = 0; iteration < PRINCIPAL_AXIS_ITERATION_CNT; iteration++ )
+    {
+    float next[ 4 ] = {};
+    float length = 0.0f;
+    for( int a = 0; a < channel_cnt; a++ )
+        {
+        for( int b = 0; b < channel_cnt; b++ )
+            {
+            next[ a ] += covariance[ a ][ b ] * axis[ b ];
+            }
+
+        length = std::max( length, std::fabs( next[ a ] ) );
+        }
+
+    if( length == 0.0f )
+        {
+        break;
+        }
+
+    for( int c = 0; c < channel_cnt; c++ )
+        {
+        axis[ c ] = next[ c ] / length;
+        }
+    }
+
+float length_sq = 0.0f;
+for( int c = 0; c < channel_cnt; c++ )
+    {
+    length_sq += axis[ c ] * axis[ c ];
+    }
+
+float t_lo = 0.0f;
+float t_hi = 0.0f;
+if( length_sq > 0.0f )
+    {
+    for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+        {
+        float t = 0.0f;
+        for( int c = 0; c < channel_cnt; c++ )
+            {
+            t += ( block->channels[ c ][ i ] - mean[ c ] ) * axis[ c ];
+            }
+
+        t /= length_sq;
+        t_lo = std::min( t_lo, t );
+        t_hi = std::max( t_hi, t );
+        }
+    }
+
+for( int c = 0; c < channel_cnt; c++ )
+    {
+    e0[ c ] = std::clamp( mean[ c ] + axis[ c ] * t_hi, 0.0f, 255.0f );
+    e1[ c ] = std::clamp( mean[ c ] + axis[ c ] * t_lo, 0.0f, 255.0f );
+    }
+
+} /* FindEndpoints() */
+
+
+/*******************************************************************
+*
+*   FitEndpoints()
+*
+*   DESCRIPTION:
+*       Least squares endpoints for the chosen indices, where index
+*       k blends e0 and e1 by weights[ k ].  Returns false if the
+*       indices do not constrain both endpoints.
+*
+*******************************************************************/
+
+static bool FitEndpoints( const TexelBlock *block, const int channel_cnt, const float *weights, const uint8_t *indices, float *e0, float *e1 )
+{
+float aa = 0.0f;
+float ab = 0.0f;
+float bb = 0.0f;
+float ax[ 4 ] = {};
+float bx[ 4 ] = {};
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    float b = weights[ indices[ i ] ];
+    float a = 1.0f - b;
+    aa += a * a;
+    ab += a * b;
+    bb += b * b;
+    for( int c = 0; c < channel_cnt; c++ )
+        {
+        ax[ c ] += a * block->channels[ c ][ i ];
+        bx[ c ] += b * block->channels[ c ][ i ];
+        }
+    }
+
+float det = aa * bb - ab * ab;
+if( std::fabs( det ) < 1e-6f )
+    {
+    return( false );
+    }
+
+for( int c = 0; c < channel_cnt; c++ )
+    {
+    e0[ c ] = std::clamp( ( ax[ c ] * bb - bx[ c ] * ab ) / det, 0.0f, 255.0f );
+    e1[ c ] = std::clamp( ( bx[ c ] * aa - ax[ c ] * ab ) / det, 0.0f, 255.0f );
+    }
+
+return( true );
+
+} /* FitEndpoints() */
+
+
+/*******************************************************************
+*
+*   GetBlock()
+*
+*   DESCRIPTION:
+*       Gather a 4x4 block into channel planes, clamping reads to
+*       the image edges.
+*
+*******************************************************************/
+
+static void GetBlock( const uint8_t *rgba, const int width, const int height, const int block_x, const int block_y, TexelBlock *block )
+{
+for( int y = 0; y < BLOCK_EXTENT; y++ )
+    {
+    int src_y = std::min( block_y * BLOCK_EXTENT + y, height - 1 );
+    for( int x = 0; x < BLOCK_EXTENT; x++ )
+        {
+        int src_x = std::min( block_x * BLOCK_EXTENT + x, width - 1 );
+        const uint8_t *texel = &rgba[ ( (size_t)src_y * width + src_x ) * 4 ];
+        for( int c = 0; c < 4; c++ )
+            {
+            block->channels[ c ][ y * BLOCK_EXTENT + x ] = (float)texel[ c ];
+            }
+        }
+    }
+
+} /* GetBlock() */
+
+
+/*******************************************************************
+*
+*   GetLevelByteSize()
+*
+*******************************************************************/
+
+static uint32_t GetLevelByteSize( const AssetFileTextureFormat format, const int width, const int height, const int channel_count, const uint8_t channel_width )
+{
+if( format == ASSET_FILE_TEXTURE_FORMAT_RAW )
+    {
+    return( (uint32_t)width * height * channel_count * channel_width );
+    }
+
+uint32_t blocks_wide = ( width + BLOCK_EXTENT - 1 ) / BLOCK_EXTENT;
+uint32_t blocks_high = ( height + BLOCK_EXTENT - 1 ) / BLOCK_EXTENT;
+
+return( blocks_wide * blocks_high * FORMAT_INFO[ format ].block_sz );
+
+} /* GetLevelByteSize() */
+
+
+/*******************************************************************
+*
+*   LinearToSRGB()
+*
+*******************************************************************/
+
+static float LinearToSRGB( const float value )
+{
+if( value <= 0.0031308f )
+    {
+    return( 12.92f * value );
+    }
+
+return( 1.055f * std::pow( value, 1.0f / 2.4f ) - 0.055f );
+
+} /* LinearToSRGB() */
+
+
+/*******************************************************************
+*
+*   LinearToTexels()
+*
+*   DESCRIPTION:
+*       Quantize filtered linear texels back into the source layout.
+*       Inverse of TexelsToLinear().
+*
+*******************************************************************/
+
+static void LinearToTexels( const float *linear, const int texel_cnt, const int channel_count, const uint8_t channel_width, const bool is_linear_data, uint8_t *out )
+{
+float max_value = channel_width == 2 ? 65535.0f : 255.0f;
+for( int i = 0; i < texel_cnt; i++ )
+    {
+    for( int c = 0; c < channel_count; c++ )
+        {
+        float value = linear[ i * channel_count + c ];
+        if( !is_linear_data
+         && IS_COLOR_CHANNEL( c, channel_count ) )
+            {
+            value = LinearToSRGB( value );
+            }
+
+        value = std::clamp( value * max_value + 0.5f, 0.0f, max_value );
+        if( channel_width == 2 )
+            {
+            ( (uint16_t*)out )[ i * channel_count + c ] = (uint16_t)value;
+            }
+        else
+            {
+            out[ i * channel_count + c ] = (uint8_t)value;
+            }
+        }
+    }
+
+} /* LinearToTexels() */
+
+
+/*******************************************************************
+*
+*   PackRGB565()
+*
+*******************************************************************/
+
+static uint16_t PackRGB565( const float *color )
+{
+uint16_t r = (uint16_t)( color[ 0 ] * 31.0f / 255.0f + 0.5f );
+uint16_t g = (uint16_t)( color[ 1 ] * 63.0f / 255.0f + 0.5f );
+uint16_t b = (uint16_t)( color[ 2 ] * 31.0f / 255.0f + 0.5f );
+
+return( (uint16_t)( ( r << 11 ) | ( g << 5 ) | b ) );
+
+} /* PackRGB565() */
+
+
+/*******************************************************************
+*
+*   PickIndices()
+*
+*   DESCRIPTION:
+*       Choose the nearest palette entry for every texel and return
+*       the total squared error.  The inner loop runs across the
+*       sixteen texel planes, four texels to a vector with SSE2.
+*
+*******************************************************************/
+
+static float PickIndices( const TexelBlock *block, const int channel_cnt, const float ( *palette )[ 4 ], const int palette_cnt, uint8_t *indices )
+{
+float best[ BLOCK_TEXEL_CNT ];
+#if defined( EXPORT_TEXTURE_USE_SSE2 )
+__m128  best4[ BLOCK_TEXEL_CNT / 4 ];
+__m128i index4[ BLOCK_TEXEL_CNT / 4 ];
+for( int q = 0; q < BLOCK_TEXEL_CNT / 4; q++ )
+    {
+    best4[ q ] = _mm_set1_ps( FLT_MAX );
+    index4[ q ] = _mm_setzero_si128();
+    }
+
+for( int p = 0; p < palette_cnt; p++ )
+    {
+    __m128 distance4[ BLOCK_TEXEL_CNT / 4 ];
+    for( int q = 0; q < BLOCK_TEXEL_CNT / 4; q++ )
+        {
+        distance4[ q ] = _mm_setzero_ps();
+        }
+
+    for( int c = 0; c < channel_cnt; c++ )
+        {
+        __m128 target = _mm_set1_ps( palette[ p ][ c ] );
+        for( int q = 0; q < BLOCK_TEXEL_CNT / 4; q++ )
+            {
+            __m128 diff = _mm_sub_ps( _mm_loadu_ps( &block->channels[ c ][ 4 * q ] ), target );
+            distance4[ q ] = _mm_add_ps( distance4[ q ], _mm_mul_ps( diff, diff ) );
+            }
+        }
+
+    /* strictly closer keeps the first of equal entries, as the scalar loop does */
+    __m128i entry = _mm_set1_epi32( p );
+    for( int q = 0; q < BLOCK_TEXEL_CNT / 4; q++ )
+        {
+        __m128 is_closer = _mm_cmplt_ps( distance4[ q ], best4[ q ] );
+        best4[ q ] = _mm_or_ps( _mm_and_ps( is_closer, distance4[ q ] ), _mm_andnot_ps( is_closer, best4[ q ] ) );
+        index4[ q ] = _mm_or_si128( _mm_and_si128( _mm_castps_si128( is_closer ), entry ), _mm_andnot_si128( _mm_castps_si128( is_closer ), index4[ q ] ) );
+        }
+    }
+
+int32_t picked[ BLOCK_TEXEL_CNT ];
+for( int q = 0; q < BLOCK_TEXEL_CNT / 4; q++ )
+    {
+    _mm_storeu_ps( &best[ 4 * q ], best4[ q ] );
+    _mm_storeu_si128( (__m128i*)&picked[ 4 * q ], index4[ q ] );
+    }
+
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    indices[ i ] = (uint8_t)picked[ i ];
+    }
+#else
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    best[ i ] = FLT_MAX;
+    indices[ i ] = 0;
+    }
+
+for( int p = 0; p < palette_cnt; p++ )
+    {
+    float distance[ BLOCK_TEXEL_CNT ] = {};
+    for( int c = 0; c < channel_cnt; c++ )
+        {
+        const float *plane = block->channels[ c ];
+        float target = palette[ p ][ c ];
+        for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+            {
+            float diff = plane[ i ] - target;
+            distance[ i ] += diff * diff;
+            }
+        }
+
+    for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+        {
+        bool is_closer = distance[ i ] < best[ i ];
+        best[ i ] = is_closer ? distance[ i ] : best[ i ];
+        indices[ i ] = is_closer ? (uint8_t)p : indices[ i ];
+        }
+    }
+#endif
+
+float error = 0.0f;
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    error += best[ i ];
+    }
+
+return( error );
+
+} /* PickIndices() */
+
+
+/*******************************************************************
+*
+*   PickRampIndices()
+*
+*   DESCRIPTION:
+*       Same result as PickIndices() for an evenly spaced ramp, but
+*       projects each texel onto the ramp and only measures the
+*       nearest step and its neighbours.
+*
+*******************************************************************/
+
+static float PickRampIndices( const TexelBlock *block, const int channel_cnt, const float ( *palette )[ 4 ], const int palette_cnt, uint8_t *indices )
+{
+float axis[ 4 ] = {};
+float length_sq = 0.0f;
+for( int c = 0; c < channel_cnt; c++ )
+    {
+    axis[ c ] = palette[ palette_cnt - 1 ][ c ] - palette[ 0 ][ c ];
+    length_sq += axis[ c ] * axis[ c ];
+    }
+
+if( length_sq == 0.0f )
+    {
+    return( PickIndices( block, channel_cnt, palette, palette_cnt, indices ) );
+    }
+
+float scale = (float)( palette_cnt - 1 ) / length_sq;
+float error = 0.0f;
+#if defined( EXPORT_TEXTURE_USE_SSE2 )
+/* four texels at a time, gathering each lane's candidate entries */
+const __m128 last_step = _mm_set1_ps( (float)( palette_cnt - 1 ) );
+for( int q = 0; q < BLOCK_TEXEL_CNT / 4; q++ )
+    {
+    __m128 t = _mm_setzero_ps();
+    for( int c = 0; c < channel_cnt; c++ )
+        {
+        __m128 offset = _mm_sub_ps( _mm_loadu_ps( &block->channels[ c ][ 4 * q ] ), _mm_set1_ps( palette[ 0 ][ c ] ) );
+        t = _mm_add_ps( t, _mm_mul_ps( offset, _mm_set1_ps( axis[ c ] ) ) );
+        }
+
+    /* clamping before the conversion matches clamping the truncated step */
+    __m128 nearest = _mm_add_ps( _mm_mul_ps( t, _mm_set1_ps( scale ) ), _mm_set1_ps( 0.5f ) );
+    int32_t steps[ 4 ];
+    _mm_storeu_si128( (__m128i*)steps, _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( nearest, _mm_setzero_ps() ), last_step ) ) );
+
+    __m128 best4 = _mm_set1_ps( FLT_MAX );
+    __m128i index4 = _mm_setzero_si128();
+    for( int offset = -1; offset <= 1; offset++ )
+        {
+        int k[ 4 ];
+        for( int lane = 0; lane < 4; lane++ )
+            {
+            k[ lane ] = std::clamp( steps[ lane ] + offset, 0, palette_cnt - 1 );
+            }
+
+        __m128 distance = _mm_setzero_ps();
+        for( int c = 0; c < channel_cnt; c++ )
+            {
+            __m128 entry = _mm_setr_ps( palette[ k[ 0 ] ][ c ], palette[ k[ 1 ] ][ c ], palette[ k[ 2 ] ][ c ], palette[ k[ 3 ] ][ c ] );
+            __m128 diff = _mm_sub_ps( _mm_loadu_ps( &block->channels[ c ][ 4 * q ] ), entry );
+            distance = _mm_add_ps( distance, _mm_mul_ps( diff, diff ) );
+            }
+
+        __m128 is_closer = _mm_cmplt_ps( distance, best4 );
+        best4 = _mm_or_ps( _mm_and_ps( is_closer, distance ), _mm_andnot_ps( is_closer, best4 ) );
+        index4 = _mm_or_si128( _mm_and_si128( _mm_castps_si128( is_closer ), _mm_setr_epi32( k[ 0 ], k[ 1 ], k[ 2 ], k[ 3 ] ) ), _mm_andnot_si128( _mm_castps_si128( is_closer ), index4 ) );
+        }
+
+    float best[ 4 ];
+    int32_t picked[ 4 ];
+    _mm_storeu_ps( best, best4 );
+    _mm_storeu_si128( (__m128i*)picked, index4 );
+    for( int lane = 0; lane < 4; lane++ )
+        {
+        indices[ 4 * q + lane ] = (uint8_t)picked[ lane ];
+        error += best[ lane ];
+        }
+    }
+#else
+for( int i = 0; i < BLOCK_TEXEL_CNT; i++ )
+    {
+    float t = 0.0f;
+    for( int c = 0; c < channel_cnt; c++ )
+        {
+        t += ( block->channels[ c ][ i ] - palette[ 0 ][ c ] ) * axis[ c ];
+        }
+
+    int step = std::clamp( (int)( t * scale + 0.5f ), 0, palette_cnt - 1 );
+    int first = std::max( step - 1, 0 );
+    int last = std::min( step + 1, palette_cnt - 1 );
+
+    float best = FLT_MAX;
+    for( int k = first; k <= last; k++ )
+        {
+        float distance = 0.0f;
+        for( int c = 0; c < channel_cnt; c++ )
+            {
+            float diff = block->channels[ c ][ i ] - palette[ k ][ c ];
+            distance += diff * diff;
+            }
+
+        if( distance < best )
+            {
+            best = distance;
+            indices[ i ] = (uint8_t)k;
+            }
+        }
+
+    error += best;
+    }
+#endif
+
+return( error );
+
+} /* PickRampIndices() */
+
+
+/*******************************************************************
+*
+*   SRGBToLinear()
+*
+*******************************************************************/
+
+static float SRGBToLinear( const float value )
+{
+if( value <= 0.04045f )
+    {
+    return( value / 12.92f );
+    }
+
+return( std::pow( ( value + 0.055f ) / 1.055f, 2.4f ) );
+
+} /* SRGBToLinear() */
+
+
+/*******************************************************************
+*
+*   TexelsToLinear()
+*
+*   DESCRIPTION:
+*       Convert a run of source texels to normalized floats, taking
+*       color channels out of sRGB unless the texture holds linear
+*       data.  Alpha is always linear.
+*
+*******************************************************************/
+
+static void TexelsToLinear( const uint8_t *texels, const int texel_cnt, const int channel_count, const uint8_t channel_width, const bool is_linear_data, float *out )
+{
+/* 8-bit sources go through a table, pow() per texel dominates otherwise */
+float table[ 256 ];
+for( int i = 0; i < 256; i++ )
+    {
+    table[ i ] = is_linear_data ? (float)i / 255.0f : SRGBToLinear( (float)i / 255.0f );
+    }
+
+for( int i = 0; i < texel_cnt; i++ )
+    {
+    for( int c = 0; c < channel_count; c++ )
+        {
+        bool is_color = IS_COLOR_CHANNEL( c, channel_count );
+        float value = 0.0f;
+        if( channel_width == 2 )
+            {
+            value = (float)( (const uint16_t*)texels )[ i * channel_count + c ] / 65535.0f;
+            value = is_color && !is_linear_data ? SRGBToLinear( value ) : value;
+            }
+        else
+            {
+            uint8_t texel = texels[ i * channel_count + c ];
+            value = is_color ? table[ texel ] : (float)texel / 255.0f;
+            }
+
+        out[ i * channel_count + c ] = value;
+        }
+    }
+
+} /* TexelsToLinear() */
+
+
+/*******************************************************************
+*
+*   UnpackRGB565()
+*
+*******************************************************************/
+
+static void UnpackRGB565( const uint16_t color, float *out )
+{
+uint32_t r = ( color >> 11 ) & 31;
+uint32_t g = ( color >> 5 ) & 63;
+uint32_t b = color & 31;
+
+out[ 0 ] = (float)( ( r << 3 ) | ( r >> 2 ) );
+out[ 1 ] = (float)( ( g << 2 ) | ( g >> 4 ) );
+out[ 2 ] = (float)( ( b << 3 ) | ( b >> 2 ) );
+
+} /* UnpackRGB565() */
+
+
+/*******************************************************************
+*
+*   WriteBits()
+*
+*   DESCRIPTION:
+*       Append bits to a zeroed block, least significant bit first.
+*
+*******************************************************************/
+
+static void WriteBits( const uint32_t value, const int bit_cnt, int *bit_pos, uint8_t *out )
+{
+for( int i = 0; i < bit_cnt; i++ )
+    {
+    if( value & ( 1u << i ) )
+        {
+        out[ *bit_pos >> 3 ] |= (uint8_t)( 1u << ( *bit_pos & 7 ) );
+        }
+
+    ( *bit_pos )++;
+    }
+
+} /* WriteBits() */
+
+
+/*******************************************************************
+*
+*   WriteLevel()
+*
+*   DESCRIPTION:
+*       Encode one mip level into the texture format and append it
+*       to the texture under write.
+*
+*******************************************************************/
+
+static bool WriteLevel( const AssetFileTextureFormat format, const uint8_t *texels, const int width, const int height, const int channel_count, const uint8_t channel_width, AssetFileWriter *output )
+{
+uint32_t byte_size = GetLevelByteSize( format, width, height, channel_count, channel_width );
+if( format == ASSET_FILE_TEXTURE_FORMAT_RAW )
+    {
+    return( AssetFile_WriteTextureMip( texels, byte_size, output ) );
+    }
+
+/* block encoders work on 8-bit RGBA whatever the source layout */
+std::vector<uint8_t> rgba( (size_t)width * height * 4 );
+ExpandToRGBA8( format, texels, width, height, channel_count, channel_width, rgba.data() );
+
+std::vector<uint8_t> encoded( byte_size );
+EncodeBlocks( format, rgba.data(), width, height, encoded.data() );
+
+return( AssetFile_WriteTextureMip( encoded.data(), byte_size, output ) );
+
+} /* WriteLevel() */
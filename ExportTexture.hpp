@@ -4,6 +4,9 @@
 #include "AssetFile.hpp"
 #include "ResourceUtilities.hpp"
 
+#define EXPORT_TEXTURE_VERSION      ( 3 )
+                                    /* bump when the output changes */
+
 typedef struct
     {
     uint16_t            width;
@@ -12,5 +15,6 @@ typedef struct
 
 using AssetIdToExtentMap = std::map<AssetFileAssetId, TextureExtent>;
 
-bool ExportTexture_Export( const AssetFileAssetId id, const char *filename, AssetIdToExtentMap &extent_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output );
+bool ExportTexture_Export( const AssetFileAssetId id, const char *filename, const AssetFileTextureFormat format, const bool has_mips, const bool is_srgb, AssetIdToExtentMap &extent_map, WriteStats *stats, std::vector<std::string> &out_strs, AssetFileWriter *output );
+bool ExportTexture_ParseFormat( const char *str, AssetFileTextureFormat *format );
 bool ExportTexture_WriteTextureExtents( AssetIdToExtentMap &extent_map, AssetFileWriter *output );
\ No newline at end of file
@@ -1,14 +1,18 @@
 /*******************************************************************
-*  ResourcePackager.exe -d [definition filename and path] -o [output binary filename and path] -r [root to input assets]
+*  ResourcePackager.exe -d [definition filename and path] -o [output binary filename and path] -r [root to input assets] -j [export thread count]
 *******************************************************************/
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstring>
 #include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <iomanip>
+#include <mutex>
 #include <string>
 #include <sstream>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -17,6 +21,7 @@
 #include "ExportFont.hpp"
 #include "ExportModel.hpp"
 #include "ExportSounds.hpp"
+#include "ExportTerrain.hpp"
 #include "ExportTexture.hpp"
 #include "ResourceUtilities.hpp"
 
@@ -26,6 +31,18 @@
 #define ARGUMENT_ASSET_ROOT         "-r"
 #define ARGUMENT_SOUND_BANK_FOLDER  "-sb"
 #define ARGUMENT_INPUT_FONTS_FOLDER "-f"
+#define ARGUMENT_JOB_COUNT          "-j"
+#define ARGUMENT_CLEAN_BUILD        "-clean"
+#define ARGUMENT_COMPRESS           "-compress"
+
+#define CACHE_MANIFEST_FILENAME     "AllAssets.cache.json"
+#define CACHE_MANIFEST_VERSION      ( 3 )
+                                    /* bump when the pack format changes */
+#define CACHE_PREVIOUS_SUFFIX       ".prev"
+
+#define EXPORT_WINDOW_PER_THREAD    ( 2 )
+                                    /* blobs a worker may finish    */
+                                    /*  ahead of the append order   */
 
 typedef struct
     {
@@ -39,6 +56,9 @@ using ProgramArgumentsOutputFolder    = GenericArgumentString;
 using ProgramArgumentsAssetsRoot      = GenericArgumentString;
 using ProgramArgumentsSoundBankFolder = GenericArgumentString;
 using ProgramArgumentsFontsFolder     = GenericArgumentString;
+using ProgramArgumentsJobCount        = GenericArgumentString;
+using ProgramArgumentsCleanBuild      = GenericArgumentString;
+using ProgramArgumentsCompress        = GenericArgumentString;
 
 typedef struct _ProgramArguments
     {
@@ -54,6 +74,12 @@ typedef struct _ProgramArguments
                         output_soundbank_folder;
     ProgramArgumentsFontsFolder
                         input_fonts_folder;
+    ProgramArgumentsJobCount
+                        job_count;
+    ProgramArgumentsCleanBuild
+                        clean_build;
+    ProgramArgumentsCompress
+                        compress;
     } ProgramArguments;
 
 typedef struct _ParseDefinitionState
@@ -62,12 +88,22 @@ typedef struct _ParseDefinitionState
     } ParseDefinitionState;
 
 struct _DefinitionVisitor;
+struct _ExportJob;
 
+static void add_dedup_stats( const uint32_t prev_cnt, const uint64_t prev_sz, const AssetFileWriter *output, WriteStats *stats );
+static bool export_asset( _ExportJob *job, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, const unsigned int thread_count, AssetFileWriter *output );
+static bool export_assets( std::vector<_ExportJob> &jobs, const unsigned int thread_count, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, AssetFileReader *previous, AssetFileWriter *output );
 static size_t get_file_char_size( const char *filename );
+static uint64_t hash_bytes( const void *data, const size_t sz, uint64_t hash );
+static bool hash_file( const char *filename, uint64_t *hash );
+static cJSON * load_cache_manifest( const char *filename );
 static void parse_args( int argc, char **argv, ProgramArguments *arguments );
 static void print_args( ProgramArguments *arguments );
 static bool process_args( const ProgramArguments *arguments );
 static bool read_json_as_string( const char *filename, const size_t sz, char *out );
+static void resolve_cached_jobs( std::vector<_ExportJob> &jobs, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, const AssetFileCodec codec, const cJSON *manifest, AssetFileReader *previous );
+static bool reuse_asset( _ExportJob *job, AssetFileReader *previous, AssetFileWriter *output );
+static bool save_cache_manifest( const char *filename, const std::vector<_ExportJob> &jobs );
 static bool visit_all_definition_assets( const cJSON *assets, const char *asset_folder, const char *input_font_folder, _DefinitionVisitor *visitor );
 
 typedef struct _DefinitionVisitor
@@ -81,6 +117,14 @@ typedef struct _DefinitionVisitor
         std::string     asset_id_str;
         std::string     font_glyphs;
         int             font_point_sz;
+        ExportModelOptions
+                        model_options;
+        ExportTerrainOptions
+                        terrain_options;
+        AssetFileTextureFormat
+                        texture_format = ASSET_FILE_TEXTURE_FORMAT_RAW;
+        bool            texture_has_mips = true;
+        bool            texture_is_srgb = true;
         //std::string     shader_entry_point;
 
         } AssetDescriptor;
@@ -140,7 +184,7 @@ typedef struct _DefinitionVisitor
     *
     ***************************************************************/
 
-    virtual void VisitModel( const char *asset_id, const char *filename )
+    virtual void VisitModel( const char *asset_id, const char *filename, const ExportModelOptions &options )
     {
     std::string stripped = strip_filename( filename );
     if( std::find( seen_filenames.begin(), seen_filenames.end(), stripped ) != seen_filenames.end() )
@@ -162,6 +206,7 @@ typedef struct _DefinitionVisitor
     descriptor.filename          = std::string( filename );
     descriptor.stripped_filename = stripped;
     descriptor.asset_id_str      = std::string( asset_id );
+    descriptor.model_options     = options;
     
     asset_map[ id ] = descriptor;
 
@@ -242,6 +287,44 @@ typedef struct _DefinitionVisitor
     }   /* VisitSoundSample() */
 
 
+    /***************************************************************
+    *
+    *   VisitTerrain()
+    *
+    *   DESCRIPTION:
+    *       Tabulate the terrain asset in the descriptor JSON.
+    *
+    ***************************************************************/
+
+    virtual void VisitTerrain( const char *asset_id, const char *filename, const ExportTerrainOptions &options )
+    {
+    std::string stripped = strip_filename( filename );
+    if( std::find( seen_filenames.begin(), seen_filenames.end(), stripped ) != seen_filenames.end() )
+        {
+        print_warning( "Found duplicate filename (%s).  This time as TERRAIN.  Ignoring (%s)...", stripped.c_str(), filename );
+        return;
+        }
+
+    seen_filenames.push_back( stripped );
+
+    AssetFileAssetId id = AssetFile_MakeAssetIdFromName( asset_id, (uint32_t)strlen( asset_id ) );
+    if( asset_map.find( id ) != asset_map.end() )
+        {
+        print_warning( "Found duplicate asset name (%s).  This time as TERRAIN.  Overwriting with (%s)...", asset_id, filename );
+        }
+
+    AssetDescriptor descriptor = {};
+    descriptor.kind              = ASSET_FILE_ASSET_KIND_TERRAIN;
+    descriptor.filename          = std::string( filename );
+    descriptor.stripped_filename = stripped;
+    descriptor.asset_id_str      = std::string( asset_id );
+    descriptor.terrain_options   = options;
+
+    asset_map[ id ] = descriptor;
+
+    }   /* VisitTerrain() */
+
+
     /***************************************************************
     *
     *   VisitTexture()
@@ -251,7 +334,7 @@ typedef struct _DefinitionVisitor
     *
     ***************************************************************/
 
-    virtual void VisitTexture( const char *asset_id, const char *filename )
+    virtual void VisitTexture( const char *asset_id, const char *filename, const AssetFileTextureFormat format, const bool has_mips, const bool is_srgb )
     {
     std::string stripped = strip_filename( filename );
     if( std::find( seen_filenames.begin(), seen_filenames.end(), stripped ) != seen_filenames.end() )
@@ -272,6 +355,9 @@ typedef struct _DefinitionVisitor
     descriptor.kind              = ASSET_FILE_ASSET_KIND_TEXTURE;
     descriptor.filename          = std::string( filename );
     descriptor.stripped_filename = stripped;
+    descriptor.texture_format    = format;
+    descriptor.texture_has_mips  = has_mips;
+    descriptor.texture_is_srgb   = is_srgb;
 
     asset_map[ id ] = descriptor;
 
@@ -307,6 +393,24 @@ typedef struct _DefinitionVisitor
 
     } DefinitionVisitor;
 
+typedef struct _ExportJob
+    {
+    AssetFileAssetId    id;         /* asset to export              */
+    const DefinitionVisitor::AssetDescriptor
+                       *descriptor; /* asset definition             */
+    AssetFileWriter     blob;       /* in-memory output when threaded*/
+    WriteStats          stats;      /* this asset's write stats     */
+    AssetIdToExtentMap  extent_map; /* this asset's texture extents */
+    std::vector<std::string>
+                        out_strs;   /* this asset's log lines       */
+    FileInfo            source_info;/* source file size/write time  */
+    uint64_t            source_hash;/* source file content hash     */
+    uint64_t            params_hash;/* exporter version + options   */
+    bool                is_cached;  /* reuse the previous pack bytes*/
+    bool                success;    /* did the export succeed?      */
+    bool                is_done;    /* has a worker finished it?    */
+    } ExportJob;
+
 
 /*******************************************************************
 *
@@ -357,6 +461,9 @@ try
         printf( "\t-o PATH       Folder to write binary output file.\n" );
         printf( "\t-r PATH       Folder which is the root of assets defined in definition file.\n" );
         printf( "\t-sb PATH      Folder which to output the sound bank files.\n" );
+        printf( "\t-j COUNT      Number of threads to export assets on (0 = one per core, default 1).\n" );
+        printf( "\t-clean        Ignore the build cache and re-export every asset.\n" );
+        printf( "\t-compress     Compress each asset in the binary output file.\n" );
 
         return( 0 );
         }
@@ -419,6 +526,259 @@ return( 0 );
 } /* main() */
 
 
+/*******************************************************************
+*
+*   add_dedup_stats()
+*
+*   DESCRIPTION:
+*       Credit the stats with any payloads the writer has shared
+*       since its savings were last sampled.
+*
+*******************************************************************/
+
+static void add_dedup_stats( const uint32_t prev_cnt, const uint64_t prev_sz, const AssetFileWriter *output, WriteStats *stats )
+{
+uint32_t asset_cnt = 0;
+uint64_t saved_sz = 0;
+AssetFile_GetDedupSavings( &asset_cnt, &saved_sz, output );
+
+stats->assets_deduplicated += asset_cnt - prev_cnt;
+stats->deduplicated_sz     += (size_t)( saved_sz - prev_sz );
+
+} /* add_dedup_stats() */
+
+
+/*******************************************************************
+*
+*   export_asset()
+*
+*   DESCRIPTION:
+*       Convert a single asset and write it to the given output.
+*       Terrains spread their own work over the given threads.
+*       Returns false if the failure should stop the packaging.
+*
+*******************************************************************/
+
+static bool export_asset( ExportJob *job, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, const unsigned int thread_count, AssetFileWriter *output )
+{
+const DefinitionVisitor::AssetDescriptor *descriptor = job->descriptor;
+WriteStats this_stats = {};
+job->stats = {};
+
+switch( descriptor->kind )
+    {
+    case ASSET_FILE_ASSET_KIND_FONT:
+        if( !ExportFont_Export( job->id, descriptor->asset_id_str.c_str(), descriptor->filename.c_str(), descriptor->font_point_sz, descriptor->font_glyphs.c_str(), this_stats, job->out_strs, output ) )
+            {
+            print_error( "Failed to load font (%s).  Exiting...", descriptor->filename.c_str() );
+            return( false );
+            }
+
+        job->stats.fonts_written++;
+        job->stats.written_sz += this_stats.written_sz;
+        break;
+
+    case ASSET_FILE_ASSET_KIND_MODEL:
+        if( !ExportModel_Export( job->id, descriptor->filename.c_str(), &descriptor->model_options, texture_map, &this_stats, job->out_strs, output ) )
+            {
+            print_error( "Failed to load model (%s).  Exiting...", descriptor->filename.c_str() );
+            return( false );
+            }
+
+        job->stats.models_written++;
+        job->stats.written_sz += this_stats.written_sz;
+        break;
+
+    case ASSET_FILE_ASSET_KIND_TERRAIN:
+        if( !ExportTerrain_Export( job->id, descriptor->filename.c_str(), &descriptor->terrain_options, thread_count, &this_stats, job->out_strs, output ) )
+            {
+            print_error( "Failed to load terrain (%s).  Exiting...", descriptor->filename.c_str() );
+            return( false );
+            }
+
+        job->stats.terrains_written++;
+        job->stats.written_sz += this_stats.written_sz;
+        break;
+
+    case ASSET_FILE_ASSET_KIND_TEXTURE:
+        if( !ExportTexture_Export( job->id, descriptor->filename.c_str(), descriptor->texture_format, descriptor->texture_has_mips, descriptor->texture_is_srgb, job->extent_map, &this_stats, job->out_strs, output ) )
+            {
+            print_error( "Failed to load texture (%s).  Exiting...", descriptor->filename.c_str() );
+            return( false );
+            }
+
+        job->stats.textures_written++;
+        job->stats.written_sz += this_stats.written_sz;
+        break;
+
+    default:
+        print_warning( "Encountered unknown asset kind (%d).  Ignoring...", descriptor->kind );
+        break;
+    }
+
+return( true );
+
+} /* export_asset() */
+
+
+/*******************************************************************
+*
+*   export_assets()
+*
+*   DESCRIPTION:
+*       Export all of the jobs.  With more than one thread, each
+*       asset is converted into its own in-memory blob by a pool of
+*       workers, and this thread appends the finished blobs to the
+*       output in job order.  Workers stay within a small window of
+*       the next job to append, so finished blobs never pile up.
+*       Terrains are too large to stage in memory, so this thread
+*       exports them straight into the output when their turn comes,
+*       using all the threads while the pool waits.
+*
+*******************************************************************/
+
+static bool export_assets( std::vector<ExportJob> &jobs, const unsigned int thread_count, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, AssetFileReader *previous, AssetFileWriter *output )
+{
+if( thread_count <= 1 )
+    {
+    for( ExportJob &job : jobs )
+        {
+        uint32_t shared_cnt = 0;
+        uint64_t shared_sz = 0;
+        AssetFile_GetDedupSavings( &shared_cnt, &shared_sz, output );
+
+        job.success = job.is_cached ? reuse_asset( &job, previous, output ) : export_asset( &job, texture_map, 1, output );
+        if( !job.success )
+            {
+            return( false );
+            }
+
+        add_dedup_stats( shared_cnt, shared_sz, output, &job.stats );
+        }
+
+    return( true );
+    }
+
+std::atomic<size_t> next_job( 0 );
+std::atomic<bool> is_cancelled( false );
+std::mutex done_mutex;
+std::condition_variable done_signal;
+const size_t window = (size_t)thread_count * EXPORT_WINDOW_PER_THREAD;
+size_t appended = 0;                /* jobs this thread has finished */
+unsigned int busy_cnt = 0;          /* workers exporting a job       */
+bool is_paused = false;             /* hold the pool for a terrain   */
+
+auto worker = [&]()
+    {
+    for( size_t i = next_job++; i < jobs.size() && !is_cancelled; i = next_job++ )
+        {
+        ExportJob *job = &jobs[ i ];
+        if( job->is_cached
+         || job->descriptor->kind == ASSET_FILE_ASSET_KIND_TERRAIN )
+            {
+            continue;
+            }
+
+            {
+            std::unique_lock<std::mutex> lock( done_mutex );
+            done_signal.wait( lock, [&]{ return( is_cancelled || ( !is_paused && i < appended + window ) ); } );
+            if( is_cancelled )
+                {
+                break;
+                }
+
+            busy_cnt++;
+            }
+
+        job->success = AssetFile_CreateForMemory( &job->id, 1, &job->blob )
+                    && AssetFile_SetCompression( output->codec, &job->blob )
+                    && export_asset( job, texture_map, 1, &job->blob );
+
+        std::lock_guard<std::mutex> lock( done_mutex );
+        busy_cnt--;
+        job->is_done = true;
+        done_signal.notify_all();
+        }
+    };
+
+auto finish_job = [&]( const bool is_failed )
+    {
+    std::lock_guard<std::mutex> lock( done_mutex );
+    appended++;
+    is_paused = false;
+    if( is_failed )
+        {
+        is_cancelled = true;
+        }
+
+    done_signal.notify_all();
+    };
+
+std::vector<std::thread> workers;
+for( unsigned int i = 0; i < thread_count && i < jobs.size(); i++ )
+    {
+    workers.emplace_back( worker );
+    }
+
+bool success = true;
+for( ExportJob &job : jobs )
+    {
+    uint32_t shared_cnt = 0;
+    uint64_t shared_sz = 0;
+    AssetFile_GetDedupSavings( &shared_cnt, &shared_sz, output );
+
+    if( job.is_cached )
+        {
+        job.success = reuse_asset( &job, previous, output );
+        }
+    else if( job.descriptor->kind == ASSET_FILE_ASSET_KIND_TERRAIN )
+        {
+        /* let the jobs in flight finish, so the terrain has the threads to itself */
+            {
+            std::unique_lock<std::mutex> lock( done_mutex );
+            is_paused = true;
+            done_signal.wait( lock, [&]{ return( busy_cnt == 0 ); } );
+            }
+
+        job.success = export_asset( &job, texture_map, thread_count, output );
+        }
+    else
+        {
+            {
+            std::unique_lock<std::mutex> lock( done_mutex );
+            done_signal.wait( lock, [&]{ return( job.is_done ); } );
+            }
+
+        job.success = job.success
+                   && AssetFile_AppendFromMemory( &job.blob, output );
+        AssetFile_CloseForWrite( &job.blob );
+        }
+
+    finish_job( !job.success );
+    if( !job.success )
+        {
+        success = false;
+        break;
+        }
+
+    add_dedup_stats( shared_cnt, shared_sz, output, &job.stats );
+    }
+
+for( std::thread &thread : workers )
+    {
+    thread.join();
+    }
+
+for( ExportJob &job : jobs )
+    {
+    AssetFile_CloseForWrite( &job.blob );
+    }
+
+return( success );
+
+} /* export_assets() */
+
+
 /*******************************************************************
 *
 *   get_file_char_size()
@@ -450,6 +810,104 @@ return( ret );
 } /* get_file_char_size() */
 
 
+/*******************************************************************
+*
+*   hash_bytes()
+*
+*   DESCRIPTION:
+*       Continue a 64-bit FNV-1a hash over the given bytes.
+*
+*******************************************************************/
+
+static uint64_t hash_bytes( const void *data, const size_t sz, uint64_t hash )
+{
+const uint8_t *bytes = (const uint8_t*)data;
+for( size_t i = 0; i < sz; i++ )
+    {
+    hash ^= bytes[ i ];
+    hash *= 0x100000001b3ull;
+    }
+
+return( hash );
+
+} /* hash_bytes() */
+
+
+/*******************************************************************
+*
+*   hash_file()
+*
+*   DESCRIPTION:
+*       Hash the full contents of the given file.
+*
+*******************************************************************/
+
+static bool hash_file( const char *filename, uint64_t *hash )
+{
+FILE *fhnd = fopen( filename, "rb" );
+if( !fhnd )
+    {
+    return( false );
+    }
+
+std::vector<uint8_t> chunk( 64 * 1024 );
+*hash = 0xcbf29ce484222325ull;
+
+size_t read_sz = 0;
+while( ( read_sz = fread( chunk.data(), 1, chunk.size(), fhnd ) ) > 0 )
+    {
+    *hash = hash_bytes( chunk.data(), read_sz, *hash );
+    }
+
+bool ret = !ferror( fhnd );
+fclose( fhnd );
+
+return( ret );
+
+} /* hash_file() */
+
+
+/*******************************************************************
+*
+*   load_cache_manifest()
+*
+*   DESCRIPTION:
+*       Load the build cache manifest written by the previous run.
+*       Returns NULL if there isn't a usable one.
+*
+*******************************************************************/
+
+static cJSON * load_cache_manifest( const char *filename )
+{
+if( !does_file_exist( filename ) )
+    {
+    return( NULL );
+    }
+
+size_t json_size = get_file_char_size( filename );
+if( json_size == 0 )
+    {
+    return( NULL );
+    }
+
+std::vector<char> json_string( json_size );
+read_json_as_string( filename, json_size, json_string.data() );
+
+cJSON *manifest = cJSON_ParseWithLength( json_string.data(), json_size );
+const cJSON *version = cJSON_GetObjectItemCaseSensitive( manifest, "version" );
+if( !cJSON_IsNumber( version )
+ || version->valueint != CACHE_MANIFEST_VERSION
+ || !cJSON_IsObject( cJSON_GetObjectItemCaseSensitive( manifest, "assets" ) ) )
+    {
+    cJSON_Delete( manifest );
+    return( NULL );
+    }
+
+return( manifest );
+
+} /* load_cache_manifest() */
+
+
 /*******************************************************************
 *
 *   parse_args()
@@ -466,6 +924,7 @@ typedef struct
     bool                is_setting_definition;
     bool                is_setting_asset_root;
     bool                is_setting_input_fonts_folder;
+    bool                is_setting_job_count;
     bool                is_setting_output_binary;
     bool                is_setting_output_bank_folder;
     } ArgumentExpectations;
@@ -506,6 +965,25 @@ for( int i = 0; i < argc; i++ )
         expectation = {};
         expectation.is_setting_input_fonts_folder = true;
         }
+    else if( strcmp( temp_argument, ARGUMENT_JOB_COUNT ) == 0 )
+        {
+        expectation = {};
+        expectation.is_setting_job_count = true;
+        }
+    else if( strcmp( temp_argument, ARGUMENT_CLEAN_BUILD ) == 0 )
+        {
+        /* takes no value */
+        expectation = {};
+        strncpy( arguments->clean_build.str, "true", sizeof( arguments->clean_build.str ) );
+        arguments->clean_build.is_valid = true;
+        }
+    else if( strcmp( temp_argument, ARGUMENT_COMPRESS ) == 0 )
+        {
+        /* takes no value */
+        expectation = {};
+        strncpy( arguments->compress.str, "true", sizeof( arguments->compress.str ) );
+        arguments->compress.is_valid = true;
+        }
     else
         {
         if( expectation.is_setting_asset_root )
@@ -540,6 +1018,12 @@ for( int i = 0; i < argc; i++ )
             arguments->input_fonts_folder.str[ sizeof( arguments->input_fonts_folder.str ) - 1 ] = '\0';
             arguments->input_fonts_folder.is_valid = ( strlen( temp_argument ) > 0 );
             }
+        else if( expectation.is_setting_job_count )
+            {
+            strncpy( arguments->job_count.str, temp_argument, sizeof( arguments->job_count.str ) );
+            arguments->job_count.str[ sizeof( arguments->job_count.str ) - 1 ] = '\0';
+            arguments->job_count.is_valid = ( strlen( temp_argument ) > 0 );
+            }
         }
     }
 
@@ -568,6 +1052,9 @@ print_info( FORMAT_STRING, "output_binary_folder: ", arguments->output_binary_fo
 print_info( FORMAT_STRING, "assets_folder: ", arguments->assets_folder.str );
 print_info( FORMAT_STRING, "output_soundbank_folder: ", arguments->output_soundbank_folder.str );
 print_info( FORMAT_STRING, "input_fonts_folder: ", arguments->input_fonts_folder.str );
+print_info( FORMAT_STRING, "job_count: ", arguments->job_count.str );
+print_info( FORMAT_STRING, "clean_build: ", arguments->clean_build.str );
+print_info( FORMAT_STRING, "compress: ", arguments->compress.str );
 printf( "\n" );
 
 #undef LEFT_COLUMN_WIDTH
@@ -612,6 +1099,7 @@ if( error )
     }
 
 bool success = false;
+unsigned int thread_count = 1;
 DefinitionVisitor visitor;
 std::vector<AssetFileAssetId> asset_ids;
 AssetFileWriter output_file = {};
@@ -619,6 +1107,8 @@ std::unordered_map<std::string, AssetFileAssetId> texture_map;
 WriteStats fonts_stats = {};
 WriteStats models_stats = {};
 WriteStats textures_stats = {};
+WriteStats terrains_stats = {};
+WriteStats dedup_stats = {};
 //WriteStats shaders_stats = {};
 AssetIdToExtentMap texture_extent_map;
 WriteStats sound_sample_stats = {};
@@ -626,6 +1116,12 @@ WriteStats music_clip_stats = {};
 std::vector<ExportSoundPair> sound_sample_pairs;
 std::vector<ExportSoundPair> music_clip_pairs;
 std::vector<std::string> asset_output_strs;
+std::vector<ExportJob> export_jobs;
+std::string manifest_filename = std::string( arguments->output_binary_folder.str ) + "/" + CACHE_MANIFEST_FILENAME;
+std::string previous_filename = std::string( arguments->output_binary.str ) + CACHE_PREVIOUS_SUFFIX;
+cJSON *manifest = NULL;
+AssetFileReader previous_file = {};
+bool has_previous_file = false;
 std::ostringstream os_asset_binary;
 std::ostringstream os_sound_details;
 std::ostringstream os_music_details;
@@ -655,6 +1151,19 @@ if( asset_ids.empty() )
 
 std::sort( asset_ids.begin(), asset_ids.end() );
 create_dir( arguments->output_binary_folder.str );
+
+/* keep the last pack around so unchanged assets can be copied out of it */
+if( !arguments->clean_build.is_valid )
+    {
+    manifest = load_cache_manifest( manifest_filename.c_str() );
+    }
+
+remove( previous_filename.c_str() );
+if( manifest
+ && rename( arguments->output_binary.str, previous_filename.c_str() ) == 0 )
+    {
+    has_previous_file = AssetFile_OpenForReadMapped( previous_filename.c_str(), &previous_file );
+    }
 if( !AssetFile_CreateForWrite( arguments->output_binary.str, &asset_ids[ 0 ], (uint32_t)asset_ids.size(), &output_file ) )
     {
     std::string curr_dir = get_current_dir_str();
@@ -662,60 +1171,83 @@ if( !AssetFile_CreateForWrite( arguments->output_binary.str, &asset_ids[ 0 ], (u
     goto error_cleanup;
     }
 
+if( arguments->compress.is_valid )
+    {
+    AssetFile_SetCompression( ASSET_FILE_CODEC_LZ, &output_file );
+    }
+
 visitor.ExtractTextureMap( &texture_map );
 for( auto &entry : visitor.asset_map )
     {
-    WriteStats this_stats = {};
     switch( entry.second.kind )
         {
-        case ASSET_FILE_ASSET_KIND_FONT:
-            this_stats = {};
-            if( !ExportFont_Export( entry.first, entry.second.asset_id_str.c_str(), entry.second.filename.c_str(), entry.second.font_point_sz, entry.second.font_glyphs.c_str(), this_stats, asset_output_strs, &output_file) )
-                {
-                print_error( "Failed to load font (%s).  Exiting...", entry.second.filename.c_str() );
-                goto error_cleanup;
-                }
+        case ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP:
+            music_clip_pairs.push_back( { entry.second.filename.c_str(), entry.second.asset_id_str.c_str() });
+            break;
 
-            fonts_stats.fonts_written++;
-            fonts_stats.written_sz += this_stats.written_sz;
+        case ASSET_FILE_ASSET_KIND_SOUND_SAMPLE:
+            sound_sample_pairs.push_back( { entry.second.filename.c_str(), entry.second.asset_id_str.c_str() } );
             break;
 
-        case ASSET_FILE_ASSET_KIND_MODEL:
-            this_stats = {};
-            if( !ExportModel_Export( entry.first, entry.second.filename.c_str(), &texture_map, &this_stats, asset_output_strs, &output_file ) )
-                {
-                print_error( "Failed to load model (%s).  Exiting...", entry.second.filename.c_str() );
-                goto error_cleanup;
-                }
+        default:
+            export_jobs.push_back( {} );
+            export_jobs.back().id         = entry.first;
+            export_jobs.back().descriptor = &entry.second;
+            break;
+        }
+    }
+
+/* export in table order, so the pack layout does not depend on thread timing */
+std::sort( export_jobs.begin(), export_jobs.end(), []( const ExportJob &a, const ExportJob &b ){ return( a.id < b.id ); } );
+resolve_cached_jobs( export_jobs, &texture_map, output_file.codec, has_previous_file ? manifest : NULL, has_previous_file ? &previous_file : NULL );
+
+if( arguments->job_count.is_valid )
+    {
+    thread_count = (unsigned int)atoi( arguments->job_count.str );
+    if( thread_count == 0 )
+        {
+        thread_count = std::max( std::thread::hardware_concurrency(), 1u );
+        }
+    }
+
+if( !export_assets( export_jobs, thread_count, &texture_map, &previous_file, &output_file ) )
+    {
+    AssetFile_CloseForWrite( &output_file );
+    goto error_cleanup;
+    }
 
-            models_stats.models_written++;
-            models_stats.written_sz += this_stats.written_sz;
+for( ExportJob &job : export_jobs )
+    {
+    fonts_stats.fonts_written       += job.stats.fonts_written;
+    models_stats.models_written     += job.stats.models_written;
+    textures_stats.textures_written += job.stats.textures_written;
+    terrains_stats.terrains_written += job.stats.terrains_written;
+    dedup_stats.assets_deduplicated += job.stats.assets_deduplicated;
+    dedup_stats.deduplicated_sz     += job.stats.deduplicated_sz;
+    switch( job.descriptor->kind )
+        {
+        case ASSET_FILE_ASSET_KIND_FONT:
+            fonts_stats.written_sz += job.stats.written_sz;
             break;
 
-        case ASSET_FILE_ASSET_KIND_SOUND_MUSIC_CLIP:
-            music_clip_pairs.push_back( { entry.second.filename.c_str(), entry.second.asset_id_str.c_str() });
+        case ASSET_FILE_ASSET_KIND_MODEL:
+            models_stats.written_sz += job.stats.written_sz;
             break;
 
-        case ASSET_FILE_ASSET_KIND_SOUND_SAMPLE:
-            sound_sample_pairs.push_back( { entry.second.filename.c_str(), entry.second.asset_id_str.c_str() } );
+        case ASSET_FILE_ASSET_KIND_TERRAIN:
+            terrains_stats.written_sz += job.stats.written_sz;
             break;
 
         case ASSET_FILE_ASSET_KIND_TEXTURE:
-            this_stats = {};
-            if( !ExportTexture_Export( entry.first, entry.second.filename.c_str(), texture_extent_map, &this_stats, asset_output_strs, &output_file ) )
-                {
-                print_error( "Failed to load texture (%s).  Exiting...", entry.second.filename.c_str() );
-                }
-
-            textures_stats.textures_written++;
-            textures_stats.written_sz += this_stats.written_sz;
+            textures_stats.written_sz += job.stats.written_sz;
             break;
 
         default:
-            print_warning( "Encountered unknown asset kind (%d).  Ignoring...", entry.second.kind );
             break;
         }
 
+    texture_extent_map.insert( job.extent_map.begin(), job.extent_map.end() );
+    asset_output_strs.insert( asset_output_strs.end(), job.out_strs.begin(), job.out_strs.end() );
     }
 
 if( sound_sample_pairs.size()
@@ -733,6 +1265,12 @@ for( auto &asset_output_str : asset_output_strs )
 success = ExportTexture_WriteTextureExtents( texture_extent_map, &output_file );
 
 success = AssetFile_CloseForWrite( &output_file );
+if( success
+ && !save_cache_manifest( manifest_filename.c_str(), export_jobs ) )
+    {
+    print_warning( "Could not write the build cache manifest (%s).", manifest_filename.c_str() );
+    }
+
 printf( "\n" );
 
 #define FILENAME_COLUMN_WIDTH "18"
@@ -741,6 +1279,15 @@ printf( "\n" );
 os_asset_binary         << (int)models_stats.models_written     << " Models (" << std::fixed << std::setprecision( 1 ) << (float)models_stats.written_sz / (1024 * 1024) << " MB)"
                 << ", " << (int)textures_stats.textures_written << " Textures (" << std::fixed << std::setprecision( 1 ) << (int)textures_stats.written_sz / (1024 * 1024) << " MB)"
                 << ", " << (int)fonts_stats.fonts_written       << " Fonts ("    << std::fixed << std::setprecision( 1 ) << (int)fonts_stats.written_sz / 1024 << " kB)";
+if( terrains_stats.terrains_written )
+    {
+    os_asset_binary << ", " << (int)terrains_stats.terrains_written << " Terrains (" << std::fixed << std::setprecision( 1 ) << (float)terrains_stats.written_sz / (1024 * 1024) << " MB)";
+    }
+if( dedup_stats.assets_deduplicated )
+    {
+    os_asset_binary << ", " << (int)dedup_stats.assets_deduplicated << " Shared (" << std::fixed << std::setprecision( 1 ) << (float)dedup_stats.deduplicated_sz / (1024 * 1024) << " MB saved)";
+    }
+
 print_info( FORMAT_STRING, "<" ASSET_FILE_BINARY_FILENAME ">", os_asset_binary.str().c_str() );
 
 os_sound_details << (int)sound_sample_stats.sound_samples_written << " Samples (" << std::fixed << std::setprecision( 1 ) << (float)sound_sample_stats.written_sz / (1024 * 1024) << " MB)";
@@ -750,6 +1297,13 @@ os_music_details << (int)music_clip_stats.music_clips_written << " Clips (" << s
 print_info( FORMAT_STRING, "<" ASSET_FILE_MUSIC_BANK_FILENAME ">", os_music_details.str().c_str() );
 
 error_cleanup:
+if( has_previous_file )
+    {
+    AssetFile_CloseForRead( &previous_file );
+    }
+
+remove( previous_filename.c_str() );
+cJSON_Delete( manifest );
 cJSON_Delete( json );
 
 return( success );
@@ -784,6 +1338,277 @@ return( size_read == sz );
 } /* read_json_as_string() */
 
 
+/*******************************************************************
+*
+*   resolve_cached_jobs()
+*
+*   DESCRIPTION:
+*       Hash each job's source and options, and mark the jobs whose
+*       previous output can be reused.  The source is only re-read
+*       when its size or write time has changed since the last run.
+*
+*******************************************************************/
+
+static void resolve_cached_jobs( std::vector<ExportJob> &jobs, const std::unordered_map<std::string, AssetFileAssetId> *texture_map, const AssetFileCodec codec, const cJSON *manifest, AssetFileReader *previous )
+{
+/* models reference textures by asset ID, so their output depends on the texture map */
+std::vector<std::pair<std::string, AssetFileAssetId>> sorted_textures( texture_map->begin(), texture_map->end() );
+std::sort( sorted_textures.begin(), sorted_textures.end() );
+
+uint64_t texture_map_hash = 0xcbf29ce484222325ull;
+for( auto &texture : sorted_textures )
+    {
+    texture_map_hash = hash_bytes( texture.first.c_str(), texture.first.size() + 1, texture_map_hash );
+    texture_map_hash = hash_bytes( &texture.second, sizeof( texture.second ), texture_map_hash );
+    }
+
+const cJSON *assets = cJSON_GetObjectItemCaseSensitive( manifest, "assets" );
+for( ExportJob &job : jobs )
+    {
+    const DefinitionVisitor::AssetDescriptor *descriptor = job.descriptor;
+    uint32_t version = 0;
+    job.params_hash = 0xcbf29ce484222325ull;
+    switch( descriptor->kind )
+        {
+        case ASSET_FILE_ASSET_KIND_FONT:
+            version = EXPORT_FONT_VERSION;
+            job.params_hash = hash_bytes( &descriptor->font_point_sz, sizeof( descriptor->font_point_sz ), job.params_hash );
+            job.params_hash = hash_bytes( descriptor->font_glyphs.c_str(), descriptor->font_glyphs.size(), job.params_hash );
+            break;
+
+        case ASSET_FILE_ASSET_KIND_MODEL:
+            version = EXPORT_MODEL_VERSION;
+            job.params_hash = hash_bytes( &texture_map_hash, sizeof( texture_map_hash ), job.params_hash );
+            job.params_hash = hash_bytes( &descriptor->model_options.optimize, sizeof( descriptor->model_options.optimize ), job.params_hash );
+            job.params_hash = hash_bytes( &descriptor->model_options.vertex_format, sizeof( descriptor->model_options.vertex_format ), job.params_hash );
+            job.params_hash = hash_bytes( &descriptor->model_options.meshlets, sizeof( descriptor->model_options.meshlets ), job.params_hash );
+            job.params_hash = hash_bytes( descriptor->model_options.lod_ratios.data(), descriptor->model_options.lod_ratios.size() * sizeof( float ), job.params_hash );
+            break;
+
+        case ASSET_FILE_ASSET_KIND_TERRAIN:
+            version = EXPORT_TERRAIN_VERSION;
+            job.params_hash = hash_bytes( &descriptor->terrain_options.width, sizeof( descriptor->terrain_options.width ), job.params_hash );
+            job.params_hash = hash_bytes( &descriptor->terrain_options.height, sizeof( descriptor->terrain_options.height ), job.params_hash );
+            break;
+
+        case ASSET_FILE_ASSET_KIND_TEXTURE:
+            version = EXPORT_TEXTURE_VERSION;
+            job.params_hash = hash_bytes( &descriptor->texture_format, sizeof( descriptor->texture_format ), job.params_hash );
+            job.params_hash = hash_bytes( &descriptor->texture_has_mips, sizeof( descriptor->texture_has_mips ), job.params_hash );
+            job.params_hash = hash_bytes( &descriptor->texture_is_srgb, sizeof( descriptor->texture_is_srgb ), job.params_hash );
+            break;
+
+        default:
+            break;
+        }
+
+    job.params_hash = hash_bytes( &descriptor->kind, sizeof( descriptor->kind ), job.params_hash );
+    job.params_hash = hash_bytes( &version, sizeof( version ), job.params_hash );
+    job.params_hash = hash_bytes( &codec, sizeof( codec ), job.params_hash );
+
+    job.source_info = {};
+    job.source_hash = 0;
+    if( !get_file_info( descriptor->filename.c_str(), &job.source_info ) )
+        {
+        continue;
+        }
+
+    /* find the previous run's record of this asset */
+    char key[ 32 ];
+    snprintf( key, sizeof( key ), "%08x", (unsigned int)job.id );
+    const cJSON *entry = cJSON_GetObjectItemCaseSensitive( assets, key );
+    const cJSON *path = cJSON_GetObjectItemCaseSensitive( entry, "path" );
+    const cJSON *size = cJSON_GetObjectItemCaseSensitive( entry, "size" );
+    const cJSON *modified_time = cJSON_GetObjectItemCaseSensitive( entry, "modified_time" );
+    const cJSON *hash = cJSON_GetObjectItemCaseSensitive( entry, "hash" );
+    const cJSON *params = cJSON_GetObjectItemCaseSensitive( entry, "params" );
+
+    bool is_candidate = cJSON_IsString( path )
+                     && cJSON_IsString( size )
+                     && cJSON_IsString( modified_time )
+                     && cJSON_IsString( hash )
+                     && cJSON_IsString( params )
+                     && descriptor->filename == path->valuestring
+                     && job.params_hash == strtoull( params->valuestring, NULL, 16 )
+                     && AssetFile_BeginReadingAsset( job.id, descriptor->kind, previous );
+    if( is_candidate )
+        {
+        AssetFile_EndReadingAsset( previous );
+        }
+
+    if( is_candidate
+     && job.source_info.size == strtoull( size->valuestring, NULL, 16 )
+     && job.source_info.modified_time == strtoull( modified_time->valuestring, NULL, 16 ) )
+        {
+        job.source_hash = strtoull( hash->valuestring, NULL, 16 );
+        job.is_cached = true;
+        continue;
+        }
+
+    if( !hash_file( descriptor->filename.c_str(), &job.source_hash ) )
+        {
+        job.source_hash = 0;
+        continue;
+        }
+
+    job.is_cached = is_candidate
+                 && job.source_hash == strtoull( hash->valuestring, NULL, 16 );
+    }
+
+} /* resolve_cached_jobs() */
+
+
+/*******************************************************************
+*
+*   reuse_asset()
+*
+*   DESCRIPTION:
+*       Copy a job's asset out of the previous pack, instead of
+*       exporting it again.
+*
+*******************************************************************/
+
+static bool reuse_asset( ExportJob *job, AssetFileReader *previous, AssetFileWriter *output )
+{
+const DefinitionVisitor::AssetDescriptor *descriptor = job->descriptor;
+job->stats = {};
+
+uint64_t write_start_size = AssetFile_GetLogicalWriteSize( output );
+if( !AssetFile_CopyAsset( job->id, previous, output ) )
+    {
+    print_error( "Failed to reuse cached asset (%s).  Exiting...", descriptor->filename.c_str() );
+    return( false );
+    }
+
+job->stats.written_sz = (size_t)( AssetFile_GetLogicalWriteSize( output ) - write_start_size );
+
+const char *kind_str = "";
+switch( descriptor->kind )
+    {
+    case ASSET_FILE_ASSET_KIND_FONT:
+        kind_str = "[FONT]";
+        job->stats.fonts_written++;
+        break;
+
+    case ASSET_FILE_ASSET_KIND_MODEL:
+        kind_str = "[MODEL]";
+        job->stats.models_written++;
+        break;
+
+    case ASSET_FILE_ASSET_KIND_TERRAIN:
+        kind_str = "[TERRAIN]";
+        job->stats.terrains_written++;
+        break;
+
+    case ASSET_FILE_ASSET_KIND_TEXTURE:
+        {
+        /* the extents table is always rebuilt, so recover this texture's size */
+        kind_str = "[TEXTURE]";
+        job->stats.textures_written++;
+
+        u32 channel_cnt = 0;
+        u32 channel_width = 0;
+        u32 width = 0;
+        u32 height = 0;
+        u32 byte_count = 0;
+        if( !AssetFile_BeginReadingAsset( job->id, ASSET_FILE_ASSET_KIND_TEXTURE, previous )
+         || !AssetFile_ReadTextureStorageRequirements( &channel_cnt, &channel_width, &width, &height, &byte_count, previous ) )
+            {
+            print_error( "Failed to read cached texture (%s).  Exiting...", descriptor->filename.c_str() );
+            return( false );
+            }
+
+        AssetFile_EndReadingAsset( previous );
+        job->extent_map[ job->id ] = { (uint16_t)width, (uint16_t)height };
+        }
+        break;
+
+    default:
+        break;
+    }
+
+std::ostringstream os;
+os << "cached, " << (int)job->stats.written_sz << " bytes";
+job->out_strs.push_back( sprint_info( ASSET_STR_FORMAT_STRING, kind_str, strip_filename( descriptor->filename.c_str() ).c_str(), os.str().c_str() ) );
+
+return( true );
+
+} /* reuse_asset() */
+
+
+/*******************************************************************
+*
+*   save_cache_manifest()
+*
+*   DESCRIPTION:
+*       Record what each exported asset was built from, so the next
+*       run can tell which assets are unchanged.
+*
+*******************************************************************/
+
+static bool save_cache_manifest( const char *filename, const std::vector<ExportJob> &jobs )
+{
+cJSON *manifest = cJSON_CreateObject();
+cJSON *assets = cJSON_CreateObject();
+if( !manifest
+ || !assets )
+    {
+    cJSON_Delete( manifest );
+    cJSON_Delete( assets );
+    return( false );
+    }
+
+cJSON_AddNumberToObject( manifest, "version", CACHE_MANIFEST_VERSION );
+cJSON_AddItemToObject( manifest, "assets", assets );
+
+for( const ExportJob &job : jobs )
+    {
+    if( !job.success
+     || job.source_hash == 0 )
+        {
+        continue;
+        }
+
+    char key[ 32 ];
+    char value[ 32 ];
+    snprintf( key, sizeof( key ), "%08x", (unsigned int)job.id );
+
+    cJSON *entry = cJSON_CreateObject();
+    cJSON_AddStringToObject( entry, "path", job.descriptor->filename.c_str() );
+    snprintf( value, sizeof( value ), "%016llx", (unsigned long long)job.source_info.size );
+    cJSON_AddStringToObject( entry, "size", value );
+    snprintf( value, sizeof( value ), "%016llx", (unsigned long long)job.source_info.modified_time );
+    cJSON_AddStringToObject( entry, "modified_time", value );
+    snprintf( value, sizeof( value ), "%016llx", (unsigned long long)job.source_hash );
+    cJSON_AddStringToObject( entry, "hash", value );
+    snprintf( value, sizeof( value ), "%016llx", (unsigned long long)job.params_hash );
+    cJSON_AddStringToObject( entry, "params", value );
+    cJSON_AddItemToObject( assets, key, entry );
+    }
+
+char *json_string = cJSON_Print( manifest );
+cJSON_Delete( manifest );
+if( !json_string )
+    {
+    return( false );
+    }
+
+FILE *fhnd = fopen( filename, "wb" );
+bool ret = fhnd
+        && fputs( json_string, fhnd ) >= 0;
+
+if( fhnd )
+    {
+    ret = ( fclose( fhnd ) == 0 ) && ret;
+    }
+
+cJSON_free( json_string );
+
+return( ret );
+
+} /* save_cache_manifest() */
+
+
 /*******************************************************************
 *
 *   visit_all_definition_assets()
@@ -871,6 +1696,10 @@ if( models )
         {
         const cJSON *model_filename = cJSON_GetObjectItemCaseSensitive( model, "filename" );
         const cJSON *model_asset_id = cJSON_GetObjectItemCaseSensitive( model, "assetid" );
+        const cJSON *model_optimize = cJSON_GetObjectItemCaseSensitive( model, "optimize" );
+        const cJSON *model_vertex_format = cJSON_GetObjectItemCaseSensitive( model, "vertex_format" );
+        const cJSON *model_meshlets = cJSON_GetObjectItemCaseSensitive( model, "meshlets" );
+        const cJSON *model_lods = cJSON_GetObjectItemCaseSensitive( model, "lods" );
 
         if( !model_filename
          || !cJSON_IsString( model_filename ) )
@@ -884,6 +1713,54 @@ if( models )
             print_error( "Could not find asset ID for model (%s)", cJSON_Print( model ) );
             return( false );
             }
+        else if( model_optimize
+              && !cJSON_IsBool( model_optimize ) )
+            {
+            print_error( "Model optimize option must be true or false (%s)", cJSON_Print( model ) );
+            return( false );
+            }
+        else if( model_meshlets
+              && !cJSON_IsBool( model_meshlets ) )
+            {
+            print_error( "Model meshlets option must be true or false (%s)", cJSON_Print( model ) );
+            return( false );
+            }
+
+        ExportModelOptions options = {};
+        if( model_vertex_format
+         && ( !cJSON_IsString( model_vertex_format )
+           || !ExportModel_ParseVertexFormat( model_vertex_format->valuestring, &options.vertex_format ) ) )
+            {
+            print_error( "Unknown vertex format for model, expected f32 or packed (%s)", cJSON_Print( model ) );
+            return( false );
+            }
+
+        if( model_lods )
+            {
+            /* triangle ratios, coarsening with each level */
+            const cJSON *model_lod = NULL;
+            float previous_ratio = 1.0f;
+            cJSON_ArrayForEach( model_lod, model_lods )
+                {
+                if( !cJSON_IsNumber( model_lod )
+                 || model_lod->valuedouble <= 0.0
+                 || (float)model_lod->valuedouble >= previous_ratio
+                 || options.lod_ratios.size() >= ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT )
+                    {
+                    break;
+                    }
+
+                previous_ratio = (float)model_lod->valuedouble;
+                options.lod_ratios.push_back( previous_ratio );
+                }
+
+            if( !cJSON_IsArray( model_lods )
+             || options.lod_ratios.size() != (size_t)cJSON_GetArraySize( model_lods ) )
+                {
+                print_error( "Model lods must be at most %d decreasing ratios between 0 and 1 (%s)", (int)ASSET_FILE_MODEL_MESH_LOD_MAX_COUNT, cJSON_Print( model ) );
+                return( false );
+                }
+            }
       
         std::string model_filename_str( basefolder );
         model_filename_str.append( model_filename->valuestring );
@@ -893,9 +1770,12 @@ if( models )
             return( false );
             }
 
+        options.optimize = !cJSON_IsFalse( model_optimize );
+        options.meshlets = cJSON_IsTrue( model_meshlets );
+
         std::ostringstream os;
         os << "mdl/" << model_asset_id->valuestring;
-        visitor->VisitModel( os.str().c_str(), model_filename_str.c_str() );
+        visitor->VisitModel( os.str().c_str(), model_filename_str.c_str(), options );
         }
 
     }
@@ -983,6 +1863,9 @@ if( textures )
         {
         const cJSON *texture_filename = cJSON_GetObjectItemCaseSensitive( texture, "filename" );
         const cJSON *texture_asset_id = cJSON_GetObjectItemCaseSensitive( texture, "assetid" );
+        const cJSON *texture_format = cJSON_GetObjectItemCaseSensitive( texture, "format" );
+        const cJSON *texture_mips = cJSON_GetObjectItemCaseSensitive( texture, "mips" );
+        const cJSON *texture_srgb = cJSON_GetObjectItemCaseSensitive( texture, "srgb" );
 
         if( !texture_filename
          || !cJSON_IsString( texture_filename ) )
@@ -996,6 +1879,21 @@ if( textures )
             print_error( "Could not find asset ID for texture (%s)", cJSON_Print( texture ) );
             return( false );
             }
+
+        AssetFileTextureFormat format = ASSET_FILE_TEXTURE_FORMAT_RAW;
+        if( texture_format
+         && ( !cJSON_IsString( texture_format )
+           || !ExportTexture_ParseFormat( texture_format->valuestring, &format ) ) )
+            {
+            print_error( "Unknown format for texture, expected raw, bc1, bc3, bc4, bc5 or bc7 (%s)", cJSON_Print( texture ) );
+            return( false );
+            }
+        else if( ( texture_mips && !cJSON_IsBool( texture_mips ) )
+              || ( texture_srgb && !cJSON_IsBool( texture_srgb ) ) )
+            {
+            print_error( "Texture mips and srgb options must be true or false (%s)", cJSON_Print( texture ) );
+            return( false );
+            }
       
         std::string texture_filename_str( basefolder );
         texture_filename_str.append( texture_filename->valuestring );
@@ -1007,7 +1905,72 @@ if( textures )
 
         std::ostringstream os;
         os << "tex/" << texture_asset_id->valuestring;
-        visitor->VisitTexture( os.str().c_str(), texture_filename_str.c_str());
+        visitor->VisitTexture( os.str().c_str(), texture_filename_str.c_str(), format, !cJSON_IsFalse( texture_mips ), !cJSON_IsFalse( texture_srgb ) );
+        }
+
+    }
+
+/* Terrains */
+const cJSON *terrains = cJSON_GetObjectItemCaseSensitive( assets, "terrain" );
+if( terrains )
+    {
+    std::string basefolder( asset_folder );
+    basefolder.append( "/" );
+
+    const cJSON *folder_object = cJSON_GetObjectItemCaseSensitive( terrains, "basefolder" );
+    if( cJSON_IsString( folder_object ) )
+        {
+        basefolder.append( folder_object->valuestring );
+        basefolder.append( "/" );
+        }
+
+    const cJSON *terrain_list = cJSON_GetObjectItemCaseSensitive( terrains, "list" );
+    const cJSON *terrain = NULL;
+    cJSON_ArrayForEach( terrain, terrain_list )
+        {
+        const cJSON *terrain_filename = cJSON_GetObjectItemCaseSensitive( terrain, "filename" );
+        const cJSON *terrain_asset_id = cJSON_GetObjectItemCaseSensitive( terrain, "assetid" );
+        const cJSON *terrain_width = cJSON_GetObjectItemCaseSensitive( terrain, "width" );
+        const cJSON *terrain_height = cJSON_GetObjectItemCaseSensitive( terrain, "height" );
+
+        if( !terrain_filename
+         || !cJSON_IsString( terrain_filename ) )
+            {
+            print_error( "Could not find filename for terrain (%s).", cJSON_Print( terrain ) );
+            return( false );
+            }
+        else if( !terrain_asset_id
+              || !cJSON_IsString( terrain_asset_id ) )
+            {
+            print_error( "Could not find asset ID for terrain (%s)", cJSON_Print( terrain ) );
+            return( false );
+            }
+        else if( !cJSON_IsNumber( terrain_width )
+              || !cJSON_IsNumber( terrain_height )
+              || terrain_width->valuedouble < 1.0
+              || terrain_height->valuedouble < 1.0
+              || terrain_width->valuedouble > (double)UINT32_MAX
+              || terrain_height->valuedouble > (double)UINT32_MAX )
+            {
+            print_error( "Terrain needs the width and height of its raw 16-bit heightmap (%s)", cJSON_Print( terrain ) );
+            return( false );
+            }
+
+        std::string terrain_filename_str( basefolder );
+        terrain_filename_str.append( terrain_filename->valuestring );
+        if( !does_file_exist( terrain_filename_str.c_str() ) )
+            {
+            print_error( "Could not find terrain for filename %s (%s)", terrain_filename_str.c_str(), cJSON_Print( terrain ) );
+            return( false );
+            }
+
+        ExportTerrainOptions options = {};
+        options.width  = (uint32_t)terrain_width->valuedouble;
+        options.height = (uint32_t)terrain_height->valuedouble;
+
+        std::ostringstream os;
+        os << "ter/" << terrain_asset_id->valuestring;
+        visitor->VisitTerrain( os.str().c_str(), terrain_filename_str.c_str(), options );
         }
 
     }
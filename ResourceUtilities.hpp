@@ -19,10 +19,22 @@ typedef struct _WriteStats
     uint32_t            nodes_written;
     uint32_t            shaders_written;
     uint32_t            textures_written;
+    uint32_t            terrains_written;
     uint32_t            sound_samples_written;
     uint32_t            music_clips_written;
+    uint32_t            assets_deduplicated;
+                                    /* assets sharing a payload     */
+    size_t              deduplicated_sz;
+                                    /* bytes saved by sharing       */
     } WriteStats;
 
+typedef struct _FileInfo
+    {
+    uint64_t            size;       /* file byte size               */
+    uint64_t            modified_time;
+                                    /* platform last write timestamp*/
+    } FileInfo;
+
 
 #define ASSET_STR_KIND_COLUMN_WIDTH "16"
 #define ASSET_STR_FILENAME_COLUMN_WIDTH "25"
@@ -371,4 +383,5 @@ return( false );
 
 void create_dir( const char *name );
 bool does_file_exist( const char *filename );
-std::string get_current_dir_str();
\ No newline at end of file
+std::string get_current_dir_str();
+bool get_file_info( const char *filename, FileInfo *info );
\ No newline at end of file
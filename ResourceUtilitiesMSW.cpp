@@ -102,3 +102,28 @@ GetCurrentDirectoryA( (DWORD)ret.capacity(), ret.data() );
 return( ret );
 
 } /* get_current_dir_str() */
+
+
+/*******************************************************************
+*
+*   get_file_info()
+*
+*   DESCRIPTION:
+*       Query the size and last write time of the given file.
+*
+*******************************************************************/
+
+bool get_file_info( const char *filename, FileInfo *info )
+{
+WIN32_FILE_ATTRIBUTE_DATA data = {};
+if( !GetFileAttributesExA( filename, GetFileExInfoStandard, &data ) )
+    {
+    return( false );
+    }
+
+info->size          = ( (uint64_t)data.nFileSizeHigh << 32 ) | data.nFileSizeLow;
+info->modified_time = ( (uint64_t)data.ftLastWriteTime.dwHighDateTime << 32 ) | data.ftLastWriteTime.dwLowDateTime;
+
+return( true );
+
+} /* get_file_info() */
@@ -2,6 +2,8 @@
 
 #import <Foundation/Foundation.h>
 
+#include "ResourceUtilities.hpp"
+
 
 /*******************************************************************
 *
@@ -59,4 +61,31 @@ NSString *cwd = [ manager currentDirectoryPath ];
 std::string ret = std::string( [ cwd UTF8String] );
 return( ret );
 
-} /* get_current_dir_str() */
\ No newline at end of file
+} /* get_current_dir_str() */
+
+
+/*******************************************************************
+*
+*   get_file_info()
+*
+*   DESCRIPTION:
+*       Query the size and last write time of the given file.
+*
+*******************************************************************/
+
+bool get_file_info( const char *filename, FileInfo *info )
+{
+NSFileManager *manager = [ NSFileManager defaultManager ];
+NSString *ns_filename = [ NSString stringWithUTF8String:filename ];
+NSDictionary *attributes = [ manager attributesOfItemAtPath:ns_filename error:nil ];
+if( !attributes )
+    {
+    return( false );
+    }
+
+info->size          = (uint64_t)[ attributes fileSize ];
+info->modified_time = (uint64_t)( [ [ attributes fileModificationDate ] timeIntervalSince1970 ] * 1000000.0 );
+
+return( true );
+
+} /* get_file_info() */
\ No newline at end of file